@@ -0,0 +1,30 @@
+import io
+
+import numpy as np
+
+
+def copy_text(columns, fmt):
+    """
+    Formate des colonnes NumPy au format texte de COPY (une ligne par entrée,
+    champs séparés par des tabulations). Les valeurs ne doivent contenir ni
+    tabulation, ni retour à la ligne, ni antislash.
+    """
+    buffer = io.StringIO()
+    np.savetxt(buffer, np.rec.fromarrays(columns), fmt=fmt, delimiter="\t")
+    buffer.seek(0)
+    return buffer
+
+
+def copy_columns(cursor, table, columns, fmt):
+    """
+    Insère des colonnes dans une table avec le protocole COPY de Postgres
+    (une seule requête, sans objet Python par ligne côté SQLAlchemy).
+
+    columns : dict {nom de colonne: tableau NumPy}, toutes de même longueur
+    fmt : liste des formats printf, un par colonne
+    """
+    names = ", ".join(columns)
+    cursor.copy_expert(
+        f"COPY {table} ({names}) FROM STDIN",
+        copy_text(list(columns.values()), fmt),
+    )
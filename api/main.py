@@ -1,11 +1,91 @@
-from fastapi import FastAPI
-from .database import engine, Base
+import math
+import os
+from typing import List
+
+from fastapi import Depends, FastAPI, HTTPException
+from pydantic import BaseModel
+from sqlalchemy.orm import Session
+
+from .database import engine, Base, get_db
 from . import models
 
-models.Base.create_all(bind=engine)
+models.Base.metadata.create_all(bind=engine)
 
 app = FastAPI(title="Shield-Lite API")
 
+# Modèle de substitution exporté par ml/surrogate.py (optionnel)
+SURROGATE_PATH = os.getenv("SURROGATE_PATH")
+surrogate = None
+if SURROGATE_PATH:
+    from shield_lite.core.surrogate import SurrogateModel
+    surrogate = SurrogateModel.load(SURROGATE_PATH)
+
+
+class LayerRequest(BaseModel):
+    material: str
+    thickness_cm: float
+
+
+class TransmissionRequest(BaseModel):
+    energy_mev: float
+    layers: List[LayerRequest]
+    max_uncertainty: float = 0.05  # Au-delà, un vrai run Monte Carlo est lancé
+    photons: int = 20000           # Histoires du run de repli
+
+
+def store_fallback(db: Session, fallback):
+    """Enregistre les runs Monte Carlo de repli : ils enrichissent le jeu d'entraînement."""
+    offsets = fallback["layer_offsets"]
+    for c, result in enumerate(fallback["results"]):
+        layers = range(offsets[c], offsets[c + 1])
+        db.add(models.Simulation(
+            energy_mev=float(fallback["energy_MeV"][c]),
+            photons=int(result["total_photons"]),
+            transmission=float(result["transmission_factor"]),
+            buildup_factor=float(result["buildup_factor"]),
+            dose_transmitted=float(result["dose_transmitted"]),
+            uncertainty=float(result["uncertainty"]),
+            layers=[
+                models.SimulationLayer(
+                    order_index=order,
+                    material=str(fallback["material_names"][i]),
+                    thickness_cm=float(fallback["thickness_cm"][i]),
+                    density=surrogate.materials[str(fallback["material_names"][i])]["density_g_cm3"],
+                )
+                for order, i in enumerate(layers)
+            ],
+        ))
+    db.commit()
+
+
 @app.get("/")
 def read_root():
-    return {"message": "Base et tables crées"}
\ No newline at end of file
+    return {"message": "Base et tables crées"}
+
+
+@app.post("/transmission")
+def transmission(request: TransmissionRequest, db: Session = Depends(get_db)):
+    if surrogate is None:
+        raise HTTPException(status_code=503, detail="Aucun modèle de substitution (SURROGATE_PATH)")
+    fallbacks = []
+    try:
+        estimate = surrogate.estimate(
+            request.energy_mev, [0, len(request.layers)],
+            [layer.material for layer in request.layers],
+            [layer.thickness_cm for layer in request.layers],
+            max_uncertainty=request.max_uncertainty, num_photons=request.photons,
+            on_fallback=fallbacks.append,
+        )
+    except ValueError as e:
+        raise HTTPException(status_code=422, detail=str(e))
+    for fallback in fallbacks:
+        store_fallback(db, fallback)
+
+    fallback = bool(estimate["fallback"][0])
+    uncertainty = float(estimate["relative_uncertainty"][0])
+    return {
+        "transmission": float(estimate["transmission"][0]),
+        # Infinie si aucun photon n'a traversé le blindage
+        "relative_uncertainty": uncertainty if math.isfinite(uncertainty) else None,
+        "source": "monte_carlo" if fallback else "surrogate",
+    }
@@ -0,0 +1,101 @@
+import json
+import os
+
+import numpy as np
+
+# Mapping des matériaux vers des entiers (Tokenization), 0 = couche de padding
+MATERIAL_MAP = {"Lead": 1, "Concrete": 2, "Steel": 3, "Water": 4}
+MAX_LAYERS = 5  # On paddera avec des 0 si moins de couches
+
+# Format sur disque : un dossier de fichiers .npy (projetables en mémoire)
+#   energy.npy   float32 (N,)
+#   sequence.npy float32 (N, MAX_LAYERS, 2) : [token du matériau, épaisseur en cm]
+#   target.npy   float32 (N,)                : facteur de transmission
+#   meta.json    nombre d'échantillons écrits, propriétés des matériaux
+COLUMNS = {
+    "energy": (),
+    "sequence": (MAX_LAYERS, 2),
+    "target": (),
+}
+
+
+class ColumnarWriter:
+    """Écrit un jeu de données colonne par colonne, bloc par bloc."""
+
+    def __init__(self, path, capacity, materials=None):
+        os.makedirs(path, exist_ok=True)
+        self.path = path
+        self.materials = materials
+        self.count = 0
+        # Fichiers créés à zéro : les couches absentes restent du padding
+        self.columns = {
+            name: np.lib.format.open_memmap(os.path.join(path, f"{name}.npy"), mode="w+",
+                                             dtype=np.float32, shape=(capacity,) + shape)
+            for name, shape in COLUMNS.items()
+        }
+
+    def append(self, energies, layer_offsets, tokens, thicknesses, targets):
+        """
+        Ajoute un bloc de configurations empaquetées comme pour run_batch :
+        la configuration c utilise les couches layer_offsets[c]:layer_offsets[c + 1].
+        """
+        n = len(energies)
+        n_layers = np.diff(layer_offsets)
+        if n_layers.max(initial=0) > MAX_LAYERS:
+            raise ValueError(f"At most {MAX_LAYERS} layers per configuration")
+        rows = self.count + np.repeat(np.arange(n), n_layers)
+        slots = np.arange(layer_offsets[-1]) - np.repeat(layer_offsets[:-1], n_layers)
+
+        end = self.count + n
+        self.columns["energy"][self.count:end] = energies
+        self.columns["target"][self.count:end] = targets
+        self.columns["sequence"][rows, slots, 0] = tokens
+        self.columns["sequence"][rows, slots, 1] = thicknesses
+        self.count = end
+
+    def close(self):
+        for column in self.columns.values():
+            column.flush()
+        with open(os.path.join(self.path, "meta.json"), "w") as f:
+            json.dump({"num_samples": self.count, "max_layers": MAX_LAYERS,
+                       "materials": self.materials}, f)
+
+
+def read_meta(path):
+    with open(os.path.join(path, "meta.json")) as f:
+        return json.load(f)
+
+
+def append_columnar(path, energies, layer_offsets, tokens, thicknesses, targets):
+    """
+    Ajoute un bloc à un jeu de données existant. Les colonnes sont réécrites
+    puis remplacées (les lecteurs ouverts gardent l'ancienne version) : à
+    réserver aux petits blocs, comme les retours des runs Monte Carlo.
+    """
+    meta = read_meta(path)
+    old = open_columnar(path)
+    staging = path.rstrip("/") + ".append"
+    writer = ColumnarWriter(staging, meta["num_samples"] + len(energies), meta.get("materials"))
+    for name in COLUMNS:
+        writer.columns[name][:meta["num_samples"]] = old[name]
+    writer.count = meta["num_samples"]
+    writer.append(energies, layer_offsets, tokens, thicknesses, targets)
+    writer.close()
+    del old, writer
+    # meta.json en dernier : le nombre d'échantillons ne dépasse jamais les colonnes
+    for name in [f"{column}.npy" for column in COLUMNS] + ["meta.json"]:
+        os.replace(os.path.join(staging, name), os.path.join(path, name))
+    os.rmdir(staging)
+
+
+def open_columnar(path):
+    """
+    Projette les colonnes en mémoire, sans lecture ni copie (mode copy-on-write :
+    les pages restent partagées entre processus tant qu'elles ne sont pas modifiées).
+    """
+    meta = read_meta(path)
+    if meta["max_layers"] != MAX_LAYERS:
+        raise ValueError(f"Dataset padded to {meta['max_layers']} layers, expected {MAX_LAYERS}")
+    n = meta["num_samples"]
+    return {name: np.load(os.path.join(path, f"{name}.npy"), mmap_mode="c")[:n]
+            for name in COLUMNS}
@@ -5,9 +5,7 @@ from sqlalchemy import create_engine
 import os
 import numpy as np
 
-# Mapping des matériaux vers des entiers (Tokenization)
-MATERIAL_MAP = {"Lead": 1, "Concrete": 2, "Steel": 3, "Water": 4}
-MAX_LAYERS = 5  # On paddera avec des 0 si moins de couches
+from ml.columnar import MATERIAL_MAP, MAX_LAYERS, open_columnar
 
 class ShieldDataset(Dataset):
     def __init__(self, db_url):
@@ -44,4 +42,38 @@ class ShieldDataset(Dataset):
                 'energy': energy,
                 'layers': layers_seq,
                 'target': target
-            })
\ No newline at end of file
+            })
+
+
+class ColumnarShieldDataset(Dataset):
+    """
+    Jeu de données écrit par scripts/generate_dataset.py (ml/columnar.py).
+
+    Les colonnes sont projetées en mémoire et exposées en tenseurs sans copie :
+    l'ouverture ne lit rien, et les workers du DataLoader partagent les pages
+    du fichier au lieu de dupliquer les données.
+    """
+
+    def __init__(self, path):
+        self.path = path
+        columns = open_columnar(path)
+        self.energy = torch.from_numpy(columns["energy"])
+        self.sequence = torch.from_numpy(columns["sequence"])
+        self.target = torch.from_numpy(columns["target"])
+
+    def __len__(self):
+        return len(self.target)
+
+    def __getitem__(self, idx):
+        return {
+            'energy': self.energy[idx:idx + 1],
+            'sequence': self.sequence[idx],
+            'target': self.target[idx:idx + 1],
+        }
+
+    # Les workers lancés en spawn rouvrent le fichier au lieu de recevoir une copie
+    def __getstate__(self):
+        return {'path': self.path}
+
+    def __setstate__(self, state):
+        self.__init__(state['path'])
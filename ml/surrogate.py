@@ -0,0 +1,98 @@
+import numpy as np
+import torch
+import torch.nn as nn
+
+from ml.columnar import MATERIAL_MAP, MAX_LAYERS, append_columnar, open_columnar, read_meta
+from shield_lite.core.surrogate import SurrogateModel
+
+# Borne basse de la transmission apprise (les runs sans photon transmis donnent 0)
+MIN_TRANSMISSION = 1e-9
+
+
+def surrogate_features(energy, sequence, num_materials):
+    """
+    Caractéristiques de SurrogateModel depuis les colonnes du jeu de données :
+    l'énergie, puis par emplacement l'épaisseur dans le canal de son matériau.
+    """
+    features = np.zeros((len(energy), 1 + MAX_LAYERS * num_materials))
+    features[:, 0] = energy
+    rows, slots = np.nonzero(sequence[:, :, 0] > 0)
+    channels = sequence[rows, slots, 0].astype(np.int64) - 1
+    features[rows, 1 + slots * num_materials + channels] = sequence[rows, slots, 1]
+    return features
+
+
+def train_surrogate(dataset_path, output_path, members=5, hidden=(64, 64),
+                    epochs=20, batch_size=1024, lr=1e-3, seed=0):
+    """
+    Entraîne un ensemble de MLP sur ln(transmission) du jeu de données colonne
+    et l'exporte pour le module C++ (SurrogateModel.save). Chaque membre voit
+    un tirage bootstrap des échantillons : leur dispersion sert d'incertitude.
+    """
+    materials = read_meta(dataset_path)["materials"]
+    if list(materials) != sorted(MATERIAL_MAP, key=MATERIAL_MAP.get):
+        raise ValueError("The dataset materials must follow MATERIAL_MAP")
+    columns = open_columnar(dataset_path)
+    x = surrogate_features(columns["energy"], columns["sequence"], len(materials))
+    y = np.log(np.maximum(columns["target"].astype(np.float64), MIN_TRANSMISSION))
+
+    shift = x.mean(axis=0)
+    scale = x.std(axis=0)
+    scale[scale == 0] = 1.0
+    x_std = torch.from_numpy(((x - shift) / scale).astype(np.float32))
+    y_t = torch.from_numpy(y.astype(np.float32))
+
+    rng = np.random.default_rng(seed)
+    exported = []
+    for k in range(members):
+        torch.manual_seed(seed + k)
+        sizes = [x.shape[1], *hidden]
+        layers = []
+        for n_in, n_out in zip(sizes[:-1], sizes[1:]):
+            layers += [nn.Linear(n_in, n_out), nn.ReLU()]
+        net = nn.Sequential(*layers, nn.Linear(sizes[-1], 1))
+        optimizer = torch.optim.Adam(net.parameters(), lr=lr)
+
+        sample = torch.from_numpy(rng.integers(0, len(y), len(y)))
+        for _ in range(epochs):
+            for batch in sample[torch.randperm(len(sample))].split(batch_size):
+                optimizer.zero_grad()
+                loss = nn.functional.mse_loss(net(x_std[batch]).squeeze(1), y_t[batch])
+                loss.backward()
+                optimizer.step()
+
+        exported.append([(m.weight.detach().double().numpy(), m.bias.detach().double().numpy())
+                         for m in net if isinstance(m, nn.Linear)])
+
+    model = SurrogateModel(materials, MAX_LAYERS, shift, scale,
+                           x.min(axis=0), x.max(axis=0), exported)
+    model.save(output_path)
+    return model
+
+
+def dataset_feedback(dataset_path):
+    """
+    Callback on_fallback de SurrogateModel.estimate : ajoute les runs Monte
+    Carlo de repli au jeu de données colonne (prochain entraînement). Les
+    couches d'épaisseur nulle sont retirées ; les configurations hors du
+    format (matériau hors de MATERIAL_MAP, plus de MAX_LAYERS couches) sont
+    ignorées.
+    """
+    def on_fallback(fallback):
+        offsets = np.asarray(fallback["layer_offsets"])
+        n = len(offsets) - 1
+        config = np.repeat(np.arange(n), np.diff(offsets))
+        tokens = np.array([MATERIAL_MAP.get(name, 0) for name in fallback["material_names"]],
+                          dtype=np.int64)
+        keep_layer = fallback["thickness_cm"] > 0
+        unknown = np.bincount(config[keep_layer & (tokens == 0)], minlength=n) > 0
+        counts = np.bincount(config[keep_layer], minlength=n)
+        keep = ~unknown & (counts <= MAX_LAYERS)
+        keep_layer &= keep[config]
+        if not keep.any():
+            return
+        append_columnar(dataset_path, fallback["energy_MeV"][keep],
+                        np.concatenate(([0], np.cumsum(counts[keep]))),
+                        tokens[keep_layer], fallback["thickness_cm"][keep_layer],
+                        fallback["results"]["transmission_factor"][keep])
+    return on_fallback
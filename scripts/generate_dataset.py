@@ -1,6 +1,6 @@
-import pandas as pd
 import numpy as np
-import random
+import queue
+import threading
 import uuid
 import os
 import time
@@ -9,6 +9,8 @@ from sqlalchemy import create_engine
 from shield_lite.core import MonteCarloShieldSimulator
 # On importe les modèles pour être sûr que SQLAlchemy puisse créer les tables si elles manquent
 from api.models import Base
+from api.bulk_load import copy_columns
+from ml.columnar import MATERIAL_MAP, ColumnarWriter
 
 # Connexion BDD
 DB_URL = os.getenv("DATABASE_URL", "postgresql://shield_user:shield_pass@db:5432/shield_db")
@@ -21,101 +23,152 @@ MATERIALS = [
     {"name": "Water", "mu_total": 0.07, "mu_compton": 0.07, "mu_photo": 0.00, "rho": 1.0},
 ]
 
-def generate_batch(n_samples=50):
+# Mêmes matériaux en colonnes, au format attendu par run_batch (indexés par material_id)
+BATCH_MATERIALS = {
+    "material_name": [mat["name"] for mat in MATERIALS],
+    "mu_total": np.array([mat["mu_total"] for mat in MATERIALS]),
+    "mu_compton": np.array([mat["mu_compton"] for mat in MATERIALS]),
+    "mu_photoelectric": np.array([mat["mu_photo"] for mat in MATERIALS]),
+    "density_g_cm3": np.array([mat["rho"] for mat in MATERIALS]),
+}
+
+# Token de chaque material_id dans le jeu de données d'entraînement
+MATERIAL_TOKENS = np.array([MATERIAL_MAP[mat["name"]] for mat in MATERIALS])
+
+# Propriétés par matériau, dans l'ordre des tokens (modèle de substitution, repli Monte Carlo)
+DATASET_MATERIALS = {
+    mat["name"]: {"mu_total": mat["mu_total"], "mu_compton": mat["mu_compton"],
+                  "mu_photoelectric": mat["mu_photo"], "density_g_cm3": mat["rho"]}
+    for mat in sorted(MATERIALS, key=lambda mat: MATERIAL_MAP[mat["name"]])
+}
+
+# Jeu de données colonne (ml/columnar.py), écrit en plus de la base
+DATASET_PATH = os.getenv("DATASET_PATH", "data/shield_dataset")
+
+# Taille des blocs : la simulation du bloc suivant recouvre l'insertion du bloc courant
+BLOCK_SIZE = 10000
+
+
+def sample_block(rng, n_samples):
+    """Tire n_samples configurations, empaquetées pour run_batch."""
+    energies = np.round(rng.uniform(0.5, 5.0, n_samples), 2)
+    n_layers = rng.integers(1, 5, n_samples)
+    layer_offsets = np.concatenate(([0], np.cumsum(n_layers)))
+    material_ids = rng.integers(0, len(MATERIALS), layer_offsets[-1]).astype(np.int32)
+    thicknesses = np.round(rng.uniform(1.0, 15.0, layer_offsets[-1]), 1)
+    return energies, layer_offsets, material_ids, thicknesses
+
+
+def simulate_blocks(n_samples, photons, blocks, stop, block_size, seed=0):
+    """
+    Producteur : simule les blocs les uns après les autres et les dépose dans
+    la file (None marque la fin) jusqu'à ce que stop soit levé. run_batch
+    relâche le GIL, l'insertion avance pendant le calcul.
+    """
+    rng = np.random.default_rng(seed)
+    try:
+        for block, start in enumerate(range(0, n_samples, block_size)):
+            if stop.is_set():
+                break
+            energies, layer_offsets, material_ids, thicknesses = sample_block(
+                rng, min(block_size, n_samples - start))
+            # Une seed par bloc : les flux dépendent de (seed, indice dans le bloc)
+            sim = MonteCarloShieldSimulator(seed=seed + block)
+            results = sim.run_batch(
+                layer_offsets, material_ids, thicknesses, energies, photons,
+                materials=BATCH_MATERIALS
+            )
+            blocks.put((energies, layer_offsets, material_ids, thicknesses, results))
+    except Exception as e:
+        print(f"❌ Erreur sur le lot de simulations : {e}")
+    finally:
+        blocks.put(None)
+
+
+def insert_block(cursor, block, photons):
+    """Insère un bloc dans 'simulations' puis 'simulation_layers' (COPY)."""
+    energies, layer_offsets, material_ids, thicknesses, results = block
+    n = len(energies)
+    sim_ids = np.array([str(uuid.uuid4()) for _ in range(n)])
+    n_layers = np.diff(layer_offsets)
+
+    copy_columns(cursor, "simulations", {
+        "id": sim_ids,
+        "energy_mev": energies,
+        "photons": np.full(n, photons),
+        "transmission": results["transmission_factor"],
+        "buildup_factor": results["buildup_factor"],
+        "dose_transmitted": results["dose_transmitted"],
+        "uncertainty": results["uncertainty"],
+        "status": np.full(n, "COMPLETED"),
+    }, ["%s", "%.17g", "%d", "%.17g", "%.17g", "%.17g", "%.17g", "%s"])
+
+    # created_at et simulation_layers.id prennent leur valeur par défaut
+    copy_columns(cursor, "simulation_layers", {
+        "simulation_id": np.repeat(sim_ids, n_layers),
+        "order_index": np.arange(layer_offsets[-1]) - np.repeat(layer_offsets[:-1], n_layers),
+        "material": np.array(BATCH_MATERIALS["material_name"])[material_ids],
+        "thickness_cm": thicknesses,
+        "density": BATCH_MATERIALS["density_g_cm3"][material_ids],
+    }, ["%s", "%d", "%s", "%.17g", "%.17g"])
+    return n, len(material_ids)
+
+
+def generate_batch(n_samples=50, photons=2000, block_size=BLOCK_SIZE, dataset_path=DATASET_PATH):
     print(f"🚀 Génération de {n_samples} simulations (Mode Relationnel SQL)...")
-    
-    # Listes pour stocker les données avant création des DataFrames
-    simulations_data = []
-    layers_data = []
 
     start_global = time.time()
 
-    for i in range(n_samples):
-        # 1. Préparation de la simulation
-        sim_id = str(uuid.uuid4()) # On génère l'ID tout de suite pour lier les tables
-        energy = round(random.uniform(0.5, 5.0), 2)
-        photons = 2000 # Nombre bas pour aller vite
-        
-        n_layers = random.randint(1, 4)
-        
-        sim = MonteCarloShieldSimulator(seed=i)
-
-        # 2. Boucle sur les couches (Remplissage table Enfant)
-        for order_idx in range(n_layers):
-            mat = random.choice(MATERIALS)
-            thickness = round(random.uniform(1.0, 15.0), 1)
-
-            # Ajout au moteur physique C++
-            sim.add_layer(
-                mat["name"], thickness, mat["mu_total"],
-                mat["mu_compton"], mat["mu_photo"], mat["rho"]
-            )
-
-            # Ajout à la liste des données pour la table 'simulation_layers'
-            layers_data.append({
-                "simulation_id": sim_id,   # LA CLE ETRANGERE
-                "order_index": order_idx,  # Position de la couche (0, 1, 2...)
-                "material": mat["name"],
-                "thickness_cm": thickness,
-                "density": mat["rho"]
-            })
-
-        # 3. Exécution du calcul
-        try:
-            result = sim.run(source_energy_MeV=energy, num_photons=photons)
-
-            # 4. Ajout à la liste des données pour la table 'simulations'
-            simulations_data.append({
-                "id": sim_id,
-                "energy_mev": energy,
-                "photons": photons,
-                "transmission": result.transmission_factor,
-                "buildup_factor": result.buildup_factor,
-                "dose_transmitted": result.dose_transmitted,
-                "uncertainty": result.uncertainty,
-                "status": "COMPLETED",
-                "created_at": pd.Timestamp.now()
-            })
-            
-        except Exception as e:
-            print(f"❌ Erreur sur simulation {i}: {e}")
-
-    # 5. Création des DataFrames Pandas
-    df_simulations = pd.DataFrame(simulations_data)
-    df_layers = pd.DataFrame(layers_data)
-
-    print(f"📊 Données générées : {len(df_simulations)} Simulations, {len(df_layers)} Couches.")
-
-    # 6. Insertion en Base (Séquentielle)
-    if not df_simulations.empty:
-        # Création des tables si elles n'existent pas (Important !)
-        Base.metadata.create_all(bind=engine)
-
-        print("💾 Insertion table 'simulations'...")
-        df_simulations.to_sql(
-            "simulations",
-            con=engine,
-            if_exists="append",
-            index=False,
-            method="multi",
-            chunksize=1000
-        )
-
-        print("💾 Insertion table 'simulation_layers'...")
-        df_layers.to_sql(
-            "simulation_layers",
-            con=engine,
-            if_exists="append",
-            index=False,
-            method="multi",
-            chunksize=1000
-        )
-        
+    # Création des tables si elles n'existent pas (Important !)
+    Base.metadata.create_all(bind=engine)
+
+    connection = engine.raw_connection()
+    dataset = ColumnarWriter(dataset_path, n_samples, DATASET_MATERIALS)
+
+    # Deux blocs au plus en attente : la mémoire reste bornée
+    blocks = queue.Queue(maxsize=2)
+    stop = threading.Event()
+    producer = threading.Thread(target=simulate_blocks,
+                                args=(n_samples, photons, blocks, stop, block_size))
+    producer.start()
+
+    # Insertion en flux : un COPY par table et par bloc, une transaction par bloc
+    n_simulations = n_layers = 0
+    block = None
+    try:
+        while (block := blocks.get()) is not None:
+            cursor = connection.cursor()
+            try:
+                sims, layers = insert_block(cursor, block, photons)
+                connection.commit()
+            except Exception:
+                connection.rollback()
+                raise
+            finally:
+                cursor.close()
+            energies, layer_offsets, material_ids, thicknesses, results = block
+            dataset.append(energies, layer_offsets, MATERIAL_TOKENS[material_ids], thicknesses,
+                           results["transmission_factor"])
+            n_simulations += sims
+            n_layers += layers
+            print(f"💾 {n_simulations}/{n_samples} simulations insérées...")
+    finally:
+        connection.close()
+        dataset.close()
+        # En cas d'erreur, arrêter le producteur et vider la file pour le débloquer
+        stop.set()
+        while block is not None:
+            block = blocks.get()
+        producer.join()
+
+    if n_simulations:
+        print(f"📊 Données générées : {n_simulations} Simulations, {n_layers} Couches.")
         duration = time.time() - start_global
+        print(f"🗂️ Jeu de données colonne : {dataset_path}")
         print(f"✅ Terminé en {duration:.2f} secondes !")
-
     else:
         print("⚠️ Aucune donnée générée.")
 
+
 if __name__ == "__main__":
-    generate_batch()
\ No newline at end of file
+    generate_batch()
@@ -0,0 +1,93 @@
+// Micro-benchmark of the Compton angle samplers: the former isotropic
+// approximation, Kahn's rejection method and the inverse-CDF table used by
+// the transport. Reports samples/s and the bias of the mean energy ratio
+// <E'/E> against the exact Klein-Nishina value (the bias includes the
+// statistical noise, ~1e-4 at 10^7 samples).
+//
+//   cmake -DSHIELD_LITE_BENCHMARKS=ON .. && make klein_nishina_bench
+//   ./klein_nishina_bench [samples_per_energy]
+
+#include "klein_nishina.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace shield_lite;
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Direction after scattering, rotated about the incoming (0, 0.6, 0.8)
+struct Direction {
+    double dx, dy, dz;
+};
+
+Direction rotate(double cos_theta, double phi) {
+    const double u = 0.0, v = 0.6, w = 0.8;
+    double sin_theta = std::sqrt(std::max(0.0, 1.0 - cos_theta * cos_theta));
+    double cos_phi = std::cos(phi), sin_phi = std::sin(phi);
+    double t = std::sqrt(1.0 - w * w);
+    return {sin_theta * (u * w * cos_phi - v * sin_phi) / t + u * cos_theta,
+            sin_theta * (v * w * cos_phi + u * sin_phi) / t + v * cos_theta,
+            w * cos_theta - sin_theta * cos_phi * t};
+}
+
+// Exact <E'/E> by quadrature of the density in q (see klein_nishina.h)
+double exactMeanRatio(double alpha) {
+    const int steps = 100000;
+    double log_beta = std::log1p(2.0 * alpha), norm = 0.0, mean = 0.0;
+    for (int k = 0; k < steps; ++k) {
+        double eps = std::exp(-(k + 0.5) / steps * log_beta);
+        double cos_theta = 1.0 - (1.0 / eps - 1.0) / alpha;
+        double density = 1.0 + eps * eps - eps * (1.0 - cos_theta * cos_theta);
+        norm += density;
+        mean += density * eps;
+    }
+    return mean / norm;
+}
+
+template <typename Sampler>
+void run(const char* name, double energy, long samples, double exact, Sampler&& sampler) {
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    auto next = [&]() { return uniform(rng); };
+
+    double sum_ratio = 0.0, checksum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < samples; ++i) {
+        ComptonSample s = sampler(next);
+        Direction d = rotate(s.cos_theta, 2.0 * PI * next());
+        sum_ratio += s.energy_ratio;
+        checksum += d.dz;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double mean = sum_ratio / samples;
+    std::printf("%-10s E=%7.3f MeV  %8.2f Msamples/s  <E'/E>=%.6f  bias=%+.2e  (checksum %.3f)\n",
+                name, energy, samples / seconds * 1e-6, mean, mean / exact - 1.0, checksum / samples);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long samples = argc > 1 ? std::atol(argv[1]) : 10000000;
+    const KleinNishinaTable& table = KleinNishinaTable::instance();
+
+    for (double energy : {0.1, 0.662, 1.25, 6.0}) {
+        double alpha = energy / ELECTRON_REST_MASS_MEV;
+        double exact = exactMeanRatio(alpha);
+
+        run("isotropic", energy, samples, exact, [alpha](auto& next) {
+            double cos_theta = 2.0 * next() - 1.0;
+            return ComptonSample{1.0 / (1.0 + alpha * (1.0 - cos_theta)), cos_theta};
+        });
+        run("kahn", energy, samples, exact, [alpha](auto& next) {
+            return sampleKahn(alpha, next);
+        });
+        run("table", energy, samples, exact, [&table, energy](auto& next) {
+            return table.sample(energy, next());
+        });
+    }
+    return 0;
+}
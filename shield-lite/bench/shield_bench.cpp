@@ -0,0 +1,331 @@
+// Transport benchmark on standard shield scenarios, for tracking
+// performance between releases. Every (scenario, engine, thread count) is
+// run `repeat` times with the same seed and the fastest run is kept. The
+// report is JSON on stdout (or --output):
+//   photons_per_second   histories / wall-clock second
+//   ns_per_collision     wall-clock ns per interaction
+//   core_ns_per_collision  ns_per_collision * threads (per-core cost)
+//   speedup, efficiency  against the 1-thread run of the same scenario/engine
+//                        (null when 1 is not among the thread counts)
+// transmission_factor and collisions are deterministic for a given seed and
+// photon count, so they also flag physics changes. Built with
+// SHIELD_LITE_INSTRUMENTATION, every result also carries the event counters
+// and phase times.
+//
+//   cmake -DSHIELD_LITE_BENCHMARKS=ON .. && make shield_bench
+//   ./shield_bench [--photons N] [--repeat R] [--threads 1,2,4]
+//                  [--engines scalar,batched] [--scenarios thin_lead,...] [--output file]
+
+#include "photon_transport.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace shield_lite;
+
+namespace {
+
+// Shield configuration at a fixed source energy (constant coefficients, cm^-1)
+struct Scenario {
+    const char* name;
+    double energy_MeV;
+    std::vector<MaterialLayer> layers;
+    bool scalar_only = false;   // Uses features the other engines reject
+};
+
+MaterialLayer lead(double t, double mu_total, double mu_compton) {
+    return MaterialLayer("Lead", t, mu_total, mu_compton, mu_total - mu_compton, 11.34);
+}
+
+std::vector<Scenario> standardScenarios() {
+    std::vector<Scenario> scenarios;
+
+    // Thin lead, Cs-137: few collisions, dominated by source and tallies
+    scenarios.push_back({"thin_lead", 0.662, {lead(1.0, 1.25, 0.57)}});
+
+    // Thick concrete, Co-60: long scattering histories (~6.5 mean free paths)
+    scenarios.push_back({"thick_concrete", 1.25,
+                         {MaterialLayer("Concrete", 50.0, 0.131, 0.130, 0.001, 2.3)}});
+
+    // 10-layer laminate: frequent boundary crossings and layer changes
+    Scenario laminate{"laminate_10", 1.0, {}};
+    for (int i = 0; i < 10; ++i) {
+        switch (i % 3) {
+        case 0: laminate.layers.push_back(lead(0.5, 0.805, 0.59)); break;
+        case 1: laminate.layers.push_back(MaterialLayer("Steel", 1.0, 0.470, 0.468, 0.002, 7.85)); break;
+        default: laminate.layers.push_back(MaterialLayer("Polyethylene", 2.0, 0.0665, 0.0665, 0.0, 0.94)); break;
+        }
+    }
+    scenarios.push_back(laminate);
+
+    // High energy: forward-peaked Compton, pair production folded into absorption
+    scenarios.push_back({"high_energy", 6.0,
+                         {MaterialLayer("Steel", 10.0, 0.246, 0.190, 0.056, 7.85)}});
+
+    // Low energy: nearly isotropic scattering, short histories near the cutoff
+    scenarios.push_back({"low_energy", 0.1,
+                         {MaterialLayer("Aluminum", 3.0, 0.43, 0.38, 0.05, 2.7)}});
+
+    // Lead at 2 MeV, absorbed energy deposited locally, then with the
+    // annihilation and K-fluorescence photons transported from the
+    // secondary bank: the pair measures the cost of secondaries
+    scenarios.push_back({"lead_2mev", 2.0, {lead(2.0, 0.52, 0.40)}});
+    Scenario secondaries{"lead_2mev_secondaries", 2.0, {lead(2.0, 0.52, 0.40)}, true};
+    secondaries.layers[0].secondaries.pair_mu_cm = 0.06;
+    secondaries.layers[0].secondaries.fluorescence_yield = 0.77;
+    secondaries.layers[0].secondaries.fluorescence_energy_MeV = 0.075;
+    scenarios.push_back(secondaries);
+
+    return scenarios;
+}
+
+struct Options {
+    int photons = 400000;
+    int repeat = 3;
+    std::vector<int> threads;
+    std::vector<std::string> engines = {"scalar", "batched"};
+    std::vector<std::string> scenarios;   // Empty = all
+    std::string output;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::size_t begin = 0;
+    while (begin <= list.size()) {
+        std::size_t end = list.find(',', begin);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        if (end > begin) {
+            items.push_back(list.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return items;
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + flag);
+        }
+        const std::string value = argv[++i];
+        if (flag == "--photons") {
+            options.photons = std::atoi(value.c_str());
+        } else if (flag == "--repeat") {
+            options.repeat = std::atoi(value.c_str());
+        } else if (flag == "--threads") {
+            for (const auto& t : splitList(value)) {
+                options.threads.push_back(std::atoi(t.c_str()));
+            }
+        } else if (flag == "--engines") {
+            options.engines = splitList(value);
+        } else if (flag == "--scenarios") {
+            options.scenarios = splitList(value);
+        } else if (flag == "--output") {
+            options.output = value;
+        } else {
+            throw std::invalid_argument("Unknown option " + flag);
+        }
+    }
+    if (options.photons <= 0 || options.repeat <= 0) {
+        throw std::invalid_argument("--photons and --repeat must be positive");
+    }
+
+    // Default thread counts: powers of two up to the hardware threads, plus that count
+    if (options.threads.empty()) {
+        const int hardware = std::max(1u, std::thread::hardware_concurrency());
+        for (int t = 1; t < hardware; t *= 2) {
+            options.threads.push_back(t);
+        }
+        options.threads.push_back(hardware);
+    }
+    for (int t : options.threads) {
+        if (t <= 0) {
+            throw std::invalid_argument("Thread counts must be positive");
+        }
+    }
+    std::sort(options.threads.begin(), options.threads.end());
+    options.threads.erase(std::unique(options.threads.begin(), options.threads.end()),
+                          options.threads.end());
+    return options;
+}
+
+TransportEngine parseEngine(const std::string& name) {
+    if (name == "scalar") {
+        return TransportEngine::Scalar;
+    }
+    if (name == "batched") {
+        return TransportEngine::Batched;
+    }
+    throw std::invalid_argument("Unknown engine " + name);
+}
+
+std::string jsonNumber(double value, bool valid) {
+    if (!valid) {
+        return "null";
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.4g", value);
+    return buffer;
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+struct Measurement {
+    std::string scenario, engine;
+    int threads;
+    double seconds;
+    long long collisions;
+    double transmission_factor;
+    double secondary_transmission;
+    double speedup;
+    TransportStats stats;
+};
+
+std::string jsonStats(const TransportStats& s) {
+    char buffer[640];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"flights\": %lld, \"boundary_crossings\": %lld, \"compton\": %lld, "
+                  "\"photoelectric\": %lld, \"cutoff_kills\": %lld, \"roulette_kills\": %lld, "
+                  "\"backscatter_escapes\": %lld, \"secondaries\": %lld, \"bank_overflows\": %lld, "
+                  "\"collisions_by_energy\": [%lld, %lld, %lld, %lld], "
+                  "\"phase_seconds\": {\"source\": %.6g, \"random\": %.6g, \"flight\": %.6g, "
+                  "\"resolve\": %.6g}}",
+                  s.flights, s.boundary_crossings, s.compton, s.photoelectric, s.cutoff_kills,
+                  s.roulette_kills, s.backscatter_escapes, s.secondaries, s.bank_overflows,
+                  s.collisions_by_energy[0],
+                  s.collisions_by_energy[1], s.collisions_by_energy[2], s.collisions_by_energy[3],
+                  s.phase_seconds[0], s.phase_seconds[1], s.phase_seconds[2], s.phase_seconds[3]);
+    return buffer;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "shield_bench: %s\n", e.what());
+        return 2;
+    }
+
+    std::vector<Scenario> scenarios = standardScenarios();
+    if (!options.scenarios.empty()) {
+        std::vector<Scenario> selected;
+        for (const auto& name : options.scenarios) {
+            auto it = std::find_if(scenarios.begin(), scenarios.end(),
+                                   [&](const Scenario& s) { return name == s.name; });
+            if (it == scenarios.end()) {
+                std::fprintf(stderr, "shield_bench: unknown scenario %s\n", name.c_str());
+                return 2;
+            }
+            selected.push_back(*it);
+        }
+        scenarios = selected;
+    }
+
+    std::vector<Measurement> measurements;
+    for (const auto& scenario : scenarios) {
+        for (const auto& engine_name : options.engines) {
+            TransportEngine engine;
+            try {
+                engine = parseEngine(engine_name);
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "shield_bench: %s\n", e.what());
+                return 2;
+            }
+            if (scenario.scalar_only && engine != TransportEngine::Scalar) {
+                std::fprintf(stderr, "%-15s %-8s skipped (scalar engine only)\n", scenario.name,
+                             engine_name.c_str());
+                continue;
+            }
+            double single_thread_seconds = 0.0;
+            for (int threads : options.threads) {
+                Measurement m{scenario.name, engine_name, threads, 0.0, 0, 0.0, 0.0, 0.0, {}};
+                for (int r = 0; r < options.repeat; ++r) {
+                    PhotonTransport transport(42);
+                    transport.setShieldLayers(scenario.layers);
+                    MonteCarloResult result = transport.simulate(scenario.energy_MeV, options.photons,
+                                                                 1.0, threads, engine);
+                    if (r == 0 || result.elapsed_seconds < m.seconds) {
+                        m.seconds = result.elapsed_seconds;
+                        m.stats = result.stats;
+                    }
+                    m.collisions = result.collisions;
+                    m.transmission_factor = result.transmission_factor;
+                    m.secondary_transmission = result.secondary_transmission;
+                }
+                if (threads == 1) {
+                    single_thread_seconds = m.seconds;
+                }
+                m.speedup = single_thread_seconds > 0 ? single_thread_seconds / m.seconds : 0.0;
+                measurements.push_back(m);
+                std::fprintf(stderr, "%-15s %-8s %3d threads  %8.3f Mphotons/s\n", m.scenario.c_str(),
+                             m.engine.c_str(), threads, options.photons / m.seconds * 1e-6);
+            }
+        }
+    }
+
+    FILE* out = stdout;
+    if (!options.output.empty()) {
+        out = std::fopen(options.output.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "shield_bench: cannot write %s\n", options.output.c_str());
+            return 1;
+        }
+    }
+
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"benchmark\": \"shield_bench\",\n");
+    std::fprintf(out, "  \"isa\": \"%s\",\n", simd::kIsa);
+    std::fprintf(out, "  \"simd_width\": %d,\n", simd::kWidth);
+    std::fprintf(out, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+#ifdef __VERSION__
+    std::fprintf(out, "  \"compiler\": %s,\n", jsonString(__VERSION__).c_str());
+#endif
+    std::fprintf(out, "  \"instrumented\": %s,\n", kInstrumented ? "true" : "false");
+    std::fprintf(out, "  \"photons\": %d,\n", options.photons);
+    std::fprintf(out, "  \"repeat\": %d,\n", options.repeat);
+    std::fprintf(out, "  \"results\": [\n");
+    for (std::size_t i = 0; i < measurements.size(); ++i) {
+        const Measurement& m = measurements[i];
+        const double ns_per_collision = m.collisions > 0 ? m.seconds * 1e9 / m.collisions : 0.0;
+        std::fprintf(out,
+                     "    {\"scenario\": %s, \"engine\": %s, \"threads\": %d, \"seconds\": %.6g, "
+                     "\"photons_per_second\": %.6g, \"collisions\": %lld, \"ns_per_collision\": %.6g, "
+                     "\"core_ns_per_collision\": %.6g, \"speedup\": %s, \"efficiency\": %s, "
+                     "\"transmission_factor\": %.9g, \"secondary_transmission\": %.9g%s}%s\n",
+                     jsonString(m.scenario).c_str(), jsonString(m.engine).c_str(), m.threads, m.seconds,
+                     options.photons / m.seconds, m.collisions, ns_per_collision,
+                     ns_per_collision * m.threads, jsonNumber(m.speedup, m.speedup > 0).c_str(),
+                     jsonNumber(m.speedup / m.threads, m.speedup > 0).c_str(), m.transmission_factor,
+                     m.secondary_transmission,
+                     kInstrumented ? (", \"stats\": " + jsonStats(m.stats)).c_str() : "",
+                     i + 1 < measurements.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}
@@ -2,11 +2,17 @@
 
 from .dose import dose
 from .mass import mass
+from .result_cache import ResultCache
 
 # Monte Carlo module (requires C++ compilation)
 try:
-    from .monte_carlo import MonteCarloShieldSimulator, estimate_required_photons
-    __all__ = ['dose', 'mass', 'MonteCarloShieldSimulator', 'estimate_required_photons']
+    from .monte_carlo import (
+        BuildupTable, MonteCarloShieldSimulator, RunCancelled, VarianceReduction,
+        estimate_required_photons, gpu_available, parse_engine
+    )
+    __all__ = ['dose', 'mass', 'ResultCache', 'BuildupTable', 'MonteCarloShieldSimulator',
+               'RunCancelled', 'VarianceReduction', 'estimate_required_photons', 'gpu_available',
+               'parse_engine']
 except ImportError:
     # C++ module not compiled yet
-    __all__ = ['dose', 'mass']
\ No newline at end of file
+    __all__ = ['dose', 'mass', 'ResultCache']
\ No newline at end of file
@@ -0,0 +1,126 @@
+"""
+Distributed Monte Carlo runs over shared-nothing workers.
+
+A run is split into disjoint ranges of histories of the same run key
+(``MonteCarloSimulator.run_tally``), so every worker draws from its own
+substreams and the merged tally is that of the whole range, whatever the
+number of workers. Workers rebuild the simulator from its plain-data
+configuration (``MonteCarloShieldSimulator.cache_config``) and return their
+tally state; the parent combines the tallies with a pairwise tree reduction
+in history order.
+
+Any ``concurrent.futures.Executor`` can run the ranges:
+``ProcessPoolExecutor`` on one node, ``mpi4py.futures.MPIPoolExecutor``
+across MPI ranks, or a Dask ``Client.get_executor()``.
+"""
+
+import os
+import time
+from concurrent.futures import Executor, ProcessPoolExecutor
+from typing import Dict, List, Optional, Tuple
+
+# Ranges are whole chunks of the transport scheduler, so they reproduce the
+# chunk streams of a single-process run (PhotonTransport::kChunkPhotons)
+CHUNK_PHOTONS = 8192
+
+# Ranges per worker, for load balancing
+RANGES_PER_WORKER = 4
+
+
+def split_histories(num_photons: int, num_ranges: int) -> List[Tuple[int, int]]:
+    """
+    Split histories [0, num_photons) into at most num_ranges contiguous
+    (first_history, count) ranges of whole chunks.
+    """
+    num_chunks = -(-num_photons // CHUNK_PHOTONS)
+    num_ranges = max(1, min(num_ranges, num_chunks))
+    ranges = []
+    for k in range(num_ranges):
+        first = num_chunks * k // num_ranges * CHUNK_PHOTONS
+        end = min(num_chunks * (k + 1) // num_ranges * CHUNK_PHOTONS, num_photons)
+        if end > first:
+            ranges.append((first, end - first))
+    return ranges
+
+
+def tree_reduce(tallies: List):
+    """Merge tallies pairwise (neighbours first), keeping their order."""
+    while len(tallies) > 1:
+        merged = []
+        for i in range(0, len(tallies) - 1, 2):
+            tallies[i].merge(tallies[i + 1])
+            merged.append(tallies[i])
+        if len(tallies) % 2:
+            merged.append(tallies[-1])
+        tallies = merged
+    return tallies[0]
+
+
+def simulator_from_config(config: Dict):
+    """Rebuild a MonteCarloShieldSimulator from its cache_config."""
+    from .monte_carlo import MonteCarloShieldSimulator
+
+    sim = MonteCarloShieldSimulator(seed=config["seed"], rng=config["rng"])
+    layers = config["layers"]
+    sim.add_layers(layers["material"], layers["thickness_cm"], layers["mu_total"],
+                   layers["mu_compton"], layers["mu_photoelectric"], layers["density_g_cm3"])
+    for name, table in config["cross_sections"].items():
+        sim.set_cross_sections(name, table["energy_MeV"], table["mu_total"],
+                               table["mu_compton"], table["mu_photoelectric"],
+                               table["points_per_decade"])
+    for name, physics in config.get("secondary_physics", {}).items():
+        sim.set_secondary_physics(name, **physics)
+    return sim
+
+
+def run_range(config: Dict, first_history: int, num_photons: int, num_threads: int = 1) -> Dict:
+    """
+    Worker entry point: tally state of histories
+    [first_history, first_history + num_photons) of the configuration.
+    """
+    from .monte_carlo import MeshTallies, VarianceReduction, parse_engine
+
+    sim = simulator_from_config(config)
+    vr = config["variance_reduction"]
+    variance_reduction = VarianceReduction(
+        implicit_capture=vr["implicit_capture"], roulette_weight=vr["roulette_weight"],
+        survival_weight=vr["survival_weight"], split_weight=vr["split_weight"],
+        max_split=vr["max_split"], stretch=vr["stretch"], auto_stretch=vr["auto_stretch"])
+    tally = sim.simulator.run_tally(
+        config["source_energy_MeV"], first_history, num_photons, num_threads,
+        parse_engine(config["engine"]), variance_reduction,
+        MeshTallies(config["depth_bins"], config["spectrum_bins"]))
+    return tally.to_state()
+
+
+def run_tally_distributed(config: Dict,
+                          first_history: int,
+                          num_photons: int,
+                          executor: Optional[Executor] = None,
+                          processes: Optional[int] = None,
+                          num_threads: int = 1,
+                          workers: Optional[int] = None):
+    """
+    Tally of histories [first_history, first_history + num_photons) of the
+    configuration, run over an executor (or a pool of processes created for
+    the call). workers is the number of workers the executor runs, which
+    sizes the split (default: processes, else os.cpu_count()); executors do
+    not expose it. Returns (TransportTally, elapsed wall-clock seconds).
+    """
+    from .monte_carlo import TransportTally
+
+    start = time.perf_counter()
+    own_pool = executor is None
+    if own_pool:
+        executor = ProcessPoolExecutor(max_workers=processes)
+    workers = workers or processes or os.cpu_count() or 1
+    try:
+        ranges = split_histories(num_photons, workers * RANGES_PER_WORKER)
+        futures = [executor.submit(run_range, config, first_history + first, count, num_threads)
+                   for first, count in ranges]
+        tallies = [TransportTally.from_state(future.result()) for future in futures]
+    finally:
+        if own_pool:
+            executor.shutdown()
+    tally = tree_reduce(tallies) if tallies else TransportTally()
+    return tally, time.perf_counter() - start
@@ -6,11 +6,21 @@ simulation engine that models realistic photon transport through multi-layer
 shields, including Compton scattering and photoelectric absorption.
 """
 
-from typing import Dict, List, Optional
+from concurrent.futures import Executor
+from typing import Callable, Dict, List, Optional
+import asyncio
+import time
 import numpy as np
 
+from .distributed import run_tally_distributed
+from .result_cache import ResultCache
+
 try:
-    from shield_lite._monte_carlo import MonteCarloSimulator, MonteCarloResult
+    from shield_lite._monte_carlo import (
+        AsyncRun, BuildupTable, Checkpoint, MeshTallies, MonteCarloSimulator, MonteCarloResult,
+        RandomGenerator, RunCancelled, StoppingCriteria, StreamingTally, TransportEngine,
+        TransportTally, VarianceReduction, evaluate_shields, gpu_available
+    )
 except ImportError as e:
     raise ImportError(
         "C++ Monte Carlo module not found. Please compile the C++ extension:\n"
@@ -21,6 +31,28 @@ except ImportError as e:
     )
 
 
+def parse_engine(engine: str) -> TransportEngine:
+    """Map an engine name ("scalar", "batched", "gpu") to the C++ enum."""
+    try:
+        return TransportEngine.__members__[engine.upper()]
+    except KeyError:
+        raise ValueError(
+            f"Unknown engine '{engine}'. "
+            f"Available: {[name.lower() for name in TransportEngine.__members__]}"
+        )
+
+
+def _parse_rng(rng: str) -> RandomGenerator:
+    """Map a generator name ("mt19937", "philox") to the C++ enum."""
+    try:
+        return RandomGenerator.__members__[rng.upper()]
+    except KeyError:
+        raise ValueError(
+            f"Unknown random generator '{rng}'. "
+            f"Available: {[name.lower() for name in RandomGenerator.__members__]}"
+        )
+
+
 class MonteCarloShieldSimulator:
     """
     High-level interface for Monte Carlo gamma ray shielding simulation.
@@ -45,7 +77,7 @@ class MonteCarloShieldSimulator:
     >>> print(f"Buildup factor: {result.buildup_factor:.2f}")
     """
 
-    def __init__(self, seed: Optional[int] = None):
+    def __init__(self, seed: Optional[int] = None, rng: str = "mt19937"):
         """
         Initialize the Monte Carlo simulator.
 
@@ -53,12 +85,19 @@ class MonteCarloShieldSimulator:
         ----------
         seed : int, optional
             Random seed for reproducibility. If None, uses default seed (42).
+        rng : str, optional
+            Random number generator: "mt19937" (default, one Mersenne Twister
+            per chunk of histories) or "philox" (counter-based, one stream
+            per history keyed by the seed and the history index).
         """
-        if seed is None:
-            self.simulator = MonteCarloSimulator()
-        else:
-            self.simulator = MonteCarloSimulator(seed)
-        self._layers_info = []
+        self.seed = 42 if seed is None else int(seed)
+        self.rng = rng.lower()
+        self.simulator = MonteCarloSimulator(self.seed)
+        self.simulator.set_random_generator(_parse_rng(rng))
+        # Tables given to set_cross_sections, part of the result cache key
+        self._cross_sections: Dict[str, Dict] = {}
+        # Parameters given to set_secondary_physics, part of the result cache key
+        self._secondary_physics: Dict[str, Dict] = {}
 
     def add_layer(self,
                   material_name: str,
@@ -94,14 +133,56 @@ class MonteCarloShieldSimulator:
             material_name, thickness_cm, mu_total,
             mu_compton, mu_photoelectric, density_g_cm3
         )
-        self._layers_info.append({
-            'material': material_name,
-            'thickness_cm': thickness_cm,
-            'mu_total': mu_total,
-            'mu_compton': mu_compton,
-            'mu_photoelectric': mu_photoelectric,
-            'density_g_cm3': density_g_cm3
-        })
+
+    def add_layers(self,
+                   material_names: List[str],
+                   thickness_cm,
+                   mu_total,
+                   mu_compton,
+                   mu_photoelectric,
+                   density_g_cm3) -> None:
+        """
+        Add several layers in one native call.
+
+        The properties are given as columns, one entry per layer, so a shield
+        read from a table or generated by a sweep is passed without building
+        one Python call per layer.
+
+        Parameters
+        ----------
+        material_names : list of str
+            Material of each layer, in order from source to detector
+        thickness_cm, mu_total, mu_compton, mu_photoelectric, density_g_cm3 : array-like or float
+            Same units as add_layer; scalars apply to every layer.
+            Contiguous float64 arrays are read in place, without a copy.
+
+        Raises
+        ------
+        ValueError
+            If an array does not have one entry per material name
+
+        Examples
+        --------
+        >>> sim = MonteCarloShieldSimulator()
+        >>> sim.add_layers(["Lead", "Steel"],
+        ...                thickness_cm=np.array([3.0, 2.0]),
+        ...                mu_total=np.array([0.77, 0.47]),
+        ...                mu_compton=np.array([0.58, 0.35]),
+        ...                mu_photoelectric=np.array([0.19, 0.12]),
+        ...                density_g_cm3=np.array([11.34, 7.85]))
+        """
+        material_names = list(material_names)
+
+        def column(values):
+            values = np.asarray(values, dtype=np.float64)
+            if values.ndim == 0:
+                values = np.full(len(material_names), values)
+            return np.ascontiguousarray(values)
+
+        self.simulator.add_layers(
+            material_names, column(thickness_cm), column(mu_total),
+            column(mu_compton), column(mu_photoelectric), column(density_g_cm3)
+        )
 
     def add_layers_from_dict(self,
                             thicknesses: Dict[str, float],
@@ -136,25 +217,126 @@ class MonteCarloShieldSimulator:
         ...     density={'Lead': 11.34, 'Steel': 7.85}
         ... )
         """
-        for material in thicknesses.keys():
-            self.add_layer(
-                material,
-                thicknesses[material],
-                mu_total[material],
-                mu_compton[material],
-                mu_photoelectric[material],
-                density[material]
-            )
+        materials = list(thicknesses)
+        self.add_layers(
+            materials,
+            [thicknesses[m] for m in materials],
+            [mu_total[m] for m in materials],
+            [mu_compton[m] for m in materials],
+            [mu_photoelectric[m] for m in materials],
+            [density[m] for m in materials]
+        )
+
+    def set_cross_sections(self,
+                           material_name: str,
+                           energy_MeV,
+                           mu_total,
+                           mu_compton,
+                           mu_photoelectric,
+                           points_per_decade: int = 100) -> None:
+        """
+        Use energy-dependent attenuation coefficients for a material.
+
+        Every layer of this material then looks up mu(E) at the current
+        photon energy, so Compton-downscattered photons see the coefficients
+        of their actual energy. The table is shared by all layers of the
+        material; the constant coefficients given to add_layer are ignored
+        while it is set.
+
+        Parameters
+        ----------
+        material_name : str
+            Name of the material, as given to add_layer
+        energy_MeV : array-like
+            Tabulated energies in MeV, strictly increasing
+        mu_total, mu_compton, mu_photoelectric : array-like
+            Linear attenuation coefficients in cm^-1 at those energies
+            (mass attenuation coefficients times density)
+        points_per_decade : int, optional
+            Density of the uniform log-energy lookup grid (default: 100)
+
+        Raises
+        ------
+        ValueError
+            If the arrays have different lengths, fewer than 2 points,
+            non-increasing energies or negative coefficients
+        """
+        table = {
+            "energy_MeV": np.asarray(energy_MeV, dtype=float).tolist(),
+            "mu_total": np.asarray(mu_total, dtype=float).tolist(),
+            "mu_compton": np.asarray(mu_compton, dtype=float).tolist(),
+            "mu_photoelectric": np.asarray(mu_photoelectric, dtype=float).tolist(),
+            "points_per_decade": points_per_decade,
+        }
+        self.simulator.set_cross_sections(
+            material_name, table["energy_MeV"], table["mu_total"], table["mu_compton"],
+            table["mu_photoelectric"], points_per_decade,
+        )
+        self._cross_sections[material_name] = table
+
+    def set_secondary_physics(self,
+                              material_name: str,
+                              pair_mu: float = 0.0,
+                              fluorescence_yield: float = 0.0,
+                              fluorescence_energy_MeV: float = 0.0) -> None:
+        """
+        Transport the secondary photons emitted on absorption in a material.
+
+        By default an absorbed photon deposits all its energy locally. With
+        secondary physics, an absorption above 1.022 MeV is a pair production
+        with probability pair_mu / (mu_total - mu_compton): the two 0.511 MeV
+        annihilation photons are emitted back to back. Otherwise, with
+        probability fluorescence_yield, an isotropic fluorescence X-ray of
+        fluorescence_energy_MeV is emitted. Secondaries are transported after
+        the primary photon of their history, from a fixed-capacity bank
+        (TransportStats.bank_overflows counts those deposited instead).
+        Only the scalar engine supports secondaries. Transmitted secondaries
+        are reported apart (secondary_transmission, secondary_dose_transmitted,
+        secondary_spectrum): transmission_factor, dose_transmitted and
+        buildup_factor still count the source photons only.
+
+        Parameters
+        ----------
+        material_name : str
+            Name of the material, as given to add_layer
+        pair_mu : float, optional
+            Pair production coefficient in cm^-1 (part of the absorption)
+        fluorescence_yield : float, optional
+            Probability in [0, 1] that an absorption emits an X-ray
+        fluorescence_energy_MeV : float, optional
+            Energy of that X-ray in MeV (0.075 for lead K-alpha)
+
+        Raises
+        ------
+        ValueError
+            If a coefficient is negative, the yield is outside [0, 1] or
+            the X-ray energy is not positive while the yield is
+        """
+        physics = {
+            "pair_mu": float(pair_mu),
+            "fluorescence_yield": float(fluorescence_yield),
+            "fluorescence_energy_MeV": float(fluorescence_energy_MeV),
+        }
+        self.simulator.set_secondary_physics(material_name, **physics)
+        self._secondary_physics[material_name] = physics
 
     def clear_layers(self) -> None:
         """Remove all layers from the shield configuration."""
         self.simulator.clear_layers()
-        self._layers_info.clear()
 
     def run(self,
             source_energy_MeV: float,
             num_photons: int = 100000,
-            source_area_cm2: float = 1.0) -> MonteCarloResult:
+            source_area_cm2: float = 1.0,
+            num_threads: int = 1,
+            engine: str = "scalar",
+            variance_reduction: Optional[VarianceReduction] = None,
+            depth_bins: int = 0,
+            spectrum_bins: int = 0,
+            cache: Optional[ResultCache] = None,
+            processes: Optional[int] = None,
+            executor: Optional[Executor] = None,
+            workers: Optional[int] = None) -> MonteCarloResult:
         """
         Run the Monte Carlo simulation.
 
@@ -167,23 +349,97 @@ class MonteCarloShieldSimulator:
             Higher values give better statistics but take longer
         source_area_cm2 : float, optional
             Source area in cm^2 (default: 1.0)
+        num_threads : int, optional
+            Number of worker threads (default: 1). Use 0 or a negative value
+            to run on all available cores. Photons run in chunks with their
+            own random streams, so results depend on the seed only, not on
+            the thread count.
+        engine : str, optional
+            Transport kernel: "scalar" (default, one photon at a time),
+            "batched" (structure-of-arrays batches with a SIMD kernel) or
+            "gpu" (CUDA kernel, see gpu_available; requires rng="philox",
+            num_threads is ignored). All give statistically equivalent
+            results; "gpu" follows the same histories as "scalar" with Philox.
+        variance_reduction : VarianceReduction, optional
+            Survival biasing settings (default: None, analog transport), e.g.
+            ``VarianceReduction(implicit_capture=True, roulette_weight=0.25)``.
+            Estimates stay unbiased; use ``figure_of_merit`` to compare
+            settings. Splitting (``split_weight``) requires the scalar engine.
+            For deep-penetration shields use the exponential transform
+            (``auto_stretch=True`` or one ``stretch`` parameter per layer).
+        depth_bins : int, optional
+            Number of uniform depth bins across the whole shield for the
+            deposited energy (default: 0, off)
+        spectrum_bins : int, optional
+            Number of uniform bins over [0, source_energy_MeV] for the energy
+            of the transmitted photons (default: 0, off)
+        cache : ResultCache, optional
+            Persistent result cache (default: None). The result is read from
+            the cache when it holds at least num_photons histories for this
+            configuration; otherwise only the missing histories are run and
+            merged into the cached tally. Cached runs are always the first
+            run of a simulator with this seed (the simulator stream is not
+            advanced), total_photons may exceed num_photons, elapsed_seconds
+            is the accumulated run time and the stats counters are zero.
+        processes : int, optional
+            Run over a pool of this many worker processes created for the
+            call (default: None, in this process)
+        executor : concurrent.futures.Executor, optional
+            Run over an existing pool instead (default: None), e.g. a
+            ProcessPoolExecutor, ``mpi4py.futures.MPIPoolExecutor`` for MPI
+            ranks or a Dask ``Client.get_executor()``. Workers get disjoint
+            ranges of histories and rebuild the shield from cache_config;
+            their tallies are combined with a tree reduction. num_threads
+            is then the thread count of each worker. Like cached runs,
+            distributed runs are the first run of a simulator with this
+            seed, so the result does not depend on the number of workers
+            (up to rounding); elapsed_seconds is the wall-clock time and the
+            stats counters are zero.
+        workers : int, optional
+            Number of workers of the executor (default: None, processes or
+            else os.cpu_count()). The run is split into about four ranges
+            per worker; it only affects load balancing, not the result.
 
         Returns
         -------
         MonteCarloResult
             Simulation results containing:
             - dose_transmitted: Average energy transmitted per photon (MeV)
-            - dose_absorbed: Average energy absorbed per photon (MeV)
-            - transmission_factor: Fraction of photons transmitted (0 to 1)
+            - dose_absorbed: Average energy absorbed per photon (MeV), from
+              photoelectric absorption and Compton recoil electrons
+            - transmission_factor: Transmitted weight per photon (0 to 1)
             - buildup_factor: Dose buildup factor (>1 due to scattering)
             - uncertainty: Statistical uncertainty
+            - relative_uncertainty: Relative standard error of dose_transmitted
+            - transmission_uncertainty: Standard error of transmission_factor
+            - elapsed_seconds: Wall-clock time of the simulation
+            - figure_of_merit: 1 / (relative_uncertainty^2 * elapsed_seconds)
+            - transmitted_tally: Streaming tally (mean, variance, higher moments)
+              of the transmitted photon doses
             - total_photons: Number of photons simulated
             - transmitted_photons: Number of photons that passed through
+            - collisions: Number of interactions over all histories
+            - stats: Event counters and phase times (boundary crossings,
+              Compton/photoelectric, cutoff kills, ...), zero unless the
+              extension is built with SHIELD_LITE_INSTRUMENTATION
+            - depth_dose, depth_bin_edges: Energy deposited per depth bin
+              (MeV per photon) and the bin edges in cm (empty when off)
+            - spectrum, spectrum_bin_edges: Transmitted weight per energy bin
+              (per photon, sums to transmission_factor) and the edges in MeV
+            - secondary_transmission, secondary_dose_transmitted,
+              secondary_spectrum: the same for the annihilation and
+              fluorescence photons of set_secondary_physics, which are kept
+              out of transmission_factor, dose_transmitted and buildup_factor
+
+            The histograms are read-only NumPy views into the result, not
+            copies.
 
         Raises
         ------
-        RuntimeError
-            If no layers have been added to the shield
+        ValueError
+            If no layers have been added to the shield, if the engine
+            name is unknown, or if the variance reduction settings are
+            inconsistent
 
         Notes
         -----
@@ -196,7 +452,443 @@ class MonteCarloShieldSimulator:
         if self.simulator.get_num_layers() == 0:
             raise ValueError("No layers added to shield. Use add_layer() first.")
 
-        return self.simulator.run(source_energy_MeV, num_photons, source_area_cm2)
+        if variance_reduction is None:
+            variance_reduction = VarianceReduction()
+
+        if cache is not None:
+            return self._run_cached(cache, source_energy_MeV, num_photons, num_threads,
+                                    engine, variance_reduction, depth_bins, spectrum_bins,
+                                    processes, executor, workers)
+
+        if processes is not None or executor is not None:
+            config = self.cache_config(source_energy_MeV, engine, variance_reduction,
+                                       depth_bins, spectrum_bins)
+            tally, elapsed = run_tally_distributed(config, 0, num_photons, executor,
+                                                   processes, num_threads, workers)
+            return self.simulator.summarize(tally, num_photons, source_energy_MeV, elapsed)
+
+        return self.simulator.run(source_energy_MeV, num_photons, source_area_cm2,
+                                  num_threads, parse_engine(engine), variance_reduction,
+                                  MeshTallies(depth_bins, spectrum_bins))
+
+    def cache_config(self,
+                     source_energy_MeV: float,
+                     engine: str = "scalar",
+                     variance_reduction: Optional[VarianceReduction] = None,
+                     depth_bins: int = 0,
+                     spectrum_bins: int = 0) -> Dict:
+        """
+        Configuration that determines the result of run (the ResultCache key).
+
+        It holds the layer stack, the cross-section tables and secondary
+        physics of its materials, the source energy, seed, generator, engine, variance reduction and
+        mesh tallies; not the photon count, thread count or source area,
+        which do not change the tally of a given history.
+        """
+        if variance_reduction is None:
+            variance_reduction = VarianceReduction()
+        layers = {name: (values if name == 'material' else values.tolist())
+                  for name, values in self.get_layers().items()}
+        config = {
+            "source_energy_MeV": float(source_energy_MeV),
+            "layers": layers,
+            "cross_sections": {name: self._cross_sections[name]
+                               for name in sorted(set(layers['material']))
+                               if name in self._cross_sections},
+            "seed": self.seed,
+            "rng": self.rng,
+            "engine": engine.lower(),
+            "variance_reduction": {
+                "implicit_capture": variance_reduction.implicit_capture,
+                "roulette_weight": variance_reduction.roulette_weight,
+                "survival_weight": variance_reduction.survival_weight,
+                "split_weight": variance_reduction.split_weight,
+                "max_split": variance_reduction.max_split,
+                "stretch": list(variance_reduction.stretch),
+                "auto_stretch": variance_reduction.auto_stretch,
+            },
+            "depth_bins": depth_bins,
+            "spectrum_bins": spectrum_bins,
+        }
+        # Only when used: the keys of runs without secondaries are unchanged
+        secondary_physics = {name: self._secondary_physics[name]
+                             for name in sorted(set(layers['material']))
+                             if name in self._secondary_physics}
+        if secondary_physics:
+            config["secondary_physics"] = secondary_physics
+        return config
+
+    def _run_cached(self, cache, source_energy_MeV, num_photons, num_threads, engine,
+                    variance_reduction, depth_bins, spectrum_bins,
+                    processes=None, executor=None, workers=None) -> MonteCarloResult:
+        """run through a ResultCache: read the cached tally and top it up if needed."""
+        config = self.cache_config(source_energy_MeV, engine, variance_reduction,
+                                   depth_bins, spectrum_bins)
+        key = ResultCache.key(config)
+        entry = cache.load(key)
+        if entry is None:
+            tally, done, elapsed = TransportTally(), 0, 0.0
+        else:
+            tally = TransportTally.from_state(entry["tally"])
+            done, elapsed = entry["num_photons"], entry["elapsed_seconds"]
+
+        if done < num_photons:
+            if processes is not None or executor is not None:
+                missing, run_seconds = run_tally_distributed(
+                    config, done, num_photons - done, executor, processes, num_threads, workers)
+            else:
+                start = time.perf_counter()
+                missing = self.simulator.run_tally(
+                    source_energy_MeV, done, num_photons - done, num_threads,
+                    parse_engine(engine), variance_reduction,
+                    MeshTallies(depth_bins, spectrum_bins))
+                run_seconds = time.perf_counter() - start
+            tally.merge(missing)
+            elapsed += run_seconds
+            done = num_photons
+            cache.store(key, {"config": config, "num_photons": done,
+                              "elapsed_seconds": elapsed, "tally": tally.to_state()})
+
+        return self.simulator.summarize(tally, done, source_energy_MeV, elapsed)
+
+    def run_until(self,
+                  source_energy_MeV: float,
+                  target_relative_uncertainty: float = 0.01,
+                  max_seconds: Optional[float] = None,
+                  max_photons: int = 10_000_000,
+                  batch_photons: int = 10_000,
+                  num_threads: int = 1,
+                  engine: str = "scalar",
+                  variance_reduction: Optional[VarianceReduction] = None,
+                  depth_bins: int = 0,
+                  spectrum_bins: int = 0) -> MonteCarloResult:
+        """
+        Run the Monte Carlo simulation until a target uncertainty is reached.
+
+        Photons are simulated in batches; after each batch the relative
+        uncertainty of dose_transmitted is checked and the next batch size is
+        projected from the 1/sqrt(N) law. This replaces guessing num_photons
+        up front with estimate_required_photons.
+
+        Parameters
+        ----------
+        source_energy_MeV : float
+            Energy of the gamma ray source in MeV
+        target_relative_uncertainty : float, optional
+            Stop once relative_uncertainty <= this value (default: 0.01).
+            Use 0 to run until a budget is exhausted.
+        max_seconds : float, optional
+            Wall-clock budget in seconds (default: None, unlimited). Checked
+            between batches, so the run may overshoot by one batch.
+        max_photons : int, optional
+            Maximum number of histories (default: 10,000,000)
+        batch_photons : int, optional
+            Size of the first batch and minimum batch size (default: 10,000)
+        num_threads, engine, variance_reduction, depth_bins, spectrum_bins :
+            Same as run()
+
+        Returns
+        -------
+        MonteCarloResult
+            Same fields as run(); total_photons is the number of histories
+            actually used and converged tells whether the target was reached.
+
+        Raises
+        ------
+        ValueError
+            If no layers have been added, or if an argument is invalid
+        """
+        if self.simulator.get_num_layers() == 0:
+            raise ValueError("No layers added to shield. Use add_layer() first.")
+
+        stopping = StoppingCriteria(
+            target_relative_uncertainty=target_relative_uncertainty,
+            max_seconds=0.0 if max_seconds is None else max_seconds,
+            max_photons=max_photons,
+            batch_photons=batch_photons,
+        )
+        if variance_reduction is None:
+            variance_reduction = VarianceReduction()
+
+        return self.simulator.run_until(source_energy_MeV, stopping, num_threads,
+                                        parse_engine(engine), variance_reduction,
+                                        MeshTallies(depth_bins, spectrum_bins))
+
+    def start_run(self,
+                  source_energy_MeV: float,
+                  num_photons: int = 100000,
+                  num_threads: int = 1,
+                  engine: str = "scalar",
+                  variance_reduction: Optional[VarianceReduction] = None,
+                  depth_bins: int = 0,
+                  spectrum_bins: int = 0) -> AsyncRun:
+        """
+        Start run() on a background native thread and return its handle.
+
+        The call returns at once; the histories run on num_threads native
+        workers without the GIL, so the calling thread (e.g. an API server)
+        stays free.
+
+        Parameters
+        ----------
+        source_energy_MeV, num_photons, num_threads, engine, variance_reduction, depth_bins, spectrum_bins :
+            Same as run()
+
+        Returns
+        -------
+        AsyncRun
+            Handle with the progress (histories_done, relative_uncertainty,
+            elapsed_seconds), cancel() (cooperative: the chunks in flight
+            finish, then result() raises RunCancelled), wait(timeout) and
+            result(). The result is the one run() would have returned.
+
+        Raises
+        ------
+        ValueError
+            If no layers have been added, or if the configuration is invalid
+        """
+        if self.simulator.get_num_layers() == 0:
+            raise ValueError("No layers added to shield. Use add_layer() first.")
+        if variance_reduction is None:
+            variance_reduction = VarianceReduction()
+
+        return self.simulator.start_run(source_energy_MeV, num_photons, num_threads,
+                                        parse_engine(engine), variance_reduction,
+                                        MeshTallies(depth_bins, spectrum_bins))
+
+    async def run_async(self,
+                        source_energy_MeV: float,
+                        num_photons: int = 100000,
+                        num_threads: int = 1,
+                        engine: str = "scalar",
+                        variance_reduction: Optional[VarianceReduction] = None,
+                        depth_bins: int = 0,
+                        spectrum_bins: int = 0,
+                        progress: Optional[Callable[[AsyncRun], None]] = None,
+                        poll_interval: float = 0.1) -> MonteCarloResult:
+        """
+        Awaitable run(): ``result = await sim.run_async(1.0, 10**7)``.
+
+        The run goes through start_run and the event loop polls it every
+        poll_interval seconds, so other tasks keep running meanwhile.
+        Cancelling the awaiting task cancels the run.
+
+        Parameters
+        ----------
+        source_energy_MeV, num_photons, num_threads, engine, variance_reduction, depth_bins, spectrum_bins :
+            Same as run()
+        progress : callable, optional
+            Called with the AsyncRun handle at every poll, e.g. to report
+            handle.histories_done and handle.relative_uncertainty
+        poll_interval : float, optional
+            Seconds between polls (default: 0.1)
+
+        Returns
+        -------
+        MonteCarloResult
+            Same as run()
+
+        Raises
+        ------
+        asyncio.CancelledError
+            If the task is cancelled (the run is cancelled with it)
+        RunCancelled
+            If the run is cancelled through its handle, e.g. by the
+            progress callback
+        """
+        handle = self.start_run(source_energy_MeV, num_photons, num_threads, engine,
+                                variance_reduction, depth_bins, spectrum_bins)
+        try:
+            while not handle.done():
+                if progress is not None:
+                    progress(handle)
+                await asyncio.sleep(poll_interval)
+        except asyncio.CancelledError:
+            handle.cancel()
+            raise
+        if progress is not None:
+            progress(handle)
+        return handle.result()
+
+    def run_checkpointed(self,
+                         source_energy_MeV: float,
+                         checkpoint_path: str,
+                         num_photons: int,
+                         checkpoint_photons: int = 10_000_000,
+                         first_history: int = 0,
+                         num_threads: int = 1,
+                         engine: str = "scalar",
+                         variance_reduction: Optional[VarianceReduction] = None,
+                         depth_bins: int = 0,
+                         spectrum_bins: int = 0) -> MonteCarloResult:
+        """
+        Run a long simulation that survives interruptions.
+
+        The tally and the random stream position are saved to checkpoint_path
+        (a small binary file, written atomically) every checkpoint_photons
+        histories. Calling again with the same arguments after the job was
+        killed resumes after the last saved history, and gives the same
+        result as an uninterrupted run; a finished checkpoint is read back
+        without running anything.
+
+        To split a run across processes or nodes, give each one a disjoint
+        range with first_history (e.g. node k runs
+        ``first_history=k * num_photons``) and its own checkpoint_path, then
+        combine the files with merge_checkpoints.
+
+        Parameters
+        ----------
+        source_energy_MeV : float
+            Energy of the gamma ray source in MeV
+        checkpoint_path : str
+            Checkpoint file (created, or resumed if it exists)
+        num_photons : int
+            Histories of this range (may exceed 2**31)
+        checkpoint_photons : int, optional
+            Histories between checkpoints (default: 10,000,000)
+        first_history : int, optional
+            Index of the first history of the range (default: 0)
+        num_threads, engine, variance_reduction, depth_bins, spectrum_bins :
+            Same as run
+
+        Returns
+        -------
+        MonteCarloResult
+            Result of the range; with first_history=0 it is the first run of
+            a simulator with this seed. stats counters are zero.
+
+        Raises
+        ------
+        ValueError
+            If checkpoint_path holds a checkpoint of another configuration
+            or range
+        """
+        if self.simulator.get_num_layers() == 0:
+            raise ValueError("No layers added to shield. Use add_layer() first.")
+        if variance_reduction is None:
+            variance_reduction = VarianceReduction()
+
+        return self.simulator.run_checkpointed(
+            source_energy_MeV, str(checkpoint_path), num_photons, checkpoint_photons,
+            first_history, num_threads, parse_engine(engine), variance_reduction,
+            MeshTallies(depth_bins, spectrum_bins))
+
+    def merge_checkpoints(self, checkpoint_paths: List[str]) -> MonteCarloResult:
+        """
+        Combine the checkpoints of disjoint ranges of one run into a result.
+
+        The parts may be complete or not: every tallied history counts, and
+        total_photons is their sum. The result is summarized with this
+        simulator's layers (the buildup factor reference), which should be
+        those of the run.
+
+        Raises
+        ------
+        ValueError
+            If the checkpoints come from different runs or configurations,
+            or if their history ranges overlap
+        """
+        return self.simulator.merge_checkpoints([str(path) for path in checkpoint_paths])
+
+    def run_batch(self,
+                  layer_offsets,
+                  material_ids,
+                  thickness_cm,
+                  energy_MeV,
+                  num_photons,
+                  materials,
+                  num_threads: int = 0,
+                  engine: str = "scalar",
+                  variance_reduction: Optional[VarianceReduction] = None) -> np.ndarray:
+        """
+        Simulate many shield configurations in a single native call.
+
+        Configurations are packed into flat arrays and scheduled over a
+        thread pool in C++, which removes the per-simulation Python overhead
+        (simulator creation, add_layer calls, layer copies). The layers added
+        with add_layer are not used.
+
+        Parameters
+        ----------
+        layer_offsets : array-like of int, shape (n_configs + 1,)
+            Configuration c uses layers layer_offsets[c]:layer_offsets[c + 1]
+        material_ids : array-like of int, shape (n_layers,)
+            Index into ``materials`` of each layer
+        thickness_cm : array-like of float, shape (n_layers,)
+            Thickness of each layer in cm
+        energy_MeV : float or array-like, shape (n_configs,)
+            Source energy of each configuration
+        num_photons : int or array-like, shape (n_configs,)
+            Histories of each configuration
+        materials : list of dict, or dict of arrays
+            One dict per material id with the keys of add_layer:
+            'material_name', 'mu_total', 'mu_compton', 'mu_photoelectric',
+            'density_g_cm3'; or a single dict of columns with the same keys
+            (a list of names and one array per coefficient, indexed by
+            material id), passed to C++ without per-material conversion.
+            Tables set with set_cross_sections are used for matching names.
+        num_threads : int, optional
+            Worker threads (default: 0 = all cores)
+        engine : str, optional
+            Transport kernel, "scalar" (default), "batched" or "gpu" (the
+            configurations run one after another on the device, each in one
+            launch sequence; num_threads is ignored)
+        variance_reduction : VarianceReduction, optional
+            Applied to every configuration (use auto_stretch, not stretch)
+
+        Returns
+        -------
+        numpy.ndarray
+            Structured array with one row per configuration and the fields
+            transmission_factor, transmission_uncertainty, dose_transmitted,
+            dose_absorbed, buildup_factor, uncertainty, relative_uncertainty,
+            elapsed_seconds, total_photons, transmitted_photons. The C++
+            workers write the rows in place and ``results[field]`` is a
+            strided view, so no Python object is created per result.
+            Results depend on the seed and the configuration index only,
+            not on num_threads or on the scheduling.
+
+        Raises
+        ------
+        ValueError
+            If the arrays are inconsistent, a material id is out of range or
+            the engine cannot run (engine="gpu" without a device or Philox)
+        RuntimeError
+            If a CUDA call fails during a GPU run (e.g. out of device memory)
+        """
+        if engine.lower() == "gpu":
+            if not gpu_available():
+                raise ValueError("The GPU engine needs a build with SHIELD_LITE_CUDA and a CUDA device")
+            if self.rng != "philox":
+                raise ValueError("The GPU engine requires the Philox generator")
+        layer_offsets = np.asarray(layer_offsets, dtype=np.int64)
+        n_configs = len(layer_offsets) - 1
+        energy = np.broadcast_to(np.asarray(energy_MeV, dtype=np.float64), (n_configs,))
+        photons = np.broadcast_to(np.asarray(num_photons, dtype=np.int32), (n_configs,))
+        if variance_reduction is None:
+            variance_reduction = VarianceReduction()
+        if isinstance(materials, dict):
+            columns = materials
+        else:
+            columns = {key: [m[key] for m in materials]
+                       for key in ('material_name', 'mu_total', 'mu_compton',
+                                   'mu_photoelectric', 'density_g_cm3')}
+
+        return self.simulator.run_batch(
+            layer_offsets,
+            np.asarray(material_ids, dtype=np.int32),
+            np.asarray(thickness_cm, dtype=np.float64),
+            np.ascontiguousarray(energy),
+            np.ascontiguousarray(photons),
+            np.asarray(columns['mu_total'], dtype=np.float64),
+            np.asarray(columns['mu_compton'], dtype=np.float64),
+            np.asarray(columns['mu_photoelectric'], dtype=np.float64),
+            np.asarray(columns['density_g_cm3'], dtype=np.float64),
+            list(columns['material_name']),
+            num_threads,
+            parse_engine(engine),
+            variance_reduction,
+        )
 
     def get_shield_info(self) -> List[Dict]:
         """
@@ -206,8 +898,27 @@ class MonteCarloShieldSimulator:
         -------
         list of dict
             List of dictionaries containing information about each layer
+            (keys 'material', 'thickness_cm', 'mu_total', 'mu_compton',
+            'mu_photoelectric', 'density_g_cm3'); get_layers gives the
+            same data as arrays
         """
-        return self._layers_info.copy()
+        layers = self.get_layers()
+        keys = list(layers)
+        columns = [layers[key] if key == 'material' else layers[key].tolist() for key in keys]
+        return [dict(zip(keys, values)) for values in zip(*columns)]
+
+    def get_layers(self) -> Dict:
+        """
+        Get the shield layers as columns.
+
+        Returns
+        -------
+        dict
+            'material' (list of str) and one NumPy array per property:
+            'thickness_cm', 'mu_total', 'mu_compton', 'mu_photoelectric',
+            'density_g_cm3' (the constant coefficients of add_layer)
+        """
+        return self.simulator.get_layers()
 
     def get_total_thickness(self) -> float:
         """
@@ -218,11 +929,12 @@ class MonteCarloShieldSimulator:
         float
             Total thickness in cm
         """
-        return sum(layer['thickness_cm'] for layer in self._layers_info)
+        return float(self.get_layers()['thickness_cm'].sum())
 
     def compare_with_analytical(self,
                                source_energy_MeV: float,
-                               num_photons: int = 100000) -> Dict:
+                               num_photons: int = 100000,
+                               buildup: Optional[Dict[str, BuildupTable]] = None) -> Dict:
         """
         Run Monte Carlo simulation and compare with analytical exponential model.
 
@@ -235,6 +947,13 @@ class MonteCarloShieldSimulator:
             Energy of the gamma ray source in MeV
         num_photons : int, optional
             Number of photons to simulate (default: 100000)
+        buildup : dict of str to BuildupTable, optional
+            G-P buildup tables by material name. When given, the result also
+            holds the point-kernel estimate (uncollided attenuation times
+            Broder's multilayer buildup factor); materials without a table
+            only attenuate. G-P factors are fitted for a point isotropic
+            source in an infinite medium, so they bound rather than match
+            the slab Monte Carlo buildup.
 
         Returns
         -------
@@ -244,37 +963,51 @@ class MonteCarloShieldSimulator:
             - 'analytical_transmission': Simple exponential prediction
             - 'buildup_factor': Ratio of MC to analytical
             - 'difference_percent': Percentage difference
+            - 'point_kernel_transmission', 'point_kernel_buildup': Point-kernel
+              estimate and its buildup factor (only with buildup)
         """
         # Run Monte Carlo
         mc_result = self.run(source_energy_MeV, num_photons)
 
         # Calculate analytical prediction (simple Beer-Lambert law)
-        total_mu_thickness = sum(
-            layer['mu_total'] * layer['thickness_cm']
-            for layer in self._layers_info
-        )
+        layers = self.get_layers()
+        total_mu_thickness = float(np.dot(layers['mu_total'], layers['thickness_cm']))
         analytical_transmission = np.exp(-total_mu_thickness)
 
         # Calculate difference
         if analytical_transmission > 0:
-            buildup = mc_result.transmission_factor / analytical_transmission
+            buildup_factor = mc_result.transmission_factor / analytical_transmission
             difference_percent = (
                 (mc_result.transmission_factor - analytical_transmission)
                 / analytical_transmission * 100
             )
         else:
-            buildup = float('inf')
+            buildup_factor = float('inf')
             difference_percent = float('inf')
 
-        return {
+        comparison = {
             'monte_carlo': mc_result,
             'analytical_transmission': analytical_transmission,
-            'buildup_factor': buildup,
+            'buildup_factor': buildup_factor,
             'difference_percent': difference_percent,
             'mc_transmission': mc_result.transmission_factor,
             'mc_uncertainty': mc_result.uncertainty
         }
 
+        if buildup is not None:
+            # One design whose columns are the layers, in order from the source
+            point_kernel, _ = evaluate_shields(
+                layers['thickness_cm'][np.newaxis, :], layers['mu_total'],
+                layers['density_g_cm3'], num_threads=1,
+                buildup=[buildup.get(name) for name in layers['material']],
+                energy_MeV=source_energy_MeV)
+            comparison['point_kernel_transmission'] = float(point_kernel[0])
+            comparison['point_kernel_buildup'] = (
+                float(point_kernel[0]) / analytical_transmission
+                if analytical_transmission > 0 else float('inf'))
+
+        return comparison
+
 
 def estimate_required_photons(desired_uncertainty: float = 0.01,
                              expected_transmission: float = 0.1) -> int:
@@ -296,7 +1029,8 @@ def estimate_required_photons(desired_uncertainty: float = 0.01,
     Notes
     -----
     This uses the statistical formula: uncertainty ~ 1/sqrt(N_detected)
-    where N_detected = N_total * transmission_factor
+    where N_detected = N_total * transmission_factor. To stop exactly when
+    the target is reached, use MonteCarloShieldSimulator.run_until instead.
     """
     # Statistical uncertainty scales as 1/sqrt(N_detected)
     # N_detected = N_total * transmission
@@ -0,0 +1,100 @@
+"""
+Persistent cache of Monte Carlo results keyed by the shield configuration.
+
+Each entry holds the raw tally of the first histories of a run (see
+``MonteCarloSimulator.run_tally``) for one configuration: layer stack,
+cross-section tables, source energy, seed, generator, engine, variance
+reduction and mesh tallies. The key is the SHA-256 of the canonical JSON of
+that configuration, so repeating a query reads the stored tally instead of
+running it again, and asking for more photons only runs the missing
+histories and merges them into the stored tally.
+"""
+
+import hashlib
+import json
+import os
+import tempfile
+from pathlib import Path
+from typing import Dict, Optional, Union
+
+# Bump when a change to the transport alters the results for a given seed:
+# entries written with another format are ignored.
+CACHE_FORMAT = 1
+
+
+class ResultCache:
+    """
+    Directory of cached tallies, one JSON file per configuration.
+
+    Entries are written atomically (temporary file then rename), so several
+    processes can share a directory; concurrent top-ups of the same entry
+    keep the last one written. Floats are stored with their exact repr, so a
+    cached result is bit-identical to the run that produced it.
+
+    Examples
+    --------
+    >>> cache = ResultCache("~/.cache/shield_lite")
+    >>> result = sim.run(1.0, num_photons=100000, cache=cache)   # runs
+    >>> result = sim.run(1.0, num_photons=100000, cache=cache)   # reads
+    >>> result = sim.run(1.0, num_photons=400000, cache=cache)   # runs 300000 more
+    """
+
+    def __init__(self, directory: Union[str, os.PathLike]):
+        """
+        Parameters
+        ----------
+        directory : str or path-like
+            Directory of the entries (created if missing)
+        """
+        self.directory = Path(directory).expanduser()
+        self.directory.mkdir(parents=True, exist_ok=True)
+
+    @staticmethod
+    def key(config: Dict) -> str:
+        """SHA-256 of the canonical JSON of a configuration."""
+        canonical = json.dumps({"format": CACHE_FORMAT, "config": config},
+                               sort_keys=True, separators=(",", ":"))
+        return hashlib.sha256(canonical.encode("utf-8")).hexdigest()
+
+    def _path(self, key: str) -> Path:
+        return self.directory / f"{key}.json"
+
+    def load(self, key: str) -> Optional[Dict]:
+        """
+        Entry stored under key, or None if there is none (or it is unreadable
+        or from another cache format).
+
+        An entry is a dict with the configuration (``config``), the number of
+        histories (``num_photons``), the accumulated run time
+        (``elapsed_seconds``) and the tally state (``tally``).
+        """
+        try:
+            with open(self._path(key), encoding="utf-8") as f:
+                entry = json.load(f)
+        except (OSError, ValueError):
+            return None
+        if not isinstance(entry, dict) or entry.get("format") != CACHE_FORMAT:
+            return None
+        return entry
+
+    def store(self, key: str, entry: Dict) -> None:
+        """Write an entry under key, replacing any previous one."""
+        fd, tmp_path = tempfile.mkstemp(dir=self.directory, prefix=".", suffix=".tmp")
+        try:
+            with os.fdopen(fd, "w", encoding="utf-8") as f:
+                json.dump({"format": CACHE_FORMAT, **entry}, f)
+            os.replace(tmp_path, self._path(key))
+        except BaseException:
+            os.unlink(tmp_path)
+            raise
+
+    def clear(self) -> None:
+        """Remove every entry."""
+        for path in self.directory.glob("*.json"):
+            path.unlink()
+
+    def __contains__(self, key: str) -> bool:
+        return self.load(key) is not None
+
+    def __len__(self) -> int:
+        return sum(1 for _ in self.directory.glob("*.json"))
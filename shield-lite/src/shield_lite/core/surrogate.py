@@ -0,0 +1,259 @@
+"""
+Surrogate model of the Monte Carlo transmission, with a Monte Carlo fallback.
+
+An ensemble of small MLPs trained on Monte Carlo results (ml/surrogate.py)
+predicts ln(transmission) of a layer stack in microseconds, evaluated
+natively by ``SurrogateEnsemble``. The spread of the members estimates the
+relative uncertainty of the prediction, and inputs outside the box of the
+training set (or materials the model does not know) are flagged as novel.
+``SurrogateModel.estimate`` runs a real Monte Carlo simulation
+(``MonteCarloShieldSimulator.run_batch``) for the rows whose uncertainty
+exceeds a threshold or which are novel, and hands those results to a
+callback so they can be added to the training data.
+
+Features: the source energy, then for each of max_layers slots (layers of
+positive thickness, in order from the source) the thickness in cm in the
+channel of its material, zero elsewhere.
+"""
+
+import json
+from typing import Any, Callable, Dict, List, Optional, Sequence, Tuple
+
+import numpy as np
+
+from .monte_carlo import MonteCarloShieldSimulator
+from shield_lite._monte_carlo import SurrogateEnsemble
+
+# Material properties needed by the Monte Carlo fallback
+PROPERTIES = ('mu_total', 'mu_compton', 'mu_photoelectric', 'density_g_cm3')
+
+
+class SurrogateModel:
+    """
+    Transmission surrogate with uncertainty and novelty detection.
+
+    Parameters
+    ----------
+    materials : dict
+        Material name -> dict of PROPERTIES, in channel order (the materials
+        the model was trained on)
+    max_layers : int
+        Layer slots of the features
+    input_shift, input_scale : array-like
+        Standardization of the features, (x - shift) / scale
+    lower, upper : array-like
+        Per-feature range of the training set; rows outside are novel
+    members : list of list of (weights, bias)
+        Layers of each MLP of the ensemble (weights of shape (outputs, inputs))
+    """
+
+    def __init__(self,
+                 materials: Dict[str, Dict[str, float]],
+                 max_layers: int,
+                 input_shift: Sequence[float],
+                 input_scale: Sequence[float],
+                 lower: Sequence[float],
+                 upper: Sequence[float],
+                 members: List[List[Tuple[np.ndarray, np.ndarray]]]):
+        self.materials = {name: {key: float(props[key]) for key in PROPERTIES}
+                          for name, props in materials.items()}
+        self.max_layers = int(max_layers)
+        self.input_shift = np.asarray(input_shift, dtype=np.float64)
+        self.input_scale = np.asarray(input_scale, dtype=np.float64)
+        self.lower = np.asarray(lower, dtype=np.float64)
+        self.upper = np.asarray(upper, dtype=np.float64)
+        self.members = [[(np.asarray(w, dtype=np.float64), np.asarray(b, dtype=np.float64))
+                         for w, b in member] for member in members]
+        if len(self.lower) != self.num_features or len(self.upper) != self.num_features:
+            raise ValueError(f"lower and upper need {self.num_features} entries")
+        self.ensemble = SurrogateEnsemble(list(self.input_shift), list(self.input_scale),
+                                          self.members)
+        if self.ensemble.num_inputs != self.num_features:
+            raise ValueError(f"The members take {self.ensemble.num_inputs} inputs, "
+                             f"expected {self.num_features}")
+
+    @property
+    def num_features(self) -> int:
+        return 1 + self.max_layers * len(self.materials)
+
+    def save(self, path) -> None:
+        """Write the model to a .npz file."""
+        arrays = {
+            'materials': np.array(json.dumps(self.materials)),
+            'max_layers': np.array(self.max_layers),
+            'input_shift': self.input_shift,
+            'input_scale': self.input_scale,
+            'lower': self.lower,
+            'upper': self.upper,
+            'num_layers': np.array([len(member) for member in self.members]),
+        }
+        for k, member in enumerate(self.members):
+            for l, (w, b) in enumerate(member):
+                arrays[f'member{k}_weight{l}'] = w
+                arrays[f'member{k}_bias{l}'] = b
+        np.savez(path, **arrays)
+
+    @classmethod
+    def load(cls, path) -> 'SurrogateModel':
+        """Read a model written by save."""
+        with np.load(path) as data:
+            members = [[(data[f'member{k}_weight{l}'], data[f'member{k}_bias{l}'])
+                        for l in range(n)] for k, n in enumerate(data['num_layers'])]
+            return cls(json.loads(str(data['materials'])), int(data['max_layers']),
+                       data['input_shift'], data['input_scale'],
+                       data['lower'], data['upper'], members)
+
+    def features(self, energy_MeV, layer_offsets, material_names,
+                 thickness_cm) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Feature rows of packed configurations (layout of run_batch, with
+        material names instead of ids).
+
+        Returns
+        -------
+        (features, supported) : numpy.ndarray
+            Features of shape (n_configs, num_features), and False for the
+            configurations with an unknown material or more than max_layers
+            layers of positive thickness
+        """
+        offsets = np.asarray(layer_offsets, dtype=np.int64)
+        n = len(offsets) - 1
+        energy = np.broadcast_to(np.asarray(energy_MeV, dtype=np.float64), (n,))
+        thickness = np.asarray(thickness_cm, dtype=np.float64)
+        names, inverse = np.unique(np.asarray(material_names), return_inverse=True)
+        index = {name: i for i, name in enumerate(self.materials)}
+        channel = np.array([index.get(name, -1) for name in names], dtype=np.int64)[inverse]
+
+        counts = np.diff(offsets)
+        config = np.repeat(np.arange(n), counts)
+        positive = thickness > 0
+        # Slot of a layer: positive layers before it in its configuration
+        before = np.cumsum(positive) - positive
+        slot = before - np.repeat(np.concatenate(([0], np.cumsum(positive)))[offsets[:-1]], counts)
+
+        unknown = positive & (channel < 0)
+        supported = ((np.bincount(config[positive], minlength=n) <= self.max_layers) &
+                     (np.bincount(config[unknown], minlength=n) == 0))
+
+        features = np.zeros((n, self.num_features))
+        features[:, 0] = energy
+        use = positive & (channel >= 0) & (slot < self.max_layers)
+        features[config[use], 1 + slot[use] * len(self.materials) + channel[use]] = thickness[use]
+        return features, supported
+
+    def predict(self, energy_MeV, layer_offsets, material_names, thickness_cm,
+                num_threads: int = 0) -> Tuple[np.ndarray, np.ndarray, np.ndarray]:
+        """
+        Surrogate estimate only.
+
+        Returns
+        -------
+        (transmission, relative_uncertainty, novel) : numpy.ndarray
+            Predicted transmission factor, spread of the members in
+            ln(transmission) (a relative uncertainty), and True for rows
+            outside the training range or not supported by the model
+        """
+        features, supported = self.features(energy_MeV, layer_offsets, material_names,
+                                            thickness_cm)
+        log_transmission, spread = self.ensemble.evaluate(features, num_threads)
+        novel = ~supported | np.any((features < self.lower) | (features > self.upper), axis=1)
+        return np.exp(log_transmission), spread, novel
+
+    def estimate(self,
+                 energy_MeV,
+                 layer_offsets,
+                 material_names,
+                 thickness_cm,
+                 max_uncertainty: float = 0.05,
+                 num_photons: int = 20000,
+                 materials: Optional[Dict[str, Dict[str, float]]] = None,
+                 on_fallback: Optional[Callable[[Dict[str, Any]], None]] = None,
+                 seed: int = 0,
+                 num_threads: int = 0,
+                 engine: str = "scalar") -> Dict[str, np.ndarray]:
+        """
+        Transmission of packed configurations, from the surrogate when it is
+        confident and from Monte Carlo otherwise.
+
+        Parameters
+        ----------
+        energy_MeV : float or array-like, shape (n_configs,)
+            Source energy of each configuration
+        layer_offsets : array-like of int, shape (n_configs + 1,)
+            Configuration c uses layers layer_offsets[c]:layer_offsets[c + 1]
+        material_names : array-like of str, shape (n_layers,)
+            Material of each layer, in order from the source
+        thickness_cm : array-like of float, shape (n_layers,)
+            Thickness of each layer in cm
+        max_uncertainty : float
+            Rows whose predicted relative uncertainty exceeds this, and novel
+            rows, are simulated (0 simulates every row, inf none)
+        num_photons : int
+            Histories of each fallback run
+        materials : dict, optional
+            Properties (PROPERTIES) of materials unknown to the model, for the
+            fallback; the model's own materials are used otherwise
+        on_fallback : callable, optional
+            Called once with the fallback configurations and their results:
+            a dict with 'energy_MeV', 'layer_offsets', 'material_names',
+            'thickness_cm' and 'results' (the array of run_batch)
+        seed, num_threads, engine :
+            As MonteCarloShieldSimulator.run_batch
+
+        Returns
+        -------
+        dict of numpy.ndarray
+            'transmission', 'relative_uncertainty' (member spread, or the
+            Monte Carlo one for simulated rows) and 'fallback' (True for the
+            simulated rows)
+
+        Raises
+        ------
+        ValueError
+            If a simulated row uses a material without properties
+        """
+        offsets = np.asarray(layer_offsets, dtype=np.int64)
+        energy = np.broadcast_to(np.asarray(energy_MeV, dtype=np.float64), (len(offsets) - 1,))
+        names = np.asarray(material_names)
+        thickness = np.asarray(thickness_cm, dtype=np.float64)
+        transmission, uncertainty, novel = self.predict(energy, offsets, names, thickness,
+                                                        num_threads)
+        fallback = novel | (uncertainty > max_uncertainty)
+
+        rows = np.flatnonzero(fallback)
+        if rows.size:
+            # Pack the layers of the fallback rows
+            counts = np.diff(offsets)[rows]
+            fallback_offsets = np.concatenate(([0], np.cumsum(counts)))
+            layers = (np.repeat(offsets[rows] - fallback_offsets[:-1], counts) +
+                      np.arange(fallback_offsets[-1]))
+            properties = dict(self.materials)
+            properties.update(materials or {})
+            used, material_ids = np.unique(names[layers], return_inverse=True)
+            missing = [name for name in used if name not in properties]
+            if missing:
+                raise ValueError(f"No material properties for the Monte Carlo fallback: {missing}")
+
+            results = MonteCarloShieldSimulator(seed=seed).run_batch(
+                fallback_offsets, material_ids, thickness[layers], energy[rows], num_photons,
+                materials=[dict(properties[name], material_name=str(name)) for name in used],
+                num_threads=num_threads, engine=engine)
+
+            factor = results['transmission_factor']
+            transmission[rows] = factor
+            uncertainty[rows] = np.divide(results['transmission_uncertainty'], factor,
+                                          out=np.full(len(rows), np.inf), where=factor > 0)
+            if on_fallback is not None:
+                on_fallback({
+                    'energy_MeV': energy[rows],
+                    'layer_offsets': fallback_offsets,
+                    'material_names': names[layers],
+                    'thickness_cm': thickness[layers],
+                    'results': results,
+                })
+
+        return {
+            'transmission': transmission,
+            'relative_uncertainty': uncertainty,
+            'fallback': fallback,
+        }
@@ -0,0 +1,68 @@
+#include "async_run.h"
+
+namespace shield_lite {
+
+AsyncRun::AsyncRun(PhotonTransport transport, uint64_t run_key, double source_energy_MeV,
+                   int num_photons, int num_threads, TransportEngine engine)
+    : transport_(std::move(transport)), run_key_(run_key), source_energy_MeV_(source_energy_MeV),
+      num_photons_(num_photons), num_threads_(num_threads), engine_(engine),
+      start_time_(std::chrono::steady_clock::now()), thread_(&AsyncRun::execute, this) {}
+
+AsyncRun::~AsyncRun() {
+    control_.cancel();
+    thread_.join();
+}
+
+void AsyncRun::execute() {
+    MonteCarloResult result;
+    std::exception_ptr error;
+    try {
+        TransportTally tally = transport_.runHistories(run_key_, 0, source_energy_MeV_, num_photons_,
+                                                       num_threads_, engine_, &control_);
+        const double elapsed =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+        result = transport_.summarize(tally, num_photons_, source_energy_MeV_, elapsed);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    result_ = std::move(result);
+    error_ = error;
+    elapsed_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+    done_ = true;
+    finished_.notify_all();
+}
+
+bool AsyncRun::done() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return done_;
+}
+
+double AsyncRun::elapsedSeconds() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (done_) {
+        return elapsed_seconds_;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+}
+
+bool AsyncRun::wait(double timeout_seconds) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (timeout_seconds < 0) {
+        finished_.wait(lock, [this] { return done_; });
+        return true;
+    }
+    return finished_.wait_for(lock, std::chrono::duration<double>(timeout_seconds), [this] { return done_; });
+}
+
+MonteCarloResult AsyncRun::result() const {
+    wait();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    return result_;
+}
+
+} // namespace shield_lite
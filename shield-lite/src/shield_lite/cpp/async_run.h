@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "photon_transport.h"
+
+namespace shield_lite {
+
+// Simulation running on a background thread (MonteCarloSimulator::startRun)
+// over the usual work-stealing workers. The caller polls its progress,
+// cancels it cooperatively (the chunks in flight finish, no new chunk
+// starts) and waits for the result without holding any lock.
+class AsyncRun {
+public:
+    // Run histories [0, num_photons) of run_key with a prepared transport
+    // (its own copy, so the simulator can be reconfigured meanwhile)
+    AsyncRun(PhotonTransport transport, uint64_t run_key, double source_energy_MeV,
+             int num_photons, int num_threads, TransportEngine engine);
+
+    // Cancels a run still in progress and waits for it
+    ~AsyncRun();
+
+    AsyncRun(const AsyncRun&) = delete;
+    AsyncRun& operator=(const AsyncRun&) = delete;
+
+    void cancel() { control_.cancel(); }
+    bool cancelRequested() const { return control_.cancelled(); }
+    bool done() const;
+
+    int numPhotons() const { return num_photons_; }
+    long long historiesDone() const { return control_.historiesDone(); }
+    double relativeUncertainty() const { return control_.relativeUncertainty(); }
+
+    // Seconds since the start (the run time once done)
+    double elapsedSeconds() const;
+
+    // Wait until the run is done or timeout_seconds passed (< 0: no limit);
+    // true if it is done
+    bool wait(double timeout_seconds = -1.0) const;
+
+    // Wait for the run: its result, or the error it ended with
+    // (RunCancelled if it was cancelled first)
+    MonteCarloResult result() const;
+
+private:
+    void execute();
+
+    PhotonTransport transport_;
+    const uint64_t run_key_;
+    const double source_energy_MeV_;
+    const int num_photons_;
+    const int num_threads_;
+    const TransportEngine engine_;
+    const std::chrono::steady_clock::time_point start_time_;
+
+    RunControl control_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable finished_;
+    bool done_ = false;
+    double elapsed_seconds_ = 0.0;
+    MonteCarloResult result_;
+    std::exception_ptr error_;
+
+    std::thread thread_;   // Last: started once the other members are ready
+};
+
+} // namespace shield_lite
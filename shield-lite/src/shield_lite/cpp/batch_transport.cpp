@@ -0,0 +1,445 @@
+#include "photon_transport.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Batched photon transport: a structure-of-arrays alternative to
+// PhotonTransport::transportPhoton. Every iteration advances all live
+// photons of the batch by one step (free flight to a collision or to the
+// boundary ahead) with a SIMD kernel, then a scalar pass resolves layer
+// changes, tallies the histories that ended and compacts the survivors.
+// Free slots are refilled from the source so the lanes stay busy.
+// When no layer has an energy-dependent table the kernel also carries the
+// photons across the boundaries (the coefficients of a layer are then
+// known without a lookup), so a step always ends with a collision or an
+// escape and laminates no longer go through the scalar pass per layer.
+
+namespace shield_lite {
+
+namespace {
+
+constexpr int kBatchSize = 1024;
+constexpr double ENERGY_CUTOFF_MEV = 0.01;
+constexpr double INV_ELECTRON_REST_MASS = 1.0 / ELECTRON_REST_MASS_MEV;
+constexpr double TWO_PI = 6.28318530717958647693;
+
+// Step outcome stored per lane by the vector pass
+constexpr uint8_t EVENT_COLLISION = 1;
+constexpr uint8_t EVENT_COMPTON = 2;
+constexpr uint8_t EVENT_KAHN = 4;           // Compton outside the table: angle left to the scalar pass
+
+// Photon lanes, padded by one vector width so the kernel never needs a tail loop
+struct PhotonBatch {
+    std::vector<double> energy, z, dz, weight;
+    std::vector<double> mu, p_compton;     // Coefficients at the lane energy and layer
+    std::vector<int32_t> layer;
+    std::vector<double> u_path, u_type, u_angle, u_phi, u_roulette;
+    std::vector<double> deposit;
+    std::vector<uint8_t> event;
+    std::vector<uint64_t> history;         // Source history of the lane (counter-based streams)
+    std::vector<uint32_t> position;        // Next block of that history's stream
+    int size = 0;
+    long long crossings = 0;               // Boundaries crossed inside the kernel (instrumented builds)
+
+    PhotonBatch()
+        : energy(kBatchSize + simd::kWidth, 1.0), z(kBatchSize + simd::kWidth, 0.0),
+          dz(kBatchSize + simd::kWidth, 1.0), weight(kBatchSize + simd::kWidth, 0.0),
+          mu(kBatchSize + simd::kWidth, 1.0), p_compton(kBatchSize + simd::kWidth, 0.0),
+          layer(kBatchSize + simd::kWidth, 0),
+          u_path(kBatchSize + simd::kWidth, 0.5), u_type(kBatchSize + simd::kWidth, 0.5),
+          u_angle(kBatchSize + simd::kWidth, 0.5), u_phi(kBatchSize + simd::kWidth, 0.5),
+          u_roulette(kBatchSize + simd::kWidth, 0.5),
+          deposit(kBatchSize + simd::kWidth, 0.0), event(kBatchSize + simd::kWidth, 0),
+          history(kBatchSize + simd::kWidth, 0), position(kBatchSize + simd::kWidth, 0) {}
+
+    void move(int from, int to) {
+        energy[to] = energy[from];
+        z[to] = z[from];
+        dz[to] = dz[from];
+        weight[to] = weight[from];
+        mu[to] = mu[from];
+        p_compton[to] = p_compton[from];
+        layer[to] = layer[from];
+        history[to] = history[from];
+        position[to] = position[from];
+    }
+};
+
+// Per-layer geometry laid out for gathers (coefficients are per lane since
+// they depend on the photon energy). When every layer has constant
+// coefficients they are tabulated too, for the crossings in the kernel.
+struct LayerTable {
+    std::vector<double> start_z, end_z, stretch;
+    std::vector<double> index, mu, p_compton;   // Layer number as a double, and its coefficients
+    int num_layers;
+    bool constant;                              // No energy-dependent table in the shield
+
+    LayerTable(const std::vector<double>& bounds, const std::vector<double>& layer_stretch,
+               const std::vector<LayerRecord>& records)
+        : start_z(bounds.begin(), bounds.end() - 1), end_z(bounds.begin() + 1, bounds.end()),
+          stretch(layer_stretch), num_layers(static_cast<int>(records.size())),
+          constant(std::none_of(records.begin(), records.end(),
+                                [](const LayerRecord& r) { return r.cross_sections != nullptr; })) {
+        for (int i = 0; i < num_layers && constant; ++i) {
+            index.push_back(i);
+            mu.push_back(records[i].mu_total_cm);
+            p_compton.push_back(records[i].mu_compton_cm / records[i].mu_total_cm);
+        }
+    }
+};
+
+// Refresh the lane coefficients after a change of energy or layer
+inline void updateCoefficients(PhotonBatch& b, int k, const LayerRecord& layer) {
+    Attenuation att = layer.attenuation(b.energy[k]);
+    b.mu[k] = att.mu_total_cm;
+    b.p_compton[k] = att.mu_compton_cm / att.mu_total_cm;
+}
+
+// Sequential generator: lanes draw in lane order, roulette draws on demand
+inline void drawLaneRandoms(PhotonBatch& b, std::mt19937& rng) {
+    for (int k = 0; k < b.size; ++k) {
+        b.u_path[k] = uniform(rng);
+        b.u_type[k] = uniform(rng);
+        b.u_angle[k] = uniform(rng);
+        b.u_phi[k] = uniform(rng);
+    }
+}
+
+inline double rouletteRandom(PhotonBatch&, int, std::mt19937& rng) {
+    return uniform(rng);
+}
+
+inline double laneUniform(PhotonBatch&, int, std::mt19937& rng) {
+    return uniform(rng);
+}
+
+// Counter-based generator: every lane takes the next two blocks of its own
+// history's stream, so a history does not depend on the lane it ran in.
+// The free path and the table quantile get 53 bits, the others 32.
+inline void drawLaneRandoms(PhotonBatch& b, Philox4x32& rng) {
+    for (int k = 0; k < b.size; ++k) {
+        Philox4x32::Block r0 = rng.block(b.history[k], b.position[k]++);
+        Philox4x32::Block r1 = rng.block(b.history[k], b.position[k]++);
+        b.u_path[k] = Philox4x32::toUniform(r0[0], r0[1]);
+        b.u_angle[k] = Philox4x32::toUniform(r0[2], r0[3]);
+        b.u_type[k] = Philox4x32::toUniform(r1[0]);
+        b.u_phi[k] = Philox4x32::toUniform(r1[1]);
+        b.u_roulette[k] = Philox4x32::toUniform(r1[2]);
+    }
+}
+
+inline double rouletteRandom(PhotonBatch& b, int k, Philox4x32&) {
+    return b.u_roulette[k];
+}
+
+// Extra draws (Kahn fallback) from the next block of the lane's stream
+inline double laneUniform(PhotonBatch& b, int k, Philox4x32& rng) {
+    Philox4x32::Block r = rng.block(b.history[k], b.position[k]++);
+    return Philox4x32::toUniform(r[0], r[1]);
+}
+
+// Compton scattering beyond the table energy range with Kahn's method,
+// updating dz with the same rotation as the kernel
+template <typename Rng>
+void scatterKahn(PhotonBatch& b, int k, Rng& rng) {
+    double alpha = b.energy[k] * INV_ELECTRON_REST_MASS;
+    ComptonSample s = sampleKahn(alpha, [&]() { return laneUniform(b, k, rng); });
+    double sin_theta = std::sqrt(std::max(0.0, 1.0 - s.cos_theta * s.cos_theta));
+    double sin_dir = std::sqrt(std::max(0.0, 1.0 - b.dz[k] * b.dz[k]));
+    b.dz[k] = b.dz[k] * s.cos_theta - sin_theta * sin_dir * std::cos(TWO_PI * b.u_phi[k]);
+    b.energy[k] *= s.energy_ratio;
+}
+
+// Advance lanes [0, n) by one step and store the energy deposited by the
+// collision (absorption and the Compton recoil electron). With implicit
+// capture every collision scatters and the weight takes the survival
+// probability instead of sampling the interaction type.
+// With the exponential transform the flight weight correction is applied first.
+// With Walk (constant coefficients) a lane reaching the boundary enters the
+// next layer with its remaining optical depth, which is exact since mu is
+// constant along each segment; it stops at a collision or out of the shield.
+template <bool ImplicitCapture, bool Stretch, bool Walk>
+void stepKernel(PhotonBatch& b, const LayerTable& table, const KleinNishinaTable& kn, int n) {
+    using namespace simd;
+    constexpr int NQ = KleinNishinaTable::kQuantiles;
+    const double* kn_q = kn.data();
+    const vdouble tiny = set1(std::numeric_limits<double>::min());
+    const vdouble one = set1(1.0);
+    const vdouble two = set1(2.0);
+    const vdouble zero = set1(0.0);
+
+    for (int i = 0; i < n; i += kWidth) {
+        vindex li = load_index(&b.layer[i]);
+        vdouble z = load(&b.z[i]);
+        vdouble dz = load(&b.dz[i]);
+        vdouble e = load(&b.energy[i]);
+        vdouble w = load(&b.weight[i]);
+
+        // Exponential free path and distance to the far boundary of the layer
+        vdouble tau = sub(zero, log(max(load(&b.u_path[i]), tiny)));   // Optical depth to the collision
+        vdouble mu = load(&b.mu[i]);
+        vdouble p_compton = load(&b.p_compton[i]);
+        vdouble sigma = Stretch ? mul(mu, sub(one, mul(gather(table.stretch.data(), li), dz))) : mu;
+        vdouble free_path = div(tau, sigma);
+        vdouble boundary_z = select(less(dz, zero), gather(table.start_z.data(), li),
+                                    gather(table.end_z.data(), li));
+        vdouble distance = div(sub(boundary_z, z), abs(dz));
+
+        vmask collision = less(free_path, distance);
+        if constexpr (Walk) {
+            const vmask all = less(zero, one);
+            const vdouble step = select(less(dz, zero), set1(-1.0), one);
+            const vdouble num_layers = set1(table.num_layers);
+            const vdouble last = set1(table.num_layers - 1);
+            [[maybe_unused]] const unsigned valid = (1u << std::min(kWidth, b.size - i)) - 1;   // Padding not counted
+            vdouble lf = gather(table.index.data(), li);
+            vmask inside = all;
+            vmask flying = mask_andnot(all, collision);
+            while (mask_bits(flying)) {
+                if (Stretch) {
+                    w = select(flying, mul(w, exp(mul(sub(sigma, mu), distance))), w);
+                }
+                tau = select(flying, max(sub(tau, mul(sigma, distance)), zero), tau);
+                z = select(flying, boundary_z, z);
+                lf = select(flying, add(lf, step), lf);
+                inside = mask_andnot(less(lf, num_layers), less(lf, zero));
+                flying = mask_and(flying, inside);
+                if constexpr (kInstrumented) {
+                    b.crossings += __builtin_popcount(mask_bits(flying) & valid);
+                }
+
+                // Coefficients and far boundary of the layer entered
+                li = to_index(min(max(lf, zero), last));
+                mu = select(flying, gather(table.mu.data(), li), mu);
+                p_compton = select(flying, gather(table.p_compton.data(), li), p_compton);
+                sigma = Stretch ? select(flying, mul(mu, sub(one, mul(gather(table.stretch.data(), li), dz))),
+                                         sigma)
+                                : mu;
+                boundary_z = select(flying, select(less(dz, zero), gather(table.start_z.data(), li),
+                                                   gather(table.end_z.data(), li)),
+                                    boundary_z);
+                distance = div(sub(boundary_z, z), abs(dz));
+                flying = mask_andnot(flying, less(div(tau, sigma), distance));
+            }
+            collision = inside;
+            free_path = div(tau, sigma);
+            if (Stretch) {
+                w = select(collision, mul(w, mul(exp(mul(sub(sigma, mu), free_path)), div(mu, sigma))), w);
+            }
+            // Escaped lanes keep -1 or num_layers for the scalar pass
+            store_index(&b.layer[i], to_index(lf));
+            store(&b.mu[i], mu);
+            store(&b.p_compton[i], p_compton);
+        } else if (Stretch) {
+            vdouble path = select(collision, free_path, distance);
+            w = mul(w, mul(exp(mul(sub(sigma, mu), path)), select(collision, div(mu, sigma), one)));
+        }
+        vdouble e_w = mul(e, w);
+        vmask compton;
+        vdouble absorbed;
+        if (ImplicitCapture) {
+            compton = collision;
+            absorbed = select(collision, mul(e_w, sub(one, p_compton)), zero);
+            w = select(collision, mul(w, p_compton), w);
+        } else {
+            compton = mask_and(collision, less(load(&b.u_type[i]), p_compton));
+            absorbed = select(mask_andnot(collision, compton), e_w, zero);
+        }
+
+        // Klein-Nishina: quantile q from the inverse CDF table (bilinear in
+        // ln E and u), E' = E (1 + 2 alpha)^-q, then rotation of dz by
+        // (theta, phi) about the incoming direction
+        vdouble alpha = mul(e, set1(INV_ELECTRON_REST_MASS));
+        vdouble pe = mul(sub(log(e), set1(kn.logEnergyMin())), set1(kn.invLogStep()));
+        pe = min(max(pe, zero), set1((KleinNishinaTable::kEnergies - 1) * (1.0 - 1e-12)));
+        vdouble pu = mul(load(&b.u_angle[i]), set1(NQ - 1));
+        vdouble ie = trunc(pe);
+        vdouble iu = trunc(pu);
+        vdouble fe = sub(pe, ie);
+        vdouble fu = sub(pu, iu);
+        vindex cell = to_index(add(mul(ie, set1(NQ)), iu));
+        vdouble q00 = gather(kn_q, cell), q01 = gather(kn_q + 1, cell);
+        vdouble q10 = gather(kn_q + NQ, cell), q11 = gather(kn_q + NQ + 1, cell);
+        vdouble q_lo = add(q00, mul(fu, sub(q01, q00)));
+        vdouble q_hi = add(q10, mul(fu, sub(q11, q10)));
+        vdouble q = add(q_lo, mul(fe, sub(q_hi, q_lo)));
+        vdouble ratio = exp(sub(zero, mul(q, log(add(one, mul(two, alpha))))));
+        vdouble cos_theta = sub(one, div(sub(div(one, ratio), one), alpha));
+        vdouble sin_theta = sqrt(max(zero, sub(one, mul(cos_theta, cos_theta))));
+        vdouble sin_dir = sqrt(max(zero, sub(one, mul(dz, dz))));
+        vdouble dz_scattered = sub(mul(dz, cos_theta),
+                                   mul(mul(sin_theta, sin_dir), cos2pi(load(&b.u_phi[i]))));
+        vdouble e_scattered = mul(e, ratio);
+
+        // Beyond the table the scalar pass samples the angle (Kahn)
+        vmask kahn = mask_and(compton, less(set1(KleinNishinaTable::kMaxEnergy), e));
+        vmask tabulated = mask_andnot(compton, kahn);
+        vdouble recoil = select(tabulated, mul(mul(e, w), sub(one, ratio)), zero);
+
+        store(&b.deposit[i], add(absorbed, recoil));
+
+        store(&b.z[i], select(collision, add(z, mul(free_path, dz)), boundary_z));
+        store(&b.energy[i], select(tabulated, e_scattered, e));
+        store(&b.dz[i], select(tabulated, dz_scattered, dz));
+        store(&b.weight[i], w);
+
+        unsigned collision_bits = mask_bits(collision);
+        unsigned compton_bits = mask_bits(compton);
+        unsigned kahn_bits = mask_bits(kahn);
+        for (int j = 0; j < kWidth; ++j) {
+            b.event[i + j] = static_cast<uint8_t>(((collision_bits >> j) & 1u) * EVENT_COLLISION |
+                                                  ((compton_bits >> j) & 1u) * EVENT_COMPTON |
+                                                  ((kahn_bits >> j) & 1u) * EVENT_KAHN);
+        }
+    }
+}
+
+} // namespace
+
+template <typename Rng>
+void PhotonTransport::runPhotonsBatched(Rng& rng, uint64_t first_history, double source_energy_MeV,
+                                        int num_photons, TransportTally& tally) const {
+    if (source_energy_MeV <= ENERGY_CUTOFF_MEV) {
+        return; // Below cutoff: never transported, never transmitted
+    }
+
+    const VarianceReduction& vr = variance_reduction_;
+    const LayerTable table(layer_bounds_, layer_stretch_, records_);
+    const bool stretch = std::any_of(layer_stretch_.begin(), layer_stretch_.end(),
+                                     [](double p) { return p > 0; });
+    const bool walk = table.constant && layers_.size() > 1;   // One layer: every crossing is an escape
+
+    // Kernel specialised for the enabled variance reduction and the layer coefficients
+    using Kernel = void (*)(PhotonBatch&, const LayerTable&, const KleinNishinaTable&, int);
+    const Kernel kernel = walk
+        ? (vr.implicit_capture
+               ? (stretch ? stepKernel<true, true, true> : stepKernel<true, false, true>)
+               : (stretch ? stepKernel<false, true, true> : stepKernel<false, false, true>))
+        : (vr.implicit_capture
+               ? (stretch ? stepKernel<true, true, false> : stepKernel<true, false, false>)
+               : (stretch ? stepKernel<false, true, false> : stepKernel<false, false, false>));
+    const int num_layers = static_cast<int>(layers_.size());
+    const int start_layer = findLayer(0.0);
+
+    PhotonBatch b;
+    int spawned = 0;
+    std::vector<double> step_energy(kInstrumented ? kBatchSize : 0);   // Lane energies before the step
+
+    while (spawned < num_photons || b.size > 0) {
+        // Refill free lanes from the source
+        PhaseTimer source_timer(tally.stats, TransportPhase::Source);
+        while (b.size < kBatchSize && spawned < num_photons) {
+            ++spawned;
+            if (start_layer < 0) {
+                // Zero-thickness shield: transmitted without interacting
+                tally.scoreTransmitted(source_energy_MeV, 1.0);
+                tally.scoreHistory(1.0, source_energy_MeV);
+                continue;
+            }
+            int k = b.size++;
+            b.energy[k] = source_energy_MeV;
+            b.z[k] = 0.0;
+            b.dz[k] = 1.0;
+            b.weight[k] = 1.0;
+            b.layer[k] = start_layer;
+            b.history[k] = first_history + spawned - 1;
+            b.position[k] = 0;
+            updateCoefficients(b, k, records_[start_layer]);
+        }
+        source_timer.stop();
+        if (b.size == 0) {
+            break;
+        }
+
+        // Padding lanes must stay valid for the gathers
+        int padded = (b.size + simd::kWidth - 1) / simd::kWidth * simd::kWidth;
+        for (int k = b.size; k < padded; ++k) {
+            b.layer[k] = 0;
+            b.dz[k] = 1.0;
+            b.mu[k] = 1.0;
+        }
+
+        {
+            PhaseTimer timer(tally.stats, TransportPhase::Random);
+            drawLaneRandoms(b, rng);
+        }
+
+        if constexpr (kInstrumented) {
+            std::copy(b.energy.begin(), b.energy.begin() + b.size, step_energy.begin());
+        }
+        {
+            PhaseTimer timer(tally.stats, TransportPhase::Flight);
+            b.crossings = 0;
+            kernel(b, table, *klein_nishina_, padded);
+        }
+
+        // Resolve outcomes and compact live photons to the front (a
+        // boundary crossed in the kernel is a flight too)
+        PhaseTimer resolve_timer(tally.stats, TransportPhase::Resolve);
+        count(tally.stats.flights, b.size + b.crossings);
+        count(tally.stats.boundary_crossings, b.crossings);
+        int alive = 0;
+        for (int k = 0; k < b.size; ++k) {
+            uint8_t event = b.event[k];
+            if (event & EVENT_COLLISION) {
+                ++tally.collisions;
+                if constexpr (kInstrumented) {
+                    countCollision(tally.stats, step_energy[k]);
+                }
+                tally.deposit(b.z[k], b.deposit[k]);
+                if (!(event & EVENT_COMPTON)) {
+                    count(tally.stats.photoelectric);
+                    continue; // Photoelectric absorption
+                }
+                count(tally.stats.compton);
+                if (event & EVENT_KAHN) {
+                    const double incident_energy = b.energy[k];
+                    scatterKahn(b, k, rng);
+                    tally.deposit(b.z[k], (incident_energy - b.energy[k]) * b.weight[k]);
+                }
+                if (b.energy[k] <= ENERGY_CUTOFF_MEV) {
+                    count(tally.stats.cutoff_kills);
+                    continue;
+                }
+                if (b.weight[k] < vr.roulette_weight) {
+                    // Russian roulette (splitting is rejected for this engine by simulate)
+                    if (rouletteRandom(b, k, rng) * vr.survival_weight >= b.weight[k]) {
+                        count(tally.stats.roulette_kills);
+                        continue;
+                    }
+                    b.weight[k] = vr.survival_weight;
+                }
+            } else {
+                count(tally.stats.boundary_crossings);
+                if (!walk) {
+                    b.layer[k] += b.dz[k] < 0 ? -1 : 1;
+                }
+                if (b.layer[k] < 0) {
+                    count(tally.stats.backscatter_escapes);
+                    continue; // Backscattered out of the source face
+                }
+                if (b.layer[k] == num_layers) {
+                    // Crossed the last boundary (one particle per history without splitting)
+                    tally.scoreTransmitted(b.energy[k], b.weight[k]);
+                    tally.scoreHistory(b.weight[k], b.energy[k] * b.weight[k]);
+                    continue;
+                }
+            }
+            if (!walk) {
+                updateCoefficients(b, k, records_[b.layer[k]]);   // Constant ones are set by the kernel
+            }
+            if (alive != k) {
+                b.move(k, alive);
+            }
+            ++alive;
+        }
+        b.size = alive;
+    }
+}
+
+template void PhotonTransport::runPhotonsBatched(std::mt19937&, uint64_t, double, int, TransportTally&) const;
+template void PhotonTransport::runPhotonsBatched(Philox4x32&, uint64_t, double, int, TransportTally&) const;
+
+} // namespace shield_lite
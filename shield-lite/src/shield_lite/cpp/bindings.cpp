@@ -1,6 +1,10 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include "photon_transport.h"
+#include "grid_kernel.h"
+#include "run_batch.h"
+#include "surrogate.h"
 #include "monte_carlo.cpp"
 
 namespace py = pybind11;
@@ -9,23 +13,349 @@ using namespace shield_lite;
 PYBIND11_MODULE(_monte_carlo, m) {
     m.doc() = "Monte Carlo photon transport simulation for gamma ray shielding";
 
+    using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+    using Int32Array = py::array_t<int32_t, py::array::c_style | py::array::forcecast>;
+    using Int64Array = py::array_t<int64_t, py::array::c_style | py::array::forcecast>;
+
+    // One row of run_batch results
+    PYBIND11_NUMPY_DTYPE(BatchResult, transmission_factor, transmission_uncertainty,
+                         dose_transmitted, dose_absorbed, buildup_factor, uncertainty,
+                         relative_uncertainty, elapsed_seconds, total_photons,
+                         transmitted_photons);
+
+    // Transport kernel selection
+    py::enum_<TransportEngine>(m, "TransportEngine")
+        .value("SCALAR", TransportEngine::Scalar, "One photon at a time (reference)")
+        .value("BATCHED", TransportEngine::Batched, "SoA photon batches with a SIMD kernel")
+        .value("GPU", TransportEngine::Gpu, "History-based CUDA kernel (SHIELD_LITE_CUDA builds, Philox only)");
+
+    m.def("gpu_available", &PhotonTransport::gpuAvailable,
+          "True if the module is built with SHIELD_LITE_CUDA and a CUDA device is present");
+
+    py::enum_<RandomGenerator>(m, "RandomGenerator")
+        .value("MT19937", RandomGenerator::MT19937, "Sequential Mersenne Twister stream per photon chunk")
+        .value("PHILOX", RandomGenerator::Philox, "Counter-based Philox4x32-10, one stream per history");
+
+    // Survival biasing parameters
+    py::class_<VarianceReduction>(m, "VarianceReduction")
+        .def(py::init([](bool implicit_capture, double roulette_weight, double survival_weight,
+                         double split_weight, int max_split, std::vector<double> stretch,
+                         bool auto_stretch) {
+                 VarianceReduction vr;
+                 vr.implicit_capture = implicit_capture;
+                 vr.roulette_weight = roulette_weight;
+                 vr.survival_weight = survival_weight;
+                 vr.split_weight = split_weight;
+                 vr.max_split = max_split;
+                 vr.stretch = std::move(stretch);
+                 vr.auto_stretch = auto_stretch;
+                 return vr;
+             }),
+             py::arg("implicit_capture") = false,
+             py::arg("roulette_weight") = 0.0,
+             py::arg("survival_weight") = 0.5,
+             py::arg("split_weight") = 0.0,
+             py::arg("max_split") = 10,
+             py::arg("stretch") = std::vector<double>(),
+             py::arg("auto_stretch") = false)
+        .def_readwrite("implicit_capture", &VarianceReduction::implicit_capture,
+                       "Reduce the weight at collisions instead of killing absorbed photons")
+        .def_readwrite("roulette_weight", &VarianceReduction::roulette_weight,
+                       "Play Russian roulette below this weight (0 = off)")
+        .def_readwrite("survival_weight", &VarianceReduction::survival_weight,
+                       "Weight given to photons surviving the roulette")
+        .def_readwrite("split_weight", &VarianceReduction::split_weight,
+                       "Split photons above this weight (0 = off, SCALAR engine only)")
+        .def_readwrite("max_split", &VarianceReduction::max_split,
+                       "Maximum number of fragments per split")
+        .def_readwrite("stretch", &VarianceReduction::stretch,
+                       "Exponential transform parameter p in [0, 1) per layer (empty = off)")
+        .def_readwrite("auto_stretch", &VarianceReduction::auto_stretch,
+                       "Choose the exponential transform parameters from each layer's mu * thickness")
+        .def("__repr__", [](const VarianceReduction& vr) {
+            return std::string("VarianceReduction(implicit_capture=") +
+                   (vr.implicit_capture ? "True" : "False") +
+                   ", roulette_weight=" + std::to_string(vr.roulette_weight) +
+                   ", survival_weight=" + std::to_string(vr.survival_weight) +
+                   ", split_weight=" + std::to_string(vr.split_weight) +
+                   ", auto_stretch=" + (vr.auto_stretch ? "True" : "False") + ")";
+        });
+
+    // Adaptive stopping rules
+    py::class_<StoppingCriteria>(m, "StoppingCriteria")
+        .def(py::init([](double target_relative_uncertainty, double max_seconds,
+                         int max_photons, int batch_photons) {
+                 StoppingCriteria s;
+                 s.target_relative_uncertainty = target_relative_uncertainty;
+                 s.max_seconds = max_seconds;
+                 s.max_photons = max_photons;
+                 s.batch_photons = batch_photons;
+                 return s;
+             }),
+             py::arg("target_relative_uncertainty") = 0.01,
+             py::arg("max_seconds") = 0.0,
+             py::arg("max_photons") = 10000000,
+             py::arg("batch_photons") = 10000)
+        .def_readwrite("target_relative_uncertainty", &StoppingCriteria::target_relative_uncertainty,
+                       "Stop when relative_uncertainty falls to this value (0 = off)")
+        .def_readwrite("max_seconds", &StoppingCriteria::max_seconds,
+                       "Wall-clock budget in seconds (0 = unlimited)")
+        .def_readwrite("max_photons", &StoppingCriteria::max_photons,
+                       "Maximum number of histories")
+        .def_readwrite("batch_photons", &StoppingCriteria::batch_photons,
+                       "Histories in the first batch (later batches grow with the projection)");
+
+    // Mesh tallies
+    py::class_<MeshTallies>(m, "MeshTallies")
+        .def(py::init([](int depth_bins, int spectrum_bins) {
+                 MeshTallies t;
+                 t.depth_bins = depth_bins;
+                 t.spectrum_bins = spectrum_bins;
+                 return t;
+             }),
+             py::arg("depth_bins") = 0,
+             py::arg("spectrum_bins") = 0)
+        .def_readwrite("depth_bins", &MeshTallies::depth_bins,
+                       "Uniform depth bins across the shield for the deposited energy (0 = off)")
+        .def_readwrite("spectrum_bins", &MeshTallies::spectrum_bins,
+                       "Uniform bins over [0, source energy] for the transmitted photons (0 = off)");
+
+    // Histogram values as a read-only view into the result that owns them
+    auto histogram_view = [](py::object owner, const Histogram& h) {
+        py::array_t<double> view(h.bins(), h.data(), owner);
+        view.attr("setflags")(py::arg("write") = false);
+        return view;
+    };
+    auto histogram_edges = [](const Histogram& h) {
+        py::array_t<double> edges(h.enabled() ? h.bins() + 1 : 0);
+        double* out = edges.mutable_data();
+        for (int i = 0; h.enabled() && i <= h.bins(); ++i) {
+            out[i] = h.lower() + (h.upper() - h.lower()) * i / h.bins();
+        }
+        return edges;
+    };
+
+    // Instrumentation counters (zero unless built with SHIELD_LITE_INSTRUMENT)
+    py::class_<TransportStats>(m, "TransportStats")
+        .def_readonly("flights", &TransportStats::flights,
+                      "Free-flight steps (each ends in a collision or at a boundary)")
+        .def_readonly("boundary_crossings", &TransportStats::boundary_crossings,
+                      "Layer boundary crossings")
+        .def_readonly("compton", &TransportStats::compton,
+                      "Compton scatters (every collision with implicit capture)")
+        .def_readonly("photoelectric", &TransportStats::photoelectric, "Photoelectric absorptions")
+        .def_readonly("cutoff_kills", &TransportStats::cutoff_kills,
+                      "Photons dropped below the 0.01 MeV energy cutoff")
+        .def_readonly("roulette_kills", &TransportStats::roulette_kills,
+                      "Photons killed by Russian roulette")
+        .def_readonly("backscatter_escapes", &TransportStats::backscatter_escapes,
+                      "Photons leaving through the source face")
+        .def_readonly("secondaries", &TransportStats::secondaries,
+                      "Annihilation and fluorescence photons emitted (see set_secondary_physics)")
+        .def_readonly("bank_overflows", &TransportStats::bank_overflows,
+                      "Secondary photons deposited locally because the secondary bank was full")
+        .def_property_readonly("collisions_by_energy",
+             [](const TransportStats& s) {
+                 return std::vector<long long>(s.collisions_by_energy, s.collisions_by_energy + kEnergyBins);
+             },
+             "Collisions by photon energy: [< 0.1, 0.1-1, 1-10, >= 10] MeV")
+        .def_property_readonly("phase_seconds",
+             [](const TransportStats& s) {
+                 py::dict phases;
+                 phases["source"] = s.phase_seconds[static_cast<int>(TransportPhase::Source)];
+                 phases["random"] = s.phase_seconds[static_cast<int>(TransportPhase::Random)];
+                 phases["flight"] = s.phase_seconds[static_cast<int>(TransportPhase::Flight)];
+                 phases["resolve"] = s.phase_seconds[static_cast<int>(TransportPhase::Resolve)];
+                 return phases;
+             },
+             "Seconds per phase summed over threads (the SCALAR engine only times flight)")
+        .def("__repr__", [](const TransportStats& s) {
+            return "TransportStats(flights=" + std::to_string(s.flights) +
+                   ", compton=" + std::to_string(s.compton) +
+                   ", photoelectric=" + std::to_string(s.photoelectric) +
+                   ", boundary_crossings=" + std::to_string(s.boundary_crossings) +
+                   ", cutoff_kills=" + std::to_string(s.cutoff_kills) + ")";
+        });
+
+    // Plain-data states of the tallies (tuples, lists and floats), so saved
+    // tallies can be pickled or written as JSON and merged later
+    auto streaming_state = [](const StreamingTally& t) {
+        return py::make_tuple(t.count(), t.mean(), t.m2(), t.m3(), t.m4());
+    };
+    auto streaming_from_state = [](const py::sequence& state) {
+        if (state.size() != 5) {
+            throw py::value_error("StreamingTally state needs (count, mean, m2, m3, m4)");
+        }
+        return StreamingTally::fromMoments(state[0].cast<long long>(), state[1].cast<double>(),
+                                           state[2].cast<double>(), state[3].cast<double>(),
+                                           state[4].cast<double>());
+    };
+    auto histogram_state = [](const Histogram& h) {
+        return py::make_tuple(h.lower(), h.upper(), h.values());
+    };
+    auto histogram_from_state = [](const py::sequence& state) {
+        if (state.size() != 3) {
+            throw py::value_error("Histogram state needs (lower, upper, values)");
+        }
+        return Histogram(state[0].cast<double>(), state[1].cast<double>(),
+                         state[2].cast<std::vector<double>>());
+    };
+    auto tally_state = [=](const TransportTally& t) {
+        py::dict state;
+        state["transmitted"] = streaming_state(t.transmitted);
+        state["history_weight"] = streaming_state(t.history_weight);
+        state["history_dose"] = streaming_state(t.history_dose);
+        state["dose_absorbed"] = t.dose_absorbed;
+        state["collisions"] = t.collisions;
+        state["depth_dose"] = histogram_state(t.depth_dose);
+        state["spectrum"] = histogram_state(t.spectrum);
+        state["secondary_weight"] = t.secondary_weight;
+        state["secondary_dose"] = t.secondary_dose;
+        state["secondary_spectrum"] = histogram_state(t.secondary_spectrum);
+        return state;
+    };
+    auto tally_from_state = [=](const py::dict& state) {
+        TransportTally t;
+        t.transmitted = streaming_from_state(state["transmitted"].cast<py::sequence>());
+        t.history_weight = streaming_from_state(state["history_weight"].cast<py::sequence>());
+        t.history_dose = streaming_from_state(state["history_dose"].cast<py::sequence>());
+        t.dose_absorbed = state["dose_absorbed"].cast<double>();
+        t.collisions = state["collisions"].cast<long long>();
+        t.depth_dose = histogram_from_state(state["depth_dose"].cast<py::sequence>());
+        t.spectrum = histogram_from_state(state["spectrum"].cast<py::sequence>());
+        // Absent from states saved before secondary photons were tallied
+        if (state.contains("secondary_weight")) {
+            t.secondary_weight = state["secondary_weight"].cast<double>();
+            t.secondary_dose = state["secondary_dose"].cast<double>();
+            t.secondary_spectrum = histogram_from_state(state["secondary_spectrum"].cast<py::sequence>());
+        }
+        return t;
+    };
+
+    // Streaming tally (mergeable across threads and runs)
+    py::class_<StreamingTally>(m, "StreamingTally")
+        .def(py::init<>())
+        .def(py::pickle(streaming_state, streaming_from_state))
+        .def("add", &StreamingTally::add, py::arg("value"), "Add one sample")
+        .def("merge", &StreamingTally::merge, py::arg("other"),
+             "Merge another tally into this one (exact, order-independent up to rounding)")
+        .def_property_readonly("count", &StreamingTally::count, "Number of samples")
+        .def_property_readonly("mean", &StreamingTally::mean, "Sample mean")
+        .def_property_readonly("sum", &StreamingTally::sum, "Sum of the samples")
+        .def_property_readonly("variance", &StreamingTally::variance, "Population variance")
+        .def_property_readonly("standard_error", &StreamingTally::standardError,
+                               "Standard error of the mean")
+        .def_property_readonly("skewness", &StreamingTally::skewness, "Sample skewness")
+        .def_property_readonly("kurtosis", &StreamingTally::kurtosis, "Sample excess kurtosis")
+        .def_property_readonly("variance_of_variance", &StreamingTally::varianceOfVariance,
+                               "Relative variance of the variance (VOV)")
+        .def("__repr__", [](const StreamingTally& t) {
+            return "StreamingTally(count=" + std::to_string(t.count()) +
+                   ", mean=" + std::to_string(t.mean()) +
+                   ", variance=" + std::to_string(t.variance()) + ")";
+        });
+
+    // Raw tally of a range of histories (see MonteCarloSimulator.run_tally)
+    py::class_<TransportTally>(m, "TransportTally")
+        .def(py::init<>())
+        .def("merge", &TransportTally::merge, py::arg("other"),
+             "Merge the tally of another range of histories of the same run")
+        .def("to_state", tally_state,
+             "Plain-data state (dict of tuples and floats; instrumentation counters are not kept)")
+        .def_static("from_state", tally_from_state, py::arg("state"),
+                    "Tally restored from to_state (lists are accepted for tuples)")
+        .def(py::pickle(tally_state, tally_from_state));
+
+    // Checkpoint of a range of histories (see MonteCarloSimulator.run_checkpointed)
+    py::class_<Checkpoint>(m, "Checkpoint")
+        .def_readonly("config_hash", &Checkpoint::config_hash,
+                      "Fingerprint of the configuration (layers, tables, variance reduction, ...)")
+        .def_readonly("run_key", &Checkpoint::run_key, "Key of the run's random streams")
+        .def_readonly("first_history", &Checkpoint::first_history, "First history of the range")
+        .def_readonly("next_history", &Checkpoint::next_history,
+                      "Next history to run (histories before it are tallied)")
+        .def_readonly("end_history", &Checkpoint::end_history, "End of the range (exclusive)")
+        .def_readonly("source_energy_MeV", &Checkpoint::source_energy_MeV)
+        .def_readonly("elapsed_seconds", &Checkpoint::elapsed_seconds, "Accumulated run time")
+        .def_readonly("tally", &Checkpoint::tally)
+        .def_property_readonly("histories", &Checkpoint::histories, "Histories tallied so far")
+        .def_property_readonly("complete", &Checkpoint::complete)
+        .def_static("load", &loadCheckpoint, py::arg("path"), "Read a checkpoint file")
+        .def("save", [](const Checkpoint& c, const std::string& path) { saveCheckpoint(path, c); },
+             py::arg("path"), "Write the checkpoint atomically")
+        .def("to_bytes", [](const Checkpoint& c) { return py::bytes(serializeCheckpoint(c)); },
+             "Compact binary form (the file contents)")
+        .def_static("from_bytes",
+                    [](const py::bytes& bytes) { return deserializeCheckpoint(bytes); },
+                    py::arg("bytes"))
+        .def("__repr__", [](const Checkpoint& c) {
+            return "Checkpoint(histories=" + std::to_string(c.histories()) + " of [" +
+                   std::to_string(c.first_history) + ", " + std::to_string(c.end_history) + "))";
+        });
+
     // MonteCarloResult structure
     py::class_<MonteCarloResult>(m, "MonteCarloResult")
         .def(py::init<>())
         .def_readonly("dose_transmitted", &MonteCarloResult::dose_transmitted,
                      "Dose transmitted through the shield (MeV per photon)")
         .def_readonly("dose_absorbed", &MonteCarloResult::dose_absorbed,
-                     "Dose absorbed in the shield (MeV per photon)")
+                     "Dose absorbed in the shield (MeV per photon), photoelectric and Compton electrons")
         .def_readonly("transmission_factor", &MonteCarloResult::transmission_factor,
-                     "Fraction of photons that pass through the shield")
+                     "Transmitted weight per source photon (fraction transmitted when analog)")
         .def_readonly("buildup_factor", &MonteCarloResult::buildup_factor,
                      "Dose buildup factor (accounts for scattered photons)")
         .def_readonly("uncertainty", &MonteCarloResult::uncertainty,
                      "Statistical uncertainty of the simulation")
+        .def_readonly("relative_uncertainty", &MonteCarloResult::relative_uncertainty,
+                     "Relative standard error of dose_transmitted (per source photon)")
+        .def_readonly("transmission_uncertainty", &MonteCarloResult::transmission_uncertainty,
+                     "Standard error of transmission_factor (per source photon)")
+        .def_readonly("elapsed_seconds", &MonteCarloResult::elapsed_seconds,
+                     "Wall-clock time of the simulation in seconds")
+        .def_readonly("figure_of_merit", &MonteCarloResult::figure_of_merit,
+                     "Figure of merit 1 / (relative_uncertainty^2 * elapsed_seconds)")
+        .def_readonly("transmitted_tally", &MonteCarloResult::transmitted_tally,
+                     "Streaming tally of the transmitted photon doses")
+        .def_property_readonly("depth_dose",
+             [histogram_view](py::object self) {
+                 return histogram_view(self, self.cast<const MonteCarloResult&>().depth_dose);
+             },
+             "Energy deposited per depth bin (MeV per photon, empty unless depth_bins > 0); "
+             "a read-only view, not a copy")
+        .def_property_readonly("depth_bin_edges",
+             [histogram_edges](const MonteCarloResult& r) { return histogram_edges(r.depth_dose); },
+             "Depth bin edges in cm (depth_bins + 1 values)")
+        .def_property_readonly("spectrum",
+             [histogram_view](py::object self) {
+                 return histogram_view(self, self.cast<const MonteCarloResult&>().spectrum);
+             },
+             "Transmitted weight per energy bin (per photon, sums to transmission_factor, "
+             "empty unless spectrum_bins > 0); a read-only view, not a copy")
+        .def_property_readonly("spectrum_bin_edges",
+             [histogram_edges](const MonteCarloResult& r) { return histogram_edges(r.spectrum); },
+             "Energy bin edges in MeV (spectrum_bins + 1 values)")
+        .def_readonly("secondary_transmission", &MonteCarloResult::secondary_transmission,
+                     "Transmitted weight of secondary photons per source photon (see "
+                     "set_secondary_physics); not part of transmission_factor")
+        .def_readonly("secondary_dose_transmitted", &MonteCarloResult::secondary_dose_transmitted,
+                     "Energy transmitted by secondary photons (MeV per photon); not part of "
+                     "dose_transmitted")
+        .def_property_readonly("secondary_spectrum",
+             [histogram_view](py::object self) {
+                 return histogram_view(self, self.cast<const MonteCarloResult&>().secondary_spectrum);
+             },
+             "Transmitted secondary weight per energy bin (per photon, spectrum_bin_edges; empty "
+             "unless spectrum_bins > 0 and secondary physics is set); a read-only view")
         .def_readonly("total_photons", &MonteCarloResult::total_photons,
                      "Total number of photons simulated")
+        .def_readonly("converged", &MonteCarloResult::converged,
+                     "Whether run_until reached its target relative uncertainty")
         .def_readonly("transmitted_photons", &MonteCarloResult::transmitted_photons,
                      "Number of photons transmitted through shield")
+        .def_readonly("collisions", &MonteCarloResult::collisions,
+                     "Number of interactions (absorptions and scatters) over all histories")
+        .def_readonly("stats", &MonteCarloResult::stats,
+                     "Event counters and phase times (all zero unless INSTRUMENTED)")
         .def("__repr__", [](const MonteCarloResult& r) {
             return "MonteCarloResult(transmission=" + std::to_string(r.transmission_factor) +
                    ", buildup_factor=" + std::to_string(r.buildup_factor) +
@@ -34,10 +364,52 @@ PYBIND11_MODULE(_monte_carlo, m) {
         });
 
     // MonteCarloSimulator class
+    py::register_exception<RunCancelled>(m, "RunCancelled", PyExc_RuntimeError);
+
+    // Background run started by MonteCarloSimulator.start_run
+    py::class_<AsyncRun>(m, "AsyncRun")
+        .def("cancel", &AsyncRun::cancel,
+             "Ask the run to stop: chunks in flight finish, result() then raises RunCancelled")
+        .def_property_readonly("cancel_requested", &AsyncRun::cancelRequested)
+        .def("done", &AsyncRun::done, "Whether the run has finished (completed, failed or cancelled)")
+        .def_property_readonly("num_photons", &AsyncRun::numPhotons)
+        .def_property_readonly("histories_done", &AsyncRun::historiesDone,
+                               "Histories finished so far (updated per chunk of 8192)")
+        .def_property_readonly("relative_uncertainty", &AsyncRun::relativeUncertainty,
+                               "Relative uncertainty of dose_transmitted over the finished histories")
+        .def_property_readonly("elapsed_seconds", &AsyncRun::elapsedSeconds,
+                               "Seconds since the start (the run time once done)")
+        .def("wait", [](const AsyncRun& run, std::optional<double> timeout) {
+                 py::gil_scoped_release release;
+                 return run.wait(timeout ? *timeout : -1.0);
+             },
+             py::arg("timeout") = py::none(),
+             "Wait for the run (at most timeout seconds); True if it is done. The GIL is released.")
+        .def("result", &AsyncRun::result, py::call_guard<py::gil_scoped_release>(),
+             "Wait for the run and return its MonteCarloResult; raises RunCancelled if it was "
+             "cancelled, or the error the run ended with")
+        .def("__repr__", [](const AsyncRun& run) {
+            return "AsyncRun(histories_done=" + std::to_string(run.historiesDone()) + " of " +
+                   std::to_string(run.numPhotons()) + (run.done() ? ", done)" : ")");
+        });
+
     py::class_<MonteCarloSimulator>(m, "MonteCarloSimulator")
         .def(py::init<>(), "Create a Monte Carlo simulator with default random seed")
         .def(py::init<unsigned int>(), py::arg("seed"),
              "Create a Monte Carlo simulator with specified random seed")
+        .def("set_random_generator", &MonteCarloSimulator::setRandomGenerator,
+             py::arg("generator"),
+             R"pbdoc(
+                Select the random number generator of the transport.
+
+                MT19937 (default) seeds one Mersenne Twister per chunk of
+                histories. PHILOX gives every history its own counter-based
+                stream keyed by (seed, history index): a history can be
+                replayed on its own and the results do not depend on the
+                batching of the engine.
+             )pbdoc")
+        .def("get_random_generator", &MonteCarloSimulator::getRandomGenerator,
+             "Get the random number generator of the transport")
         .def("add_layer", &MonteCarloSimulator::addLayer,
              py::arg("material_name"),
              py::arg("thickness_cm"),
@@ -63,12 +435,159 @@ PYBIND11_MODULE(_monte_carlo, m) {
                 density_g_cm3 : float
                     Density of the material in g/cm^3
              )pbdoc")
+        .def("add_layers",
+             [](MonteCarloSimulator& sim, const std::vector<std::string>& material_names,
+                DoubleArray thickness_cm, DoubleArray mu_total, DoubleArray mu_compton,
+                DoubleArray mu_photoelectric, DoubleArray density_g_cm3) {
+                 const py::ssize_t num_layers = static_cast<py::ssize_t>(material_names.size());
+                 for (const DoubleArray* column : {&thickness_cm, &mu_total, &mu_compton,
+                                                   &mu_photoelectric, &density_g_cm3}) {
+                     if (column->ndim() != 1 || column->size() != num_layers) {
+                         throw py::value_error("Layer arrays need one entry per material name");
+                     }
+                 }
+                 sim.addLayers(material_names, thickness_cm.data(), mu_total.data(), mu_compton.data(),
+                               mu_photoelectric.data(), density_g_cm3.data());
+             },
+             py::arg("material_names"),
+             py::arg("thickness_cm"),
+             py::arg("mu_total"),
+             py::arg("mu_compton"),
+             py::arg("mu_photoelectric"),
+             py::arg("density_g_cm3"),
+             R"pbdoc(
+                Add several layers at once, in order from the source.
+
+                Parameters:
+                -----------
+                material_names : list of str
+                    Name of each layer's material
+                thickness_cm, mu_total, mu_compton, mu_photoelectric, density_g_cm3 : numpy.ndarray
+                    One entry per layer, as in add_layer. Contiguous float64
+                    arrays (or any buffer) are read in place.
+             )pbdoc")
+        .def("get_layers",
+             [](const MonteCarloSimulator& sim) {
+                 const std::vector<MaterialLayer>& layers = sim.layers();
+                 const py::ssize_t num_layers = static_cast<py::ssize_t>(layers.size());
+                 py::list names;
+                 py::array_t<double> thickness(num_layers), mu_total(num_layers), mu_compton(num_layers),
+                     mu_photoelectric(num_layers), density(num_layers);
+                 for (py::ssize_t i = 0; i < num_layers; ++i) {
+                     const MaterialLayer& layer = layers[i];
+                     names.append(layer.name);
+                     thickness.mutable_at(i) = layer.thickness_cm;
+                     mu_total.mutable_at(i) = layer.mu_total_cm;
+                     mu_compton.mutable_at(i) = layer.mu_compton_cm;
+                     mu_photoelectric.mutable_at(i) = layer.mu_photoelectric_cm;
+                     density.mutable_at(i) = layer.density_g_cm3;
+                 }
+                 py::dict columns;
+                 columns["material"] = names;
+                 columns["thickness_cm"] = thickness;
+                 columns["mu_total"] = mu_total;
+                 columns["mu_compton"] = mu_compton;
+                 columns["mu_photoelectric"] = mu_photoelectric;
+                 columns["density_g_cm3"] = density;
+                 return columns;
+             },
+             R"pbdoc(
+                Get the layers of the shield as columns.
+
+                Returns:
+                --------
+                dict
+                    'material' (list of str) and one numpy.ndarray per
+                    property: 'thickness_cm', 'mu_total', 'mu_compton',
+                    'mu_photoelectric', 'density_g_cm3' (constant
+                    coefficients, cross-section tables are not included)
+             )pbdoc")
         .def("clear_layers", &MonteCarloSimulator::clearLayers,
              "Remove all layers from the shield configuration")
+        .def("set_cross_sections", &MonteCarloSimulator::setCrossSections,
+             py::arg("material_name"),
+             py::arg("energy_MeV"),
+             py::arg("mu_total"),
+             py::arg("mu_compton"),
+             py::arg("mu_photoelectric"),
+             py::arg("points_per_decade") = 100,
+             R"pbdoc(
+                Use energy-dependent attenuation coefficients for a material.
+
+                Every layer named material_name then looks up mu(E) at the
+                current photon energy instead of using the constant
+                coefficients given to add_layer. The table is shared by all
+                layers of the material.
+
+                Parameters:
+                -----------
+                material_name : str
+                    Name of the material (as given to add_layer)
+                energy_MeV : list of float
+                    Tabulated energies in MeV, strictly increasing
+                mu_total, mu_compton, mu_photoelectric : list of float
+                    Linear attenuation coefficients in cm^-1 at those energies
+                    (mass coefficients times density)
+                points_per_decade : int, optional
+                    Density of the uniform log-energy lookup grid (default: 100)
+             )pbdoc")
+        .def("clear_cross_sections", &MonteCarloSimulator::clearCrossSections,
+             py::arg("material_name"),
+             "Go back to the constant coefficients for this material")
+        .def("has_cross_sections", &MonteCarloSimulator::hasCrossSections,
+             py::arg("material_name"),
+             "Whether energy-dependent coefficients are set for this material")
+        .def("set_secondary_physics", &MonteCarloSimulator::setSecondaryPhysics,
+             py::arg("material_name"),
+             py::arg("pair_mu") = 0.0,
+             py::arg("fluorescence_yield") = 0.0,
+             py::arg("fluorescence_energy_MeV") = 0.0,
+             R"pbdoc(
+                Transport the secondary photons emitted on absorption in a material.
+
+                By default an absorbed photon deposits all its energy where it
+                stops. With secondary physics, an absorption in a layer named
+                material_name is, with probability pair_mu / (mu_total -
+                mu_compton), a pair production above 1.022 MeV: the pair's
+                kinetic energy deposits locally and two back-to-back 0.511 MeV
+                annihilation photons are emitted. Otherwise, with probability
+                fluorescence_yield, it emits an isotropic fluorescence X-ray.
+                Secondaries are banked and transported after the primary
+                photon; the bank has a fixed capacity (TransportStats.
+                bank_overflows counts the secondaries deposited instead).
+                Transmitted secondaries are scored apart, in
+                secondary_transmission, secondary_dose_transmitted and
+                secondary_spectrum; transmission_factor and buildup_factor
+                count the source photons only. Only the scalar engine
+                supports secondaries.
+
+                Parameters:
+                -----------
+                material_name : str
+                    Name of the material (as given to add_layer)
+                pair_mu : float, optional
+                    Pair production coefficient in cm^-1, part of the
+                    absorption (mu_total - mu_compton)
+                fluorescence_yield : float, optional
+                    Probability in [0, 1] that an absorption emits an X-ray
+                fluorescence_energy_MeV : float, optional
+                    Energy of that X-ray (e.g. 0.075 for lead K-alpha)
+             )pbdoc")
+        .def("clear_secondary_physics", &MonteCarloSimulator::clearSecondaryPhysics,
+             py::arg("material_name"),
+             "Deposit the absorbed energy locally again for this material")
+        .def("has_secondary_physics", &MonteCarloSimulator::hasSecondaryPhysics,
+             py::arg("material_name"),
+             "Whether secondary physics is set for this material")
         .def("run", &MonteCarloSimulator::run,
              py::arg("source_energy_MeV"),
              py::arg("num_photons"),
              py::arg("source_area_cm2") = 1.0,
+             py::arg("num_threads") = 1,
+             py::arg("engine") = TransportEngine::Scalar,
+             py::arg("variance_reduction") = VarianceReduction(),
+             py::arg("mesh_tallies") = MeshTallies(),
+             py::call_guard<py::gil_scoped_release>(),
              R"pbdoc(
                 Run the Monte Carlo simulation.
 
@@ -80,19 +599,418 @@ PYBIND11_MODULE(_monte_carlo, m) {
                     Number of photons to simulate (more = better statistics)
                 source_area_cm2 : float, optional
                     Source area in cm^2 (default: 1.0)
+                num_threads : int, optional
+                    Number of worker threads (default: 1, <= 0 uses all cores).
+                    Photons run in work-stealing chunks, each with its own random
+                    stream derived from the seed, so results do not depend on
+                    the thread count.
+                    The GIL is released while the simulation runs.
+                engine : TransportEngine, optional
+                    Transport kernel (default: SCALAR). BATCHED tracks photons in
+                    structure-of-arrays batches with a SIMD kernel; results are
+                    statistically equivalent but not bit-identical to SCALAR.
+                    GPU runs the histories on a CUDA device (gpu_available(),
+                    PHILOX only, num_threads ignored).
+                variance_reduction : VarianceReduction, optional
+                    Survival biasing (default: analog transport). Implicit capture,
+                    Russian roulette and the exponential transform keep the
+                    estimates unbiased; compare settings through figure_of_merit.
+                    Splitting requires SCALAR.
+                mesh_tallies : MeshTallies, optional
+                    Depth-dose and transmitted spectrum histograms (default: off),
+                    returned as depth_dose and spectrum. Each chunk scores into
+                    its own histograms, merged in chunk order.
+
+                Raises:
+                -------
+                ValueError
+                    If the variance reduction thresholds are inconsistent
 
                 Returns:
                 --------
                 MonteCarloResult
                     Simulation results including dose, transmission, and buildup factor
              )pbdoc")
+        .def("start_run", &MonteCarloSimulator::startRun,
+             py::arg("source_energy_MeV"),
+             py::arg("num_photons"),
+             py::arg("num_threads") = 1,
+             py::arg("engine") = TransportEngine::Scalar,
+             py::arg("variance_reduction") = VarianceReduction(),
+             py::arg("mesh_tallies") = MeshTallies(),
+             R"pbdoc(
+                Start run on a background thread and return an AsyncRun handle.
+
+                The histories run on num_threads native workers without the
+                GIL; the handle reports progress per chunk, cancels
+                cooperatively and waits for the result, which is the one run
+                would return at this point of the simulator stream.
+
+                Parameters:
+                -----------
+                source_energy_MeV, num_photons, num_threads, engine, variance_reduction, mesh_tallies :
+                    Same as run
+
+                Raises:
+                -------
+                ValueError
+                    If the configuration is invalid (raised before the run starts)
+             )pbdoc")
+        .def("run_until", &MonteCarloSimulator::runUntil,
+             py::arg("source_energy_MeV"),
+             py::arg("stopping") = StoppingCriteria(),
+             py::arg("num_threads") = 1,
+             py::arg("engine") = TransportEngine::Scalar,
+             py::arg("variance_reduction") = VarianceReduction(),
+             py::arg("mesh_tallies") = MeshTallies(),
+             py::call_guard<py::gil_scoped_release>(),
+             R"pbdoc(
+                Run the Monte Carlo simulation in batches until a stopping rule is met.
+
+                Parameters:
+                -----------
+                source_energy_MeV : float
+                    Energy of the gamma ray source in MeV
+                stopping : StoppingCriteria, optional
+                    Target relative uncertainty of dose_transmitted, wall-clock
+                    and history budgets. Rules are checked between batches; the
+                    batch size follows the 1/sqrt(N) projection of the target.
+                num_threads, engine, variance_reduction, mesh_tallies :
+                    Same as run
+
+                Returns:
+                --------
+                MonteCarloResult
+                    total_photons gives the histories actually used and
+                    converged tells whether the target was reached
+             )pbdoc")
+        .def("run_tally", &MonteCarloSimulator::runTally,
+             py::arg("source_energy_MeV"),
+             py::arg("first_history"),
+             py::arg("num_photons"),
+             py::arg("num_threads") = 1,
+             py::arg("engine") = TransportEngine::Scalar,
+             py::arg("variance_reduction") = VarianceReduction(),
+             py::arg("mesh_tallies") = MeshTallies(),
+             py::call_guard<py::gil_scoped_release>(),
+             R"pbdoc(
+                Run histories [first_history, first_history + num_photons) of the
+                first run of a simulator with this seed and return their raw tally.
+
+                The simulator stream is not advanced. summarize(run_tally(E, 0, N), N, E)
+                is the result of run(E, N) on a fresh simulator, and merging
+                run_tally(E, N, M) extends it to N + M histories (identical to a
+                fresh run of N + M with PHILOX, statistically equivalent with MT19937).
+             )pbdoc")
+        .def("summarize", &MonteCarloSimulator::summarize,
+             py::arg("tally"),
+             py::arg("num_photons"),
+             py::arg("source_energy_MeV"),
+             py::arg("elapsed_seconds") = 0.0,
+             "Turn the tally of num_photons histories into a MonteCarloResult for the current layers")
+        .def("run_checkpointed", &MonteCarloSimulator::runCheckpointed,
+             py::arg("source_energy_MeV"),
+             py::arg("checkpoint_path"),
+             py::arg("num_photons"),
+             py::arg("checkpoint_photons") = 10000000,
+             py::arg("first_history") = 0,
+             py::arg("num_threads") = 1,
+             py::arg("engine") = TransportEngine::Scalar,
+             py::arg("variance_reduction") = VarianceReduction(),
+             py::arg("mesh_tallies") = MeshTallies(),
+             py::call_guard<py::gil_scoped_release>(),
+             R"pbdoc(
+                Run histories [first_history, first_history + num_photons) of the
+                first run of this seed (as run_tally), saving a checkpoint every
+                checkpoint_photons histories.
+
+                If checkpoint_path already holds a checkpoint of this configuration
+                and range, the run resumes after its last saved history; the result
+                is identical to an uninterrupted run. A checkpoint of another
+                configuration raises ValueError. Disjoint ranges run by separate
+                processes are combined with merge_checkpoints.
+             )pbdoc")
+        .def("merge_checkpoints", &MonteCarloSimulator::mergeCheckpoints,
+             py::arg("checkpoint_paths"),
+             py::call_guard<py::gil_scoped_release>(),
+             R"pbdoc(
+                Combine the checkpoints of disjoint history ranges of one run into a
+                single MonteCarloResult (summarized with the current layers).
+
+                Raises ValueError if the checkpoints come from different runs or
+                configurations, or if their ranges overlap.
+             )pbdoc")
+        .def("run_batch",
+             [](const MonteCarloSimulator& sim, Int64Array layer_offsets, Int32Array material_ids,
+                DoubleArray thickness_cm, DoubleArray energy_MeV, Int32Array num_photons,
+                DoubleArray mu_total, DoubleArray mu_compton, DoubleArray mu_photoelectric,
+                DoubleArray density_g_cm3, std::vector<std::string> material_names,
+                int num_threads, TransportEngine engine, const VarianceReduction& variance_reduction) {
+                 const py::ssize_t num_configs = energy_MeV.size();
+                 const py::ssize_t num_materials = mu_total.size();
+                 if (layer_offsets.ndim() != 1 || layer_offsets.size() != num_configs + 1 ||
+                     num_photons.size() != num_configs) {
+                     throw py::value_error("layer_offsets needs one entry per configuration plus one, "
+                                           "num_photons one per configuration");
+                 }
+                 if (material_ids.size() != thickness_cm.size() ||
+                     material_ids.size() != layer_offsets.at(num_configs)) {
+                     throw py::value_error("material_ids and thickness_cm need one entry per layer");
+                 }
+                 if (mu_compton.size() != num_materials || mu_photoelectric.size() != num_materials ||
+                     density_g_cm3.size() != num_materials ||
+                     (!material_names.empty() &&
+                      static_cast<py::ssize_t>(material_names.size()) != num_materials)) {
+                     throw py::value_error("Material arrays need one entry per material");
+                 }
+
+                 std::vector<MaterialLayer> materials;
+                 for (py::ssize_t i = 0; i < num_materials; ++i) {
+                     std::string name = material_names.empty() ? "material_" + std::to_string(i)
+                                                               : material_names[i];
+                     materials.emplace_back(name, 0.0, mu_total.at(i), mu_compton.at(i),
+                                            mu_photoelectric.at(i), density_g_cm3.at(i));
+                 }
+                 ShieldBatch batch{layer_offsets.data(), material_ids.data(), thickness_cm.data(),
+                                   energy_MeV.data(), num_photons.data(),
+                                   static_cast<std::size_t>(num_configs)};
+
+                 py::array_t<BatchResult> results(num_configs);
+                 BatchResult* out = results.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     sim.runBatch(std::move(materials), batch, out, num_threads, engine,
+                                  variance_reduction);
+                 }
+                 return results;
+             },
+             py::arg("layer_offsets"),
+             py::arg("material_ids"),
+             py::arg("thickness_cm"),
+             py::arg("energy_MeV"),
+             py::arg("num_photons"),
+             py::arg("mu_total"),
+             py::arg("mu_compton"),
+             py::arg("mu_photoelectric"),
+             py::arg("density_g_cm3"),
+             py::arg("material_names") = std::vector<std::string>(),
+             py::arg("num_threads") = 0,
+             py::arg("engine") = TransportEngine::Scalar,
+             py::arg("variance_reduction") = VarianceReduction(),
+             R"pbdoc(
+                Simulate many shield configurations in one native call.
+
+                Parameters:
+                -----------
+                layer_offsets : numpy.ndarray of int64, shape (n_configs + 1,)
+                    Configuration c uses layers layer_offsets[c]:layer_offsets[c + 1]
+                material_ids : numpy.ndarray of int32, shape (n_layers,)
+                    Material index of each layer (into the material arrays)
+                thickness_cm : numpy.ndarray, shape (n_layers,)
+                    Thickness of each layer in cm
+                energy_MeV : numpy.ndarray, shape (n_configs,)
+                    Source energy of each configuration
+                num_photons : numpy.ndarray of int32, shape (n_configs,)
+                    Histories of each configuration
+                mu_total, mu_compton, mu_photoelectric, density_g_cm3 : numpy.ndarray
+                    Coefficients (cm^-1) and density (g/cm^3) per material
+                material_names : list of str, optional
+                    Material names; tables set with set_cross_sections are
+                    attached by name
+                num_threads : int, optional
+                    Worker threads (default: 0 = all cores). Configurations are
+                    split into photon chunks scheduled by work stealing; the GIL
+                    is released.
+                engine : TransportEngine, optional
+                    Transport kernel (default: SCALAR)
+                variance_reduction : VarianceReduction, optional
+                    Applied to every configuration (stretch must be empty, use
+                    auto_stretch)
+
+                Returns:
+                --------
+                numpy.ndarray
+                    Structured array with one row per configuration and the
+                    fields transmission_factor, transmission_uncertainty,
+                    dose_transmitted, dose_absorbed, buildup_factor,
+                    uncertainty, relative_uncertainty, elapsed_seconds,
+                    total_photons, transmitted_photons. Each chunk of
+                    configuration c uses a stream keyed by (seed, c, chunk),
+                    so results do not depend on num_threads.
+             )pbdoc")
         .def("get_num_layers", &MonteCarloSimulator::getNumLayers,
              "Get the number of layers in the current shield configuration")
         .def("__repr__", [](const MonteCarloSimulator& sim) {
             return "MonteCarloSimulator(layers=" + std::to_string(sim.getNumLayers()) + ")";
         });
 
+    // Tabulated G-P buildup factors of one material
+    py::class_<BuildupTable>(m, "BuildupTable")
+        .def(py::init<const std::vector<double>&, const std::vector<double>&,
+                      const std::vector<double>&, const std::vector<double>&,
+                      const std::vector<double>&, const std::vector<double>&>(),
+             py::arg("energy_MeV"), py::arg("b"), py::arg("c"), py::arg("a"),
+             py::arg("xk"), py::arg("d"),
+             R"pbdoc(
+                G-P (geometric progression) dose buildup parameters tabulated in
+                energy, e.g. from ANSI/ANS-6.4.3. Parameters are interpolated
+                linearly in ln(E) and clamped outside the table.
+
+                Raises ValueError unless the energies are positive and strictly
+                increasing, the columns have equal lengths, b >= 1, c > 0 and xk > 0.
+             )pbdoc")
+        .def("buildup", &BuildupTable::buildup, py::arg("energy_MeV"), py::arg("mfp"),
+             "Buildup factor at a depth of mfp mean free paths")
+        .def("__len__", &BuildupTable::size);
+
+    // Batch analytical evaluation for grid search
+    m.def("evaluate_shields",
+          [](DoubleArray thickness_cm, DoubleArray mu_cm, DoubleArray density_g_cm3,
+             double source_intensity, double area_m2, int num_threads,
+             std::vector<std::optional<BuildupTable>> buildup, double energy_MeV) {
+              if (thickness_cm.ndim() != 2) {
+                  throw py::value_error("thickness_cm must be a 2D array (shields x materials)");
+              }
+              const py::ssize_t num_shields = thickness_cm.shape(0);
+              const py::ssize_t num_materials = thickness_cm.shape(1);
+              if (mu_cm.ndim() != 1 || mu_cm.shape(0) != num_materials ||
+                  density_g_cm3.ndim() != 1 || density_g_cm3.shape(0) != num_materials) {
+                  throw py::value_error("mu_cm and density_g_cm3 must have one entry per column");
+              }
+              if (!buildup.empty() && static_cast<py::ssize_t>(buildup.size()) != num_materials) {
+                  throw py::value_error("buildup must have one entry (or None) per column");
+              }
+
+              // Buildup curves at the source energy, sampled once per call
+              std::vector<BuildupCurve> curves;
+              for (const auto& table : buildup) {
+                  curves.emplace_back(table ? table->at(energy_MeV) : kNoBuildup);
+              }
+
+              py::array_t<double> dose(num_shields);
+              py::array_t<double> mass_kg(num_shields);
+              const double* t = thickness_cm.data();
+              const double* mu = mu_cm.data();
+              const double* rho = density_g_cm3.data();
+              double* dose_out = dose.mutable_data();
+              double* mass_out = mass_kg.mutable_data();
+              {
+                  py::gil_scoped_release release;
+                  evaluateShields(t, num_shields, num_materials, mu, rho,
+                                  source_intensity, area_m2, dose_out, mass_out, num_threads,
+                                  curves.empty() ? nullptr : curves.data());
+              }
+              return py::make_tuple(dose, mass_kg);
+          },
+          py::arg("thickness_cm"),
+          py::arg("mu_cm"),
+          py::arg("density_g_cm3"),
+          py::arg("source_intensity") = 1.0,
+          py::arg("area_m2") = 1.0,
+          py::arg("num_threads") = 0,
+          py::arg("buildup") = std::vector<std::optional<BuildupTable>>(),
+          py::arg("energy_MeV") = 1.0,
+          R"pbdoc(
+                Evaluate many shield designs at once (Beer-Lambert dose and mass).
+
+                Parameters:
+                -----------
+                thickness_cm : numpy.ndarray, shape (n_shields, n_materials)
+                    Layer thicknesses in cm, one row per design. C-contiguous
+                    float64 arrays are read in place without copying.
+                mu_cm : numpy.ndarray, shape (n_materials,)
+                    Linear attenuation coefficients in cm^-1
+                density_g_cm3 : numpy.ndarray, shape (n_materials,)
+                    Densities in g/cm^3
+                source_intensity : float, optional
+                    Source intensity S (default: 1.0)
+                area_m2 : float, optional
+                    Shield area in m^2 (default: 1.0)
+                num_threads : int, optional
+                    Worker threads (default: 0 = all cores). The GIL is released.
+                buildup : list of BuildupTable or None, optional
+                    One G-P table (or None) per column, columns being layers in
+                    order from the source. When given, the dose is the point-kernel
+                    estimate S * exp(-sum mu t) * B with Broder's multilayer buildup
+                    factor B at energy_MeV (tabulated in depth, ~1e-3 relative
+                    accuracy); None columns only attenuate.
+                energy_MeV : float, optional
+                    Source energy used to look up the buildup tables (default: 1.0)
+
+                Returns:
+                --------
+                tuple of numpy.ndarray
+                    (dose, mass_kg), each of shape (n_shields,)
+             )pbdoc");
+
+    // Surrogate model of the Monte Carlo transmission
+    py::class_<SurrogateEnsemble>(m, "SurrogateEnsemble")
+        .def(py::init([](std::vector<double> input_shift, std::vector<double> input_scale,
+                         std::vector<std::vector<std::pair<DoubleArray, DoubleArray>>> members) {
+                 std::vector<std::vector<DenseLayer>> networks;
+                 for (const auto& member : members) {
+                     std::vector<DenseLayer> layers;
+                     for (const auto& [weights, bias] : member) {
+                         if (weights.ndim() != 2 || bias.ndim() != 1) {
+                             throw py::value_error("Each layer needs a 2D weight matrix and a 1D bias");
+                         }
+                         layers.push_back({static_cast<int>(weights.shape(1)),
+                                           static_cast<int>(weights.shape(0)),
+                                           std::vector<double>(weights.data(), weights.data() + weights.size()),
+                                           std::vector<double>(bias.data(), bias.data() + bias.size())});
+                     }
+                     networks.push_back(std::move(layers));
+                 }
+                 return SurrogateEnsemble(std::move(input_shift), std::move(input_scale),
+                                          std::move(networks));
+             }),
+             py::arg("input_shift"), py::arg("input_scale"), py::arg("members"),
+             R"pbdoc(
+                Ensemble of MLPs (ReLU hidden layers, linear scalar output).
+
+                Parameters:
+                -----------
+                input_shift, input_scale : list of float
+                    Inputs are standardized as (x - shift) / scale
+                members : list of list of (weights, bias)
+                    Layers of each member; weights has shape (outputs, inputs),
+                    as in torch.nn.Linear
+
+                Raises ValueError on inconsistent shapes.
+             )pbdoc")
+        .def_property_readonly("num_inputs", &SurrogateEnsemble::numInputs)
+        .def_property_readonly("num_members", &SurrogateEnsemble::numMembers)
+        .def("evaluate",
+             [](const SurrogateEnsemble& ensemble, DoubleArray features, int num_threads) {
+                 if (features.ndim() != 2 || features.shape(1) != ensemble.numInputs()) {
+                     throw py::value_error("features must have shape (n_rows, num_inputs)");
+                 }
+                 const py::ssize_t num_rows = features.shape(0);
+                 py::array_t<double> mean(num_rows);
+                 py::array_t<double> stddev(num_rows);
+                 const double* x = features.data();
+                 double* mean_out = mean.mutable_data();
+                 double* stddev_out = stddev.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     ensemble.evaluate(x, num_rows, mean_out, stddev_out, num_threads);
+                 }
+                 return py::make_tuple(mean, stddev);
+             },
+             py::arg("features"),
+             py::arg("num_threads") = 0,
+             R"pbdoc(
+                Evaluate every member on each row of features.
+
+                Returns:
+                --------
+                tuple of numpy.ndarray
+                    (mean, stddev) of the member outputs, each of shape (n_rows,).
+                    The GIL is released.
+             )pbdoc");
+
     // Module-level constants
     m.attr("ELECTRON_REST_MASS_MEV") = ELECTRON_REST_MASS_MEV;
+    m.attr("INSTRUMENTED") = kInstrumented;
     m.attr("__version__") = "0.1.0";
 }
@@ -0,0 +1,98 @@
+#include "buildup.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace shield_lite {
+
+double gpBuildup(const GPParameters& p, double mfp) {
+    if (p.b == 1.0 || mfp <= 0) {
+        return 1.0;
+    }
+    // K(x) = c x^a + d [tanh(x/Xk - 2) - tanh(-2)] / [1 - tanh(-2)]
+    constexpr double tanh_minus_2 = -0.96402758007581688395;
+    const double K = p.c * std::pow(mfp, p.a) +
+                     p.d * (std::tanh(mfp / p.xk - 2.0) - tanh_minus_2) / (1.0 - tanh_minus_2);
+    // B(x) = 1 + (b - 1) (K^x - 1) / (K - 1), i.e. 1 + (b - 1) x when K = 1
+    if (std::abs(K - 1.0) < 1e-9) {
+        return 1.0 + (p.b - 1.0) * mfp;
+    }
+    return 1.0 + (p.b - 1.0) * std::expm1(mfp * std::log(K)) / (K - 1.0);
+}
+
+BuildupTable::BuildupTable(const std::vector<double>& energy_MeV,
+                           const std::vector<double>& b,
+                           const std::vector<double>& c,
+                           const std::vector<double>& a,
+                           const std::vector<double>& xk,
+                           const std::vector<double>& d) {
+    const std::size_t n = energy_MeV.size();
+    if (n < 1 || b.size() != n || c.size() != n || a.size() != n || xk.size() != n ||
+        d.size() != n) {
+        throw std::invalid_argument("Buildup tables need at least 1 point and equal lengths");
+    }
+    log_energy_.reserve(n);
+    params_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (energy_MeV[i] <= 0 || (i > 0 && energy_MeV[i] <= energy_MeV[i - 1])) {
+            throw std::invalid_argument("Energies must be positive and strictly increasing");
+        }
+        if (b[i] < 1 || c[i] <= 0 || xk[i] <= 0) {
+            throw std::invalid_argument("G-P parameters need b >= 1, c > 0 and Xk > 0");
+        }
+        log_energy_.push_back(std::log(energy_MeV[i]));
+        params_.push_back({b[i], c[i], a[i], xk[i], d[i]});
+    }
+}
+
+GPParameters BuildupTable::at(double energy_MeV) const {
+    const double log_energy = std::log(energy_MeV);
+    if (!(log_energy > log_energy_.front())) {
+        return params_.front();
+    }
+    if (log_energy >= log_energy_.back()) {
+        return params_.back();
+    }
+    const std::size_t i = static_cast<std::size_t>(
+        std::upper_bound(log_energy_.begin(), log_energy_.end(), log_energy) - log_energy_.begin()) - 1;
+    const double f = (log_energy - log_energy_[i]) / (log_energy_[i + 1] - log_energy_[i]);
+    const GPParameters& p = params_[i];
+    const GPParameters& q = params_[i + 1];
+    return {p.b + f * (q.b - p.b), p.c + f * (q.c - p.c), p.a + f * (q.a - p.a),
+            p.xk + f * (q.xk - p.xk), p.d + f * (q.d - p.d)};
+}
+
+BuildupCurve::BuildupCurve(const GPParameters& p, double max_mfp, int points_per_mfp)
+    : params_(p), points_per_mfp_(points_per_mfp), last_position_(0.0) {
+    if (max_mfp <= 0 || points_per_mfp < 1) {
+        throw std::invalid_argument("Buildup curves need a positive depth range and resolution");
+    }
+    if (p.b == 1.0) {
+        return;
+    }
+    const int num_points = static_cast<int>(std::ceil(max_mfp * points_per_mfp)) + 1;
+    last_position_ = num_points - 1;
+    samples_.resize(num_points - 1);
+    double value = 1.0;
+    for (int i = 0; i + 1 < num_points; ++i) {
+        const double next = gpBuildup(p, (i + 1) / points_per_mfp_);
+        samples_[i] = {value, next - value};
+        value = next;
+    }
+}
+
+double multilayerBuildup(const GPParameters* params, const double* mfp, std::size_t num_layers) {
+    double buildup = 1.0;
+    double depth = 0.0;
+    for (std::size_t n = 0; n < num_layers; ++n) {
+        if (mfp[n] <= 0) {
+            continue;
+        }
+        const double entry = depth;
+        depth += mfp[n];
+        buildup += gpBuildup(params[n], depth) - gpBuildup(params[n], entry);
+    }
+    return buildup;
+}
+
+} // namespace shield_lite
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace shield_lite {
+
+// Geometric-progression (G-P) dose buildup parameters at one energy
+// (Harima et al., ANSI/ANS-6.4.3 tables)
+struct GPParameters {
+    double b;    // Buildup factor at 1 mfp
+    double c;
+    double a;
+    double xk;   // Depth (mfp) of the tanh transition
+    double d;
+};
+
+// Parameters for which gpBuildup is exactly 1 (no buildup)
+constexpr GPParameters kNoBuildup = {1.0, 1.0, 0.0, 1.0, 0.0};
+
+// G-P buildup factor at a depth of mfp mean free paths (the fit is
+// published for 0 to 40 mfp)
+double gpBuildup(const GPParameters& p, double mfp);
+
+// G-P parameters of one material tabulated in energy. Between tabulated
+// energies the parameters are interpolated linearly in ln(E); energies
+// outside the table are clamped to its end points.
+class BuildupTable {
+public:
+    // Energies strictly increasing in MeV, one parameter set per energy.
+    // Throws std::invalid_argument on inconsistent input.
+    BuildupTable(const std::vector<double>& energy_MeV,
+                 const std::vector<double>& b,
+                 const std::vector<double>& c,
+                 const std::vector<double>& a,
+                 const std::vector<double>& xk,
+                 const std::vector<double>& d);
+
+    GPParameters at(double energy_MeV) const;
+
+    double buildup(double energy_MeV, double mfp) const {
+        return gpBuildup(at(energy_MeV), mfp);
+    }
+
+    std::size_t size() const { return params_.size(); }
+
+private:
+    std::vector<double> log_energy_;
+    std::vector<GPParameters> params_;
+};
+
+// G-P buildup factor of one material at a fixed energy, sampled on a
+// uniform depth grid and interpolated linearly (a few ns per lookup instead
+// of five transcendental calls). Depths beyond the grid use gpBuildup.
+class BuildupCurve {
+public:
+    explicit BuildupCurve(const GPParameters& p = kNoBuildup,
+                          double max_mfp = 40.0,
+                          int points_per_mfp = 64);
+
+    double operator()(double mfp) const {
+        if (samples_.empty() || mfp <= 0) {
+            return 1.0;
+        }
+        const double x = mfp * points_per_mfp_;
+        if (x >= last_position_) {
+            return gpBuildup(params_, mfp);
+        }
+        const int i = static_cast<int>(x);
+        const Sample& s = samples_[i];
+        return s.value + (x - i) * s.slope;
+    }
+
+private:
+    struct Sample {
+        double value;   // B at the grid point
+        double slope;   // Difference to the next grid point
+    };
+
+    GPParameters params_;
+    double points_per_mfp_;
+    double last_position_;
+    std::vector<Sample> samples_;   // Empty when there is no buildup
+};
+
+// Multilayer buildup factor (Broder): with X_n the optical depth at the exit
+// of layer n, B = 1 + sum_n [B_n(X_n) - B_n(X_{n-1})], each layer's term
+// taken from its own material. params and mfp hold one entry per layer in
+// order from the source; with a single material this is B(X).
+double multilayerBuildup(const GPParameters* params, const double* mfp, std::size_t num_layers);
+
+} // namespace shield_lite
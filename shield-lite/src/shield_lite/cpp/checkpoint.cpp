@@ -0,0 +1,214 @@
+#include "checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace shield_lite {
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'L', 'C', 'K', 'P', 'T', '\0', '\0'};
+constexpr uint32_t kVersion = 2;   // 2 adds the secondary photon tallies
+
+class Writer {
+public:
+    template <typename T>
+    void put(const T& value) {
+        bytes_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void put(const StreamingTally& t) {
+        put(t.count());
+        put(t.mean());
+        put(t.m2());
+        put(t.m3());
+        put(t.m4());
+    }
+
+    void put(const Histogram& h) {
+        put(h.lower());
+        put(h.upper());
+        put(static_cast<uint64_t>(h.values().size()));
+        bytes_.append(reinterpret_cast<const char*>(h.data()), h.values().size() * sizeof(double));
+    }
+
+    std::string& bytes() { return bytes_; }
+
+private:
+    std::string bytes_;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::string& bytes) : bytes_(bytes), offset_(0) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    StreamingTally getTally() {
+        const long long count = get<long long>();
+        const double mean = get<double>();
+        const double m2 = get<double>();
+        const double m3 = get<double>();
+        const double m4 = get<double>();
+        return StreamingTally::fromMoments(count, mean, m2, m3, m4);
+    }
+
+    Histogram getHistogram() {
+        const double lower = get<double>();
+        const double upper = get<double>();
+        const uint64_t bins = get<uint64_t>();
+        if (bins > (bytes_.size() - offset_) / sizeof(double)) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+        std::vector<double> values(bins);
+        read(values.data(), bins * sizeof(double));
+        return Histogram(lower, upper, std::move(values));
+    }
+
+    void skip(std::size_t size) {
+        if (bytes_.size() - offset_ < size) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+        offset_ += size;
+    }
+
+    bool done() const { return offset_ == bytes_.size(); }
+
+private:
+    void read(void* out, std::size_t size) {
+        if (bytes_.size() - offset_ < size) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+        std::memcpy(out, bytes_.data() + offset_, size);
+        offset_ += size;
+    }
+
+    const std::string& bytes_;
+    std::size_t offset_;
+};
+
+} // namespace
+
+std::string serializeCheckpoint(const Checkpoint& checkpoint) {
+    Writer w;
+    w.bytes().append(kMagic, sizeof(kMagic));
+    w.put(kVersion);
+    w.put(checkpoint.config_hash);
+    w.put(checkpoint.run_key);
+    w.put(checkpoint.first_history);
+    w.put(checkpoint.next_history);
+    w.put(checkpoint.end_history);
+    w.put(checkpoint.source_energy_MeV);
+    w.put(checkpoint.elapsed_seconds);
+    const TransportTally& t = checkpoint.tally;
+    w.put(t.transmitted);
+    w.put(t.history_weight);
+    w.put(t.history_dose);
+    w.put(t.dose_absorbed);
+    w.put(t.collisions);
+    w.put(t.depth_dose);
+    w.put(t.spectrum);
+    w.put(t.secondary_weight);
+    w.put(t.secondary_dose);
+    w.put(t.secondary_spectrum);
+    return std::move(w.bytes());
+}
+
+Checkpoint deserializeCheckpoint(const std::string& bytes) {
+    if (bytes.size() < sizeof(kMagic) || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a shield_lite checkpoint");
+    }
+    Reader r(bytes);
+    r.skip(sizeof(kMagic));
+    const uint32_t version = r.get<uint32_t>();
+    if (version < 1 || version > kVersion) {
+        throw std::runtime_error("Unsupported checkpoint version");
+    }
+    Checkpoint checkpoint;
+    checkpoint.config_hash = r.get<uint64_t>();
+    checkpoint.run_key = r.get<uint64_t>();
+    checkpoint.first_history = r.get<uint64_t>();
+    checkpoint.next_history = r.get<uint64_t>();
+    checkpoint.end_history = r.get<uint64_t>();
+    checkpoint.source_energy_MeV = r.get<double>();
+    checkpoint.elapsed_seconds = r.get<double>();
+    TransportTally& t = checkpoint.tally;
+    t.transmitted = r.getTally();
+    t.history_weight = r.getTally();
+    t.history_dose = r.getTally();
+    t.dose_absorbed = r.get<double>();
+    t.collisions = r.get<long long>();
+    t.depth_dose = r.getHistogram();
+    t.spectrum = r.getHistogram();
+    if (version >= 2) {
+        t.secondary_weight = r.get<double>();
+        t.secondary_dose = r.get<double>();
+        t.secondary_spectrum = r.getHistogram();
+    }
+    if (!r.done() || checkpoint.next_history < checkpoint.first_history) {
+        throw std::runtime_error("Corrupt checkpoint");
+    }
+    return checkpoint;
+}
+
+void saveCheckpoint(const std::string& path, const Checkpoint& checkpoint) {
+    const std::string bytes = serializeCheckpoint(checkpoint);
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Cannot write checkpoint " + tmp_path);
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Cannot replace checkpoint " + path);
+    }
+}
+
+Checkpoint loadCheckpoint(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open checkpoint " + path);
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return deserializeCheckpoint(bytes);
+}
+
+MergedCheckpoints mergeCheckpoints(std::vector<Checkpoint> parts) {
+    MergedCheckpoints merged;
+    if (parts.empty()) {
+        return merged;
+    }
+    std::sort(parts.begin(), parts.end(), [](const Checkpoint& a, const Checkpoint& b) {
+        return a.first_history < b.first_history;
+    });
+    const Checkpoint& reference = parts.front();
+    merged.source_energy_MeV = reference.source_energy_MeV;
+    merged.config_hash = reference.config_hash;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        const Checkpoint& part = parts[i];
+        if (part.config_hash != reference.config_hash || part.run_key != reference.run_key) {
+            throw std::invalid_argument("Checkpoints come from different runs or configurations");
+        }
+        if (i > 0 && part.first_history < parts[i - 1].next_history) {
+            throw std::invalid_argument("Checkpoint history ranges overlap");
+        }
+        merged.tally.merge(part.tally);
+        merged.num_photons += part.histories();
+        merged.elapsed_seconds += part.elapsed_seconds;
+    }
+    return merged;
+}
+
+} // namespace shield_lite
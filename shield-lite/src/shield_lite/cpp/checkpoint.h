@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "photon_transport.h"
+
+namespace shield_lite {
+
+// Tally of a range of histories of one run, with what is needed to resume
+// the range or merge it with ranges run elsewhere. A run's random streams
+// are a function of (run_key, history index) only, so the position to
+// resume from is next_history.
+struct Checkpoint {
+    uint64_t config_hash = 0;      // PhotonTransport::configurationHash of the run
+    uint64_t run_key = 0;          // Key of the run's streams
+    uint64_t first_history = 0;    // Histories [first_history, next_history) are tallied
+    uint64_t next_history = 0;
+    uint64_t end_history = 0;      // End of the range to run (exclusive)
+    double source_energy_MeV = 0.0;
+    double elapsed_seconds = 0.0;  // Accumulated run time
+    TransportTally tally;          // Instrumentation counters are not saved
+
+    long long histories() const { return static_cast<long long>(next_history - first_history); }
+    bool complete() const { return next_history >= end_history; }
+};
+
+// Compact binary form (native little-endian doubles and integers, ~200
+// bytes plus the histogram bins), e.g. to send between processes
+std::string serializeCheckpoint(const Checkpoint& checkpoint);
+
+// Throws std::runtime_error if the bytes are not a checkpoint of this version
+Checkpoint deserializeCheckpoint(const std::string& bytes);
+
+// Write to path atomically (a temporary file renamed over it), so a run
+// killed while saving keeps its previous checkpoint.
+// Throws std::runtime_error on I/O errors.
+void saveCheckpoint(const std::string& path, const Checkpoint& checkpoint);
+
+// Throws std::runtime_error if the file is missing or not a checkpoint
+Checkpoint loadCheckpoint(const std::string& path);
+
+// Sum of the checkpoints of disjoint history ranges of the same run
+struct MergedCheckpoints {
+    TransportTally tally;
+    long long num_photons = 0;
+    double elapsed_seconds = 0.0;  // Run time summed over the parts
+    double source_energy_MeV = 0.0;
+    uint64_t config_hash = 0;
+};
+
+// Throws std::invalid_argument if the parts come from different runs or
+// configurations, or if their ranges overlap. Tallies are merged in history
+// order, so the result does not depend on the order of the parts.
+MergedCheckpoints mergeCheckpoints(std::vector<Checkpoint> parts);
+
+} // namespace shield_lite
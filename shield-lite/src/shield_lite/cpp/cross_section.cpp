@@ -0,0 +1,69 @@
+#include "cross_section.h"
+#include <stdexcept>
+
+namespace shield_lite {
+
+namespace {
+
+// Log-log interpolation of y(E) between tabulated points, zeros kept linear
+double interpolateLogLog(const std::vector<double>& energy, const std::vector<double>& y,
+                         std::size_t i, double E) {
+    double e0 = energy[i], e1 = energy[i + 1];
+    double y0 = y[i], y1 = y[i + 1];
+    if (y0 <= 0 || y1 <= 0) {
+        return y0 + (y1 - y0) * (E - e0) / (e1 - e0);
+    }
+    double t = std::log(E / e0) / std::log(e1 / e0);
+    return y0 * std::pow(y1 / y0, t);
+}
+
+} // namespace
+
+CrossSectionTable::CrossSectionTable(const std::vector<double>& energy_MeV,
+                                     const std::vector<double>& mu_total_cm,
+                                     const std::vector<double>& mu_compton_cm,
+                                     const std::vector<double>& mu_photoelectric_cm,
+                                     int points_per_decade) {
+    const std::size_t n = energy_MeV.size();
+    if (n < 2 || mu_total_cm.size() != n || mu_compton_cm.size() != n ||
+        mu_photoelectric_cm.size() != n) {
+        throw std::invalid_argument("Cross-section tables need at least 2 points and equal lengths");
+    }
+    if (points_per_decade < 1) {
+        throw std::invalid_argument("points_per_decade must be positive");
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        if (energy_MeV[i] <= 0 || (i > 0 && energy_MeV[i] <= energy_MeV[i - 1])) {
+            throw std::invalid_argument("Energies must be positive and strictly increasing");
+        }
+        if (mu_total_cm[i] <= 0 || mu_compton_cm[i] < 0 || mu_photoelectric_cm[i] < 0) {
+            throw std::invalid_argument("Attenuation coefficients must be non-negative (mu_total > 0)");
+        }
+    }
+
+    const double log_min = std::log(energy_MeV.front());
+    const double log_max = std::log(energy_MeV.back());
+    const double decades = (log_max - log_min) / std::log(10.0);
+    const std::size_t num_points = std::max<std::size_t>(
+        2, static_cast<std::size_t>(std::ceil(decades * points_per_decade)) + 1);
+    const double log_step = (log_max - log_min) / (num_points - 1);
+
+    log_energy_min_ = log_min;
+    inv_log_step_ = 1.0 / log_step;
+    // Clamp just below the last point so the right neighbour always exists
+    max_position_ = static_cast<double>(num_points - 1) * (1.0 - 1e-12);
+
+    points_.reserve(num_points);
+    std::size_t segment = 0;
+    for (std::size_t k = 0; k < num_points; ++k) {
+        double E = (k + 1 == num_points) ? energy_MeV.back() : std::exp(log_min + k * log_step);
+        while (segment + 2 < n && E > energy_MeV[segment + 1]) {
+            ++segment;
+        }
+        points_.push_back({interpolateLogLog(energy_MeV, mu_total_cm, segment, E),
+                           interpolateLogLog(energy_MeV, mu_compton_cm, segment, E),
+                           interpolateLogLog(energy_MeV, mu_photoelectric_cm, segment, E)});
+    }
+}
+
+} // namespace shield_lite
@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace shield_lite {
+
+// Linear attenuation coefficients at one energy (cm^-1)
+struct Attenuation {
+    double mu_total_cm;
+    double mu_compton_cm;
+    double mu_photoelectric_cm;
+};
+
+// Natural log for positive normal inputs, ~1e-9 absolute error: accurate
+// enough for a grid position at a fraction of the cost of std::log
+inline double fastLog(double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    int exponent = static_cast<int>(bits >> 52) - 1023;
+    bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+    double m;
+    std::memcpy(&m, &bits, sizeof(m));
+    if (m > 1.41421356237309504880) {
+        m *= 0.5;
+        ++exponent;
+    }
+    // ln(m) = 2 atanh(f), f = (m - 1) / (m + 1), |f| <= 0.1716
+    double f = (m - 1.0) / (m + 1.0);
+    double s = f * f;
+    double p = 1.0 + s * (1.0 / 3.0 + s * (1.0 / 5.0 + s * (1.0 / 7.0 + s * (1.0 / 9.0))));
+    return exponent * 0.69314718055994530942 + 2.0 * f * p;
+}
+
+// Energy-dependent attenuation coefficients resampled on a uniform grid in
+// ln(E). The grid index is computed directly from the energy (no search) and
+// neighbouring points are stored interleaved, so a lookup touches a single
+// cache line. Energies outside the table are clamped to its end points.
+class CrossSectionTable {
+public:
+    // Build from tabulated data (e.g. NIST XCOM), energies strictly increasing
+    // in MeV. The data are interpolated log-log onto the uniform grid.
+    // Throws std::invalid_argument on inconsistent input.
+    CrossSectionTable(const std::vector<double>& energy_MeV,
+                      const std::vector<double>& mu_total_cm,
+                      const std::vector<double>& mu_compton_cm,
+                      const std::vector<double>& mu_photoelectric_cm,
+                      int points_per_decade = 100);
+
+    Attenuation lookup(double energy_MeV) const {
+        double x = (fastLog(energy_MeV) - log_energy_min_) * inv_log_step_;
+        x = std::min(std::max(x, 0.0), max_position_);
+        int i = static_cast<int>(x);
+        double f = x - i;
+        const Attenuation& a = points_[i];
+        const Attenuation& b = points_[i + 1];
+        return {a.mu_total_cm + f * (b.mu_total_cm - a.mu_total_cm),
+                a.mu_compton_cm + f * (b.mu_compton_cm - a.mu_compton_cm),
+                a.mu_photoelectric_cm + f * (b.mu_photoelectric_cm - a.mu_photoelectric_cm)};
+    }
+
+    double minEnergy() const { return std::exp(log_energy_min_); }
+    double maxEnergy() const { return std::exp(log_energy_min_ + max_position_ / inv_log_step_); }
+    std::size_t size() const { return points_.size(); }
+    const std::vector<Attenuation>& points() const { return points_; }
+
+    // Grid parameters, for copies of the table (gpu_transport.cu)
+    double logEnergyMin() const { return log_energy_min_; }
+    double invLogStep() const { return inv_log_step_; }
+    double maxPosition() const { return max_position_; }
+
+private:
+    double log_energy_min_;
+    double inv_log_step_;
+    double max_position_;              // Last position with a right neighbour (size - 1 - eps)
+    std::vector<Attenuation> points_;
+};
+
+} // namespace shield_lite
@@ -0,0 +1,306 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "cross_section.h"
+#include "host_device.h"
+#include "klein_nishina.h"
+
+// One photon history of the GPU backend (gpu_transport.cu), written against
+// plain arrays so the same code compiles for the device and the host. It
+// follows PhotonTransport::transportPhoton step by step and draws from the
+// same Philox stream per history, so a history takes the same path as on
+// the CPU with RandomGenerator::Philox, up to floating-point rounding.
+// Particle splitting is not supported (no particle bank on the device).
+
+namespace shield_lite {
+namespace gpu {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kCutoffEnergy = 0.01;   // MeV, as the CPU transport
+
+// Layer of the device shield; table indexes Shield::tables (-1 = constant coefficients)
+struct Layer {
+    double start_z, end_z;
+    double stretch;
+    double mu_total_cm, mu_compton_cm, mu_photoelectric_cm;
+    int table;
+};
+
+// CrossSectionTable grid; its points start at Shield::points[offset]
+struct Table {
+    double log_energy_min, inv_log_step, max_position;
+    int offset;
+};
+
+// Everything a history reads, as flat arrays (device or host pointers)
+struct Shield {
+    const Layer* layers;
+    int num_layers;
+    double total_thickness;
+    const Table* tables;
+    const Attenuation* points;
+    const double* klein_nishina;          // KleinNishinaTable::data()
+    double kn_log_energy_min, kn_inv_log_step;
+    bool implicit_capture;
+    double roulette_weight, survival_weight;
+};
+
+// Outcome of a history
+struct History {
+    bool transmitted;
+    double energy_MeV;
+    double weight;
+    long long collisions;
+};
+
+// Philox4x32-10 stream with the word order of Philox4x32 (random.h)
+class PhiloxStream {
+public:
+    SHIELD_LITE_HD PhiloxStream(uint64_t key, uint64_t stream)
+        : k0_(static_cast<uint32_t>(key)), k1_(static_cast<uint32_t>(key >> 32)),
+          stream_(stream), position_(0), index_(4) {}
+
+    SHIELD_LITE_HD uint32_t next() {
+        if (index_ == 4) {
+            block();
+            index_ = 0;
+        }
+        return buffer_[index_++];
+    }
+
+    // Uniform double in [0, 1) from two words, as uniform(Philox4x32&)
+    SHIELD_LITE_HD double uniform() {
+        const uint32_t hi = next();
+        const uint32_t lo = next();
+        return ((hi >> 5) * 67108864.0 + (lo >> 6)) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    SHIELD_LITE_HD void block() {
+        uint32_t c0 = static_cast<uint32_t>(position_), c1 = static_cast<uint32_t>(position_ >> 32);
+        uint32_t c2 = static_cast<uint32_t>(stream_), c3 = static_cast<uint32_t>(stream_ >> 32);
+        uint32_t k0 = k0_, k1 = k1_;
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+            const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+            const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<uint32_t>(p1);
+            c3 = static_cast<uint32_t>(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        buffer_[0] = c0;
+        buffer_[1] = c1;
+        buffer_[2] = c2;
+        buffer_[3] = c3;
+        ++position_;
+    }
+
+    uint32_t k0_, k1_;
+    uint64_t stream_, position_;
+    uint32_t buffer_[4];
+    int index_;
+};
+
+// fastLog (cross_section.h)
+SHIELD_LITE_HD inline double logApprox(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int exponent = static_cast<int>(bits >> 52) - 1023;
+    bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+    double m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > 1.41421356237309504880) {
+        m *= 0.5;
+        ++exponent;
+    }
+    double f = (m - 1.0) / (m + 1.0);
+    double s = f * f;
+    double p = 1.0 + s * (1.0 / 3.0 + s * (1.0 / 5.0 + s * (1.0 / 7.0 + s * (1.0 / 9.0))));
+    return exponent * 0.69314718055994530942 + 2.0 * f * p;
+}
+
+// LayerRecord::attenuation
+SHIELD_LITE_HD inline Attenuation attenuation(const Shield& shield, const Layer& layer, double energy_MeV) {
+    if (layer.table < 0) {
+        return {layer.mu_total_cm, layer.mu_compton_cm, layer.mu_photoelectric_cm};
+    }
+    const Table& t = shield.tables[layer.table];
+    double x = (logApprox(energy_MeV) - t.log_energy_min) * t.inv_log_step;
+    x = x < 0.0 ? 0.0 : (x > t.max_position ? t.max_position : x);
+    const int i = static_cast<int>(x);
+    const double f = x - i;
+    const Attenuation& a = shield.points[t.offset + i];
+    const Attenuation& b = shield.points[t.offset + i + 1];
+    return {a.mu_total_cm + f * (b.mu_total_cm - a.mu_total_cm),
+            a.mu_compton_cm + f * (b.mu_compton_cm - a.mu_compton_cm),
+            a.mu_photoelectric_cm + f * (b.mu_photoelectric_cm - a.mu_photoelectric_cm)};
+}
+
+// Compton scattering as PhotonTransport::comptonScatter: KleinNishinaTable
+// inside its range, Kahn's method outside
+SHIELD_LITE_HD inline void comptonScatter(const Shield& shield, PhiloxStream& rng, double& energy_MeV,
+                                          double& dx, double& dy, double& dz) {
+    const double alpha = energy_MeV / ELECTRON_REST_MASS_MEV;
+    double energy_ratio, cos_theta;
+    if (energy_MeV >= KleinNishinaTable::kMinEnergy && energy_MeV <= KleinNishinaTable::kMaxEnergy) {
+        // KleinNishinaTable::sample
+        const int energies = KleinNishinaTable::kEnergies, quantiles = KleinNishinaTable::kQuantiles;
+        const double u = rng.uniform();
+        double pe = (logApprox(energy_MeV) - shield.kn_log_energy_min) * shield.kn_inv_log_step;
+        const double pe_max = static_cast<double>(energies - 1) * (1.0 - 1e-12);
+        pe = pe < 0.0 ? 0.0 : (pe > pe_max ? pe_max : pe);
+        const double pu = u * (quantiles - 1);
+        const int ie = static_cast<int>(pe);
+        const int iu = static_cast<int>(pu);
+        const double fe = pe - ie, fu = pu - iu;
+        const double* row = &shield.klein_nishina[ie * quantiles + iu];
+        const double lo = row[0] + fu * (row[1] - row[0]);
+        const double hi = row[quantiles] + fu * (row[quantiles + 1] - row[quantiles]);
+        const double q = lo + fe * (hi - lo);
+        energy_ratio = std::exp(-q * std::log1p(2.0 * alpha));
+        cos_theta = 1.0 - (1.0 / energy_ratio - 1.0) / alpha;
+    } else {
+        // sampleKahn (klein_nishina.h)
+        const double beta = 1.0 + 2.0 * alpha;
+        const double p_branch = beta / (9.0 + 2.0 * alpha);
+        while (true) {
+            const double r1 = rng.uniform(), r2 = rng.uniform(), r3 = rng.uniform();
+            double x;
+            if (r1 <= p_branch) {
+                x = 1.0 + 2.0 * alpha * r2;
+                if (r3 > 4.0 * (1.0 / x - 1.0 / (x * x))) {
+                    continue;
+                }
+                cos_theta = 1.0 - (x - 1.0) / alpha;
+            } else {
+                x = beta / (1.0 + 2.0 * alpha * r2);
+                cos_theta = 1.0 - (x - 1.0) / alpha;
+                if (r3 > 0.5 * (cos_theta * cos_theta + 1.0 / x)) {
+                    continue;
+                }
+            }
+            energy_ratio = 1.0 / x;
+            break;
+        }
+    }
+    const double phi = 2.0 * kPi * rng.uniform();
+    energy_MeV *= energy_ratio;
+
+    const double sin2 = 1.0 - cos_theta * cos_theta;
+    const double sin_theta = std::sqrt(sin2 > 0.0 ? sin2 : 0.0);
+    const double cos_phi = std::cos(phi);
+    const double sin_phi = std::sin(phi);
+    const double u = dx, v = dy, w = dz;
+    if (std::fabs(w) > 0.99999) {
+        dx = sin_theta * cos_phi;
+        dy = sin_theta * sin_phi;
+        dz = (w > 0 ? cos_theta : -cos_theta);
+    } else {
+        const double t = std::sqrt(1.0 - w * w);
+        dx = sin_theta * (u * w * cos_phi - v * sin_phi) / t + u * cos_theta;
+        dy = sin_theta * (v * w * cos_phi + u * sin_phi) / t + v * cos_theta;
+        dz = w * cos_theta - sin_theta * cos_phi * t;
+    }
+}
+
+// History `history` of the run keyed by run_key; deposit(z, energy) is
+// called for every energy deposition in the shield
+template <typename Deposit>
+SHIELD_LITE_HD History runHistory(const Shield& shield, uint64_t run_key, uint64_t history,
+                                  double source_energy_MeV, Deposit&& deposit) {
+    PhiloxStream rng(run_key, history);
+    History out = {false, source_energy_MeV, 1.0, 0};
+    double z = 0.0, dx = 0.0, dy = 0.0, dz = 1.0;
+    double& energy = out.energy_MeV;
+    double& weight = out.weight;
+    bool alive = true;
+
+    // PhotonTransport::findLayer(0): first layer ending above the source face
+    int layer_idx = 0;
+    while (layer_idx < shield.num_layers && !(shield.layers[layer_idx].end_z > z)) {
+        ++layer_idx;
+    }
+    if (layer_idx == shield.num_layers) {
+        layer_idx = -1;
+    }
+
+    while (alive && z < shield.total_thickness && energy > kCutoffEnergy) {
+        if (layer_idx < 0) {
+            out.transmitted = true;
+            break;
+        }
+
+        const Layer& layer = shield.layers[layer_idx];
+        const Attenuation att = attenuation(shield, layer, energy);
+
+        const double mu = att.mu_total_cm;
+        const double stretch = layer.stretch;
+        const double sigma = (stretch > 0) ? mu * (1.0 - stretch * dz) : mu;
+        const double free_path = -std::log(rng.uniform()) / sigma;
+
+        const bool backward = dz < 0;
+        const double boundary_z = backward ? layer.start_z : layer.end_z;
+        const double distance_to_boundary = (boundary_z - z) / std::fabs(dz);
+        const bool collision = free_path < distance_to_boundary;
+
+        if (stretch > 0) {
+            const double path = collision ? free_path : distance_to_boundary;
+            weight *= std::exp((sigma - mu) * path) * (collision ? mu / sigma : 1.0);
+        }
+
+        if (collision) {
+            z += free_path * dz;
+            ++out.collisions;
+
+            if (shield.implicit_capture) {
+                const double p_scatter = att.mu_compton_cm / att.mu_total_cm;
+                deposit(z, energy * weight * (1.0 - p_scatter));
+                weight *= p_scatter;
+            } else if (!(rng.uniform() < att.mu_compton_cm / att.mu_total_cm)) {
+                deposit(z, energy * weight);
+                alive = false;
+                break;
+            }
+
+            const double incident_energy = energy;
+            comptonScatter(shield, rng, energy, dx, dy, dz);
+            deposit(z, (incident_energy - energy) * weight);
+
+            // Russian roulette (PhotonTransport::applyWeightWindow without splitting)
+            if (energy >= kCutoffEnergy && weight < shield.roulette_weight) {
+                if (rng.uniform() * shield.survival_weight < weight) {
+                    weight = shield.survival_weight;
+                } else {
+                    alive = false;
+                    break;
+                }
+            }
+        } else if (backward) {
+            z = boundary_z;
+            if (--layer_idx < 0) {
+                alive = false;
+                break;
+            }
+        } else {
+            z = boundary_z;
+            layer_idx = (layer_idx + 1 < shield.num_layers) ? layer_idx + 1 : -1;
+        }
+
+        if (energy < kCutoffEnergy) {
+            alive = false;
+        }
+    }
+
+    if (z >= shield.total_thickness && alive) {
+        out.transmitted = true;
+    }
+    return out;
+}
+
+} // namespace gpu
+} // namespace shield_lite
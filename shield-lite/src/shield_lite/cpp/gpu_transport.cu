@@ -0,0 +1,265 @@
+#include "gpu_transport.h"
+#include "gpu_history.h"
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace shield_lite {
+
+namespace {
+
+constexpr int kThreadsPerBlock = 256;
+constexpr int kBlocks = 2048;                       // Fixed: the reduction order does not depend on the device
+constexpr long long kLaunchHistories = 1LL << 26;   // Histories per launch, keeps each kernel short
+
+void check(cudaError_t status, const char* what) {
+    if (status != cudaSuccess) {
+        throw std::runtime_error(std::string(what) + ": " + cudaGetErrorString(status));
+    }
+}
+
+// Owning device copy of an array
+template <typename T>
+class DeviceArray {
+public:
+    explicit DeviceArray(std::size_t size) : data_(nullptr), size_(size) {
+        if (size_ > 0) {
+            check(cudaMalloc(&data_, size_ * sizeof(T)), "cudaMalloc");
+        }
+    }
+
+    DeviceArray(const T* host, std::size_t size) : DeviceArray(size) {
+        if (size_ > 0) {
+            check(cudaMemcpy(data_, host, size_ * sizeof(T), cudaMemcpyHostToDevice), "cudaMemcpy");
+        }
+    }
+
+    ~DeviceArray() { cudaFree(data_); }
+
+    DeviceArray(const DeviceArray&) = delete;
+    DeviceArray& operator=(const DeviceArray&) = delete;
+
+    T* get() const { return data_; }
+
+    void zero() {
+        if (size_ > 0) {
+            check(cudaMemset(data_, 0, size_ * sizeof(T)), "cudaMemset");
+        }
+    }
+
+    // Copy back once the work queued on stream is done
+    std::vector<T> download(cudaStream_t stream) const {
+        std::vector<T> host(size_);
+        if (size_ > 0) {
+            check(cudaMemcpyAsync(host.data(), data_, size_ * sizeof(T), cudaMemcpyDeviceToHost, stream),
+                  "cudaMemcpyAsync");
+        }
+        check(cudaStreamSynchronize(stream), "transportKernel");
+        return host;
+    }
+
+private:
+    T* data_;
+    std::size_t size_;
+};
+
+// Stream of one run, so the kernels of runs from several host threads
+// (run_batch) overlap. A blocking stream: it waits for the uploads and
+// memsets issued on the default stream.
+class DeviceStream {
+public:
+    DeviceStream() { check(cudaStreamCreate(&stream_), "cudaStreamCreate"); }
+    ~DeviceStream() { cudaStreamDestroy(stream_); }
+
+    DeviceStream(const DeviceStream&) = delete;
+    DeviceStream& operator=(const DeviceStream&) = delete;
+
+    cudaStream_t get() const { return stream_; }
+
+private:
+    cudaStream_t stream_;
+};
+
+// Tally of a thread, then of a block
+struct Partial {
+    StreamingTally transmitted;
+    StreamingTally history_weight;
+    StreamingTally history_dose;
+    double dose_absorbed;
+    long long collisions;
+
+    __device__ void merge(const Partial& other) {
+        transmitted.merge(other.transmitted);
+        history_weight.merge(other.history_weight);
+        history_dose.merge(other.history_dose);
+        dose_absorbed += other.dose_absorbed;
+        collisions += other.collisions;
+    }
+};
+
+// Histogram::add into device memory (values == nullptr: disabled)
+struct DeviceHistogram {
+    double* values;
+    int bins;
+    double lower, inv_width;
+
+    __device__ void add(double x, double weight) const {
+        if (values == nullptr) {
+            return;
+        }
+        const double position = (x - lower) * inv_width;
+        const int bin = position <= 0 ? 0 : min(static_cast<int>(position), bins - 1);
+        atomicAdd(&values[bin], weight);
+    }
+};
+
+// Grid-stride loop over histories: thread t runs histories t, t + stride, ...
+__global__ void transportKernel(gpu::Shield shield, uint64_t run_key, uint64_t first_history,
+                                long long num_photons, double source_energy_MeV,
+                                DeviceHistogram depth_dose, DeviceHistogram spectrum, Partial* partials) {
+    Partial partial;
+    partial.dose_absorbed = 0.0;
+    partial.collisions = 0;
+
+    const long long stride = static_cast<long long>(gridDim.x) * blockDim.x;
+    for (long long i = static_cast<long long>(blockIdx.x) * blockDim.x + threadIdx.x; i < num_photons;
+         i += stride) {
+        const gpu::History history = gpu::runHistory(
+            shield, run_key, first_history + i, source_energy_MeV, [&](double z, double energy) {
+                partial.dose_absorbed += energy;
+                depth_dose.add(z, energy);
+            });
+        partial.collisions += history.collisions;
+        if (history.transmitted) {
+            // Without splitting, a history transmits at most one particle
+            const double dose = history.energy_MeV * history.weight;
+            partial.transmitted.add(dose);
+            spectrum.add(history.energy_MeV, history.weight);
+            if (history.weight > 0) {
+                partial.history_weight.add(history.weight);
+                partial.history_dose.add(dose);
+            }
+        }
+    }
+
+    // Tree reduction of the block (raw storage: __shared__ variables cannot
+    // have constructors)
+    __shared__ __align__(8) unsigned char storage[kThreadsPerBlock * sizeof(Partial)];
+    Partial* shared = reinterpret_cast<Partial*>(storage);
+    shared[threadIdx.x] = partial;
+    __syncthreads();
+    for (int half = blockDim.x / 2; half > 0; half /= 2) {
+        if (threadIdx.x < half) {
+            shared[threadIdx.x].merge(shared[threadIdx.x + half]);
+        }
+        __syncthreads();
+    }
+    if (threadIdx.x == 0) {
+        partials[blockIdx.x] = shared[0];
+    }
+}
+
+DeviceHistogram deviceHistogram(DeviceArray<double>& values, int bins, double upper) {
+    if (bins <= 0) {
+        return {nullptr, 0, 0.0, 0.0};
+    }
+    return {values.get(), bins, 0.0, upper > 0 ? bins / upper : 0.0};
+}
+
+} // namespace
+
+int gpuDeviceCount() {
+    int count = 0;
+    if (cudaGetDeviceCount(&count) != cudaSuccess) {
+        cudaGetLastError();   // Clear the error (no driver or no device)
+        return 0;
+    }
+    return count;
+}
+
+TransportTally runHistoriesGpu(const std::vector<LayerRecord>& records, double total_thickness,
+                               const VarianceReduction& variance_reduction, const MeshTallies& mesh_tallies,
+                               uint64_t run_key, uint64_t first_history, double source_energy_MeV,
+                               long long num_photons, RunControl* control) {
+    // Flatten the layers and their cross-section tables (one copy per table)
+    std::vector<gpu::Layer> layers;
+    std::vector<gpu::Table> tables;
+    std::vector<Attenuation> points;
+    std::vector<const CrossSectionTable*> table_sources;
+    for (const LayerRecord& record : records) {
+        int table = -1;
+        if (record.cross_sections) {
+            auto it = std::find(table_sources.begin(), table_sources.end(), record.cross_sections);
+            table = static_cast<int>(it - table_sources.begin());
+            if (it == table_sources.end()) {
+                const CrossSectionTable& source = *record.cross_sections;
+                tables.push_back({source.logEnergyMin(), source.invLogStep(), source.maxPosition(),
+                                  static_cast<int>(points.size())});
+                points.insert(points.end(), source.points().begin(), source.points().end());
+                table_sources.push_back(record.cross_sections);
+            }
+        }
+        layers.push_back({record.start_z, record.end_z, record.stretch, record.mu_total_cm,
+                          record.mu_compton_cm, record.mu_photoelectric_cm, table});
+    }
+    const KleinNishinaTable& klein_nishina = KleinNishinaTable::instance();
+
+    DeviceArray<gpu::Layer> device_layers(layers.data(), layers.size());
+    DeviceArray<gpu::Table> device_tables(tables.data(), tables.size());
+    DeviceArray<Attenuation> device_points(points.data(), points.size());
+    DeviceArray<double> device_klein_nishina(
+        klein_nishina.data(), KleinNishinaTable::kEnergies * KleinNishinaTable::kQuantiles);
+    DeviceArray<double> depth_values(std::max(mesh_tallies.depth_bins, 0));
+    DeviceArray<double> spectrum_values(std::max(mesh_tallies.spectrum_bins, 0));
+    DeviceArray<Partial> partials(kBlocks);
+    depth_values.zero();
+    spectrum_values.zero();
+
+    const gpu::Shield shield = {
+        device_layers.get(), static_cast<int>(layers.size()), total_thickness,
+        device_tables.get(), device_points.get(),
+        device_klein_nishina.get(), klein_nishina.logEnergyMin(), klein_nishina.invLogStep(),
+        variance_reduction.implicit_capture, variance_reduction.roulette_weight,
+        variance_reduction.survival_weight,
+    };
+    const DeviceHistogram depth_dose = deviceHistogram(depth_values, mesh_tallies.depth_bins, total_thickness);
+    const DeviceHistogram spectrum = deviceHistogram(spectrum_values, mesh_tallies.spectrum_bins,
+                                                     source_energy_MeV);
+
+    // Block partials are merged in block order, launch after launch
+    DeviceStream stream;
+    TransportTally tally;
+    for (long long done = 0; done < num_photons; done += kLaunchHistories) {
+        if (control && control->cancelled()) {
+            throw RunCancelled();
+        }
+        const long long count = std::min(kLaunchHistories, num_photons - done);
+        transportKernel<<<kBlocks, kThreadsPerBlock, 0, stream.get()>>>(
+            shield, run_key, first_history + done, count, source_energy_MeV, depth_dose, spectrum,
+            partials.get());
+        check(cudaGetLastError(), "transportKernel launch");
+        TransportTally launch;
+        for (const Partial& partial : partials.download(stream.get())) {
+            launch.transmitted.merge(partial.transmitted);
+            launch.history_weight.merge(partial.history_weight);
+            launch.history_dose.merge(partial.history_dose);
+            launch.dose_absorbed += partial.dose_absorbed;
+            launch.collisions += partial.collisions;
+        }
+        tally.merge(launch);
+        if (control) {
+            control->chunkDone(launch, count);
+        }
+    }
+
+    if (mesh_tallies.depth_bins > 0) {
+        tally.depth_dose = Histogram(0.0, total_thickness, depth_values.download(stream.get()));
+    }
+    if (mesh_tallies.spectrum_bins > 0) {
+        tally.spectrum = Histogram(0.0, source_energy_MeV, spectrum_values.download(stream.get()));
+    }
+    return tally;
+}
+
+} // namespace shield_lite
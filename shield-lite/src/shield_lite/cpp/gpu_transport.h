@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "photon_transport.h"
+
+// CUDA backend of TransportEngine::Gpu (gpu_transport.cu, built with the
+// SHIELD_LITE_CUDA CMake option). Each device thread runs whole histories
+// (history-based kernel) with the Philox stream of the history, and the
+// tallies are reduced on the device: per thread, then per block in shared
+// memory, with the block partials merged on the host in block order. The
+// launch shape is fixed, so a run gives the same result on any device.
+
+namespace shield_lite {
+
+// Number of CUDA devices (0 without a driver or a device)
+int gpuDeviceCount();
+
+// Tally of histories [first_history, first_history + num_photons) of the
+// run keyed by run_key, as PhotonTransport::runHistories with Philox.
+// Layers come from the packed records (stretch resolved by prepare).
+// Mesh tallies are scored with device atomics, so their bins are
+// reproducible up to rounding only. A control is updated and checked for
+// cancellation between kernel launches. Throws std::runtime_error on CUDA
+// errors and RunCancelled if the control is cancelled.
+TransportTally runHistoriesGpu(const std::vector<LayerRecord>& layers, double total_thickness,
+                               const VarianceReduction& variance_reduction, const MeshTallies& mesh_tallies,
+                               uint64_t run_key, uint64_t first_history, double source_energy_MeV,
+                               long long num_photons, RunControl* control = nullptr);
+
+} // namespace shield_lite
@@ -0,0 +1,78 @@
+#include "grid_kernel.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace shield_lite {
+
+namespace {
+
+// Below this many rows per worker, thread startup costs more than it saves
+constexpr std::size_t MIN_SHIELDS_PER_THREAD = 4096;
+
+void evaluateRange(const double* thickness_cm, std::size_t begin, std::size_t end,
+                   std::size_t num_materials, const double* mu_cm,
+                   const double* density_g_cm3, double source_intensity,
+                   double area_m2, double* dose, double* mass_kg,
+                   const BuildupCurve* buildup) {
+    // kg = (area_m2 * 1e4 cm^2) * t_cm * rho_g_cm3 / 1000
+    const double mass_scale = area_m2 * 10.0;
+    for (std::size_t s = begin; s < end; ++s) {
+        const double* row = thickness_cm + s * num_materials;
+        double mu_t = 0.0;
+        double areal_density = 0.0;
+        double buildup_factor = 1.0;
+        for (std::size_t m = 0; m < num_materials; ++m) {
+            const double entry = mu_t;
+            mu_t += mu_cm[m] * row[m];
+            areal_density += density_g_cm3[m] * row[m];
+            // Broder's multilayer rule, inlined (see multilayerBuildup)
+            if (buildup && mu_t > entry) {
+                buildup_factor += buildup[m](mu_t) - buildup[m](entry);
+            }
+        }
+        dose[s] = source_intensity * std::exp(-mu_t) * buildup_factor;
+        mass_kg[s] = mass_scale * areal_density;
+    }
+}
+
+} // namespace
+
+void evaluateShields(const double* thickness_cm,
+                     std::size_t num_shields,
+                     std::size_t num_materials,
+                     const double* mu_cm,
+                     const double* density_g_cm3,
+                     double source_intensity,
+                     double area_m2,
+                     double* dose,
+                     double* mass_kg,
+                     int num_threads,
+                     const BuildupCurve* buildup) {
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t max_threads = std::max<std::size_t>(1, num_shields / MIN_SHIELDS_PER_THREAD);
+    std::size_t workers_count = std::min<std::size_t>(num_threads, max_threads);
+
+    if (workers_count == 1) {
+        evaluateRange(thickness_cm, 0, num_shields, num_materials, mu_cm, density_g_cm3,
+                      source_intensity, area_m2, dose, mass_kg, buildup);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(workers_count);
+    for (std::size_t t = 0; t < workers_count; ++t) {
+        std::size_t begin = num_shields * t / workers_count;
+        std::size_t end = num_shields * (t + 1) / workers_count;
+        workers.emplace_back(evaluateRange, thickness_cm, begin, end, num_materials, mu_cm,
+                             density_g_cm3, source_intensity, area_m2, dose, mass_kg, buildup);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace shield_lite
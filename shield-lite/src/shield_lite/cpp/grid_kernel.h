@@ -0,0 +1,28 @@
+#pragma once
+#include "buildup.h"
+#include <cstddef>
+
+namespace shield_lite {
+
+// Batch evaluation of analytical (Beer-Lambert) shield designs.
+// thickness_cm is a row-major [num_shields x num_materials] matrix; for each
+// row the dose S * exp(-sum_i mu_i t_i) and the mass (kg) over area_m2 are
+// written to dose and mass_kg. Rows are split over num_threads workers
+// (<= 0 uses all hardware threads).
+// With buildup (the G-P curve of each column at the source energy, columns
+// in layer order from the source), the dose is the point-kernel estimate
+// S * exp(-sum_i mu_i t_i) * B, with B the multilayer buildup factor (see
+// multilayerBuildup); columns with a default curve only attenuate.
+void evaluateShields(const double* thickness_cm,
+                     std::size_t num_shields,
+                     std::size_t num_materials,
+                     const double* mu_cm,
+                     const double* density_g_cm3,
+                     double source_intensity,
+                     double area_m2,
+                     double* dose,
+                     double* mass_kg,
+                     int num_threads = 0,
+                     const BuildupCurve* buildup = nullptr);
+
+} // namespace shield_lite
@@ -0,0 +1,9 @@
+#pragma once
+
+// Qualifier of the code shared by the CPU transport and the CUDA kernel
+// (gpu_transport.cu); empty when the file is not compiled by nvcc
+#ifdef __CUDACC__
+#define SHIELD_LITE_HD __host__ __device__
+#else
+#define SHIELD_LITE_HD
+#endif
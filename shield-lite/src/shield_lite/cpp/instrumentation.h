@@ -0,0 +1,110 @@
+#pragma once
+#include <chrono>
+
+// Optional transport instrumentation: event counters and phase timers,
+// compiled in with -DSHIELD_LITE_INSTRUMENT (CMake option
+// SHIELD_LITE_INSTRUMENTATION). Without it count() and PhaseTimer are empty
+// inline functions and the stats stay zero, so the hot paths are unchanged.
+// Stats live in the chunk tally (one chunk runs on one thread) and are
+// merged with it.
+
+namespace shield_lite {
+
+#ifdef SHIELD_LITE_INSTRUMENT
+constexpr bool kInstrumented = true;
+#else
+constexpr bool kInstrumented = false;
+#endif
+
+// Phases timed by the engines. The scalar engine only times Flight (the
+// whole transportPhoton call, random numbers included); the batched engine
+// times all four.
+enum class TransportPhase {
+    Source,     // Refilling lanes from the source
+    Random,     // Drawing the lane random numbers
+    Flight,     // Free flight, collision and scattering
+    Resolve,    // Scalar pass: layer changes, tallies, compaction
+    Count
+};
+
+constexpr int kPhases = static_cast<int>(TransportPhase::Count);
+constexpr int kEnergyBins = 4;  // Collisions below 0.1 MeV, 0.1-1, 1-10, above 10 MeV
+
+struct TransportStats {
+    long long flights = 0;              // Free-flight steps (collision or boundary)
+    long long boundary_crossings = 0;
+    long long compton = 0;              // Scatters (every collision with implicit capture)
+    long long photoelectric = 0;
+    long long cutoff_kills = 0;         // Photons dropped below the 0.01 MeV cutoff
+    long long roulette_kills = 0;
+    long long backscatter_escapes = 0;  // Photons leaving through the source face
+    long long secondaries = 0;          // Annihilation and fluorescence photons emitted
+    long long bank_overflows = 0;       // Secondaries deposited locally (bank full)
+    long long collisions_by_energy[kEnergyBins] = {};
+    double phase_seconds[kPhases] = {}; // Summed over threads
+
+    void merge(const TransportStats& other) {
+        flights += other.flights;
+        boundary_crossings += other.boundary_crossings;
+        compton += other.compton;
+        photoelectric += other.photoelectric;
+        cutoff_kills += other.cutoff_kills;
+        roulette_kills += other.roulette_kills;
+        backscatter_escapes += other.backscatter_escapes;
+        secondaries += other.secondaries;
+        bank_overflows += other.bank_overflows;
+        for (int i = 0; i < kEnergyBins; ++i) {
+            collisions_by_energy[i] += other.collisions_by_energy[i];
+        }
+        for (int i = 0; i < kPhases; ++i) {
+            phase_seconds[i] += other.phase_seconds[i];
+        }
+    }
+};
+
+// Add to a counter (no-op without SHIELD_LITE_INSTRUMENT)
+inline void count([[maybe_unused]] long long& counter, [[maybe_unused]] long long n = 1) {
+    if constexpr (kInstrumented) {
+        counter += n;
+    }
+}
+
+// Count a collision of a photon of the given energy
+inline void countCollision([[maybe_unused]] TransportStats& stats, [[maybe_unused]] double energy_MeV) {
+    if constexpr (kInstrumented) {
+        int bin = energy_MeV < 0.1 ? 0 : energy_MeV < 1.0 ? 1 : energy_MeV < 10.0 ? 2 : 3;
+        ++stats.collisions_by_energy[bin];
+    }
+}
+
+// Adds the lifetime of the scope to a phase (no-op without SHIELD_LITE_INSTRUMENT)
+class PhaseTimer {
+public:
+    PhaseTimer([[maybe_unused]] TransportStats& stats, [[maybe_unused]] TransportPhase phase) {
+        if constexpr (kInstrumented) {
+            seconds_ = &stats.phase_seconds[static_cast<int>(phase)];
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~PhaseTimer() { stop(); }
+
+    // End the phase before the end of the scope
+    void stop() {
+        if constexpr (kInstrumented) {
+            if (seconds_) {
+                *seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+                seconds_ = nullptr;
+            }
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    double* seconds_ = nullptr;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace shield_lite
@@ -0,0 +1,63 @@
+#include "klein_nishina.h"
+
+namespace shield_lite {
+
+namespace {
+
+// Fine integration steps per energy when building the table
+constexpr int kIntegrationSteps = 4096;
+
+// Klein-Nishina density in q = ln(E / E') / ln(1 + 2 alpha), up to a constant
+double densityInQ(double q, double alpha, double log_beta) {
+    double eps = std::exp(-q * log_beta);
+    double cos_theta = 1.0 - (1.0 / eps - 1.0) / alpha;
+    double sin2 = std::max(0.0, 1.0 - cos_theta * cos_theta);
+    return 1.0 + eps * eps - eps * sin2;
+}
+
+} // namespace
+
+const KleinNishinaTable& KleinNishinaTable::instance() {
+    static const KleinNishinaTable table;
+    return table;
+}
+
+KleinNishinaTable::KleinNishinaTable()
+    : log_energy_min_(std::log(kMinEnergy)),
+      inv_log_step_(kPointsPerDecade / std::log(10.0)),
+      q_(static_cast<std::size_t>(kEnergies) * kQuantiles) {
+    const double h = 1.0 / kIntegrationSteps;
+    std::vector<double> cdf(kIntegrationSteps + 1);
+
+    for (int ie = 0; ie < kEnergies; ++ie) {
+        double energy = std::exp(log_energy_min_ + ie / inv_log_step_);
+        double alpha = energy / ELECTRON_REST_MASS_MEV;
+        double log_beta = std::log1p(2.0 * alpha);
+
+        // Cumulative density on a fine q grid (Simpson on each step)
+        cdf[0] = 0.0;
+        for (int k = 0; k < kIntegrationSteps; ++k) {
+            double q0 = k * h;
+            cdf[k + 1] = cdf[k] + h / 6.0 * (densityInQ(q0, alpha, log_beta) +
+                                             4.0 * densityInQ(q0 + 0.5 * h, alpha, log_beta) +
+                                             densityInQ(q0 + h, alpha, log_beta));
+        }
+        const double total = cdf[kIntegrationSteps];
+
+        // Invert at evenly spaced probabilities (the density is nearly
+        // constant within a fine step, so linear inversion is enough)
+        double* row = &q_[static_cast<std::size_t>(ie) * kQuantiles];
+        row[0] = 0.0;
+        row[kQuantiles - 1] = 1.0;
+        int k = 0;
+        for (int iu = 1; iu < kQuantiles - 1; ++iu) {
+            double target = total * iu / (kQuantiles - 1);
+            while (cdf[k + 1] < target) {
+                ++k;
+            }
+            row[iu] = (k + (target - cdf[k]) / (cdf[k + 1] - cdf[k])) * h;
+        }
+    }
+}
+
+} // namespace shield_lite
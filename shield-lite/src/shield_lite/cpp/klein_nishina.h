@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "cross_section.h"
+
+// Klein-Nishina sampling of the Compton scattering angle.
+// Two samplers of the same distribution are provided: Kahn's rejection
+// method (exact, any energy) and a rejection-free inverse CDF tabulated on
+// a (ln E, u) grid, which the transport uses inside its energy range.
+
+namespace shield_lite {
+
+constexpr double ELECTRON_REST_MASS_MEV = 0.511; // MeV
+
+// Outcome of one scattering: E' / E and the cosine of the polar angle
+struct ComptonSample {
+    double energy_ratio;
+    double cos_theta;
+};
+
+// Kahn's rejection method (Kahn 1956, as in MCNP); next() returns uniform
+// numbers in [0, 1). Accepts 60-80% of the tries over 10 keV - 10 MeV.
+template <typename Uniform>
+ComptonSample sampleKahn(double alpha, Uniform&& next) {
+    const double beta = 1.0 + 2.0 * alpha;
+    const double p_branch = beta / (9.0 + 2.0 * alpha);
+    while (true) {
+        // x = E / E' in [1, 1 + 2 alpha]
+        double r1 = next(), r2 = next(), r3 = next();
+        double x, cos_theta;
+        if (r1 <= p_branch) {
+            x = 1.0 + 2.0 * alpha * r2;
+            if (r3 > 4.0 * (1.0 / x - 1.0 / (x * x))) {
+                continue;
+            }
+            cos_theta = 1.0 - (x - 1.0) / alpha;
+        } else {
+            x = beta / (1.0 + 2.0 * alpha * r2);
+            cos_theta = 1.0 - (x - 1.0) / alpha;
+            if (r3 > 0.5 * (cos_theta * cos_theta + 1.0 / x)) {
+                continue;
+            }
+        }
+        return {1.0 / x, cos_theta};
+    }
+}
+
+// Inverse CDF of the Klein-Nishina distribution in q = ln(E / E') / ln(1 + 2 alpha).
+// In q the density is 1 + eps^2 - eps sin^2(theta) (eps = E' / E), bounded
+// in [0.75, 2] at every energy, so q(u) is smooth and bilinear
+// interpolation in (ln E, u) is accurate with a small table (~100 KB): the
+// mean energy ratio is biased by less than 5e-5 (relative) over 10 keV - 100 MeV.
+class KleinNishinaTable {
+public:
+    static constexpr double kMinEnergy = 1e-3;      // MeV
+    static constexpr double kMaxEnergy = 1e3;       // MeV
+    static constexpr int kPointsPerDecade = 16;
+    static constexpr int kEnergies = 6 * kPointsPerDecade + 1;
+    static constexpr int kQuantiles = 129;
+
+    // Shared table, built on first use
+    static const KleinNishinaTable& instance();
+
+    bool covers(double energy_MeV) const {
+        return energy_MeV >= kMinEnergy && energy_MeV <= kMaxEnergy;
+    }
+
+    // Sample at an energy inside [kMinEnergy, kMaxEnergy] from one uniform u in [0, 1)
+    ComptonSample sample(double energy_MeV, double u) const {
+        double alpha = energy_MeV / ELECTRON_REST_MASS_MEV;
+        double q = quantile(fastLog(energy_MeV), u);
+        double energy_ratio = std::exp(-q * std::log1p(2.0 * alpha));
+        return {energy_ratio, 1.0 - (1.0 / energy_ratio - 1.0) / alpha};
+    }
+
+    // Bilinear interpolation of q at (ln E, u)
+    double quantile(double log_energy, double u) const {
+        double pe = (log_energy - log_energy_min_) * inv_log_step_;
+        pe = std::min(std::max(pe, 0.0), static_cast<double>(kEnergies - 1) * (1.0 - 1e-12));
+        double pu = u * (kQuantiles - 1);
+        int ie = static_cast<int>(pe);
+        int iu = static_cast<int>(pu);
+        double fe = pe - ie, fu = pu - iu;
+        const double* row = &q_[ie * kQuantiles + iu];
+        double lo = row[0] + fu * (row[1] - row[0]);
+        double hi = row[kQuantiles] + fu * (row[kQuantiles + 1] - row[kQuantiles]);
+        return lo + fe * (hi - lo);
+    }
+
+    // Raw layout for the SIMD kernel: q[ie * kQuantiles + iu]
+    const double* data() const { return q_.data(); }
+    double logEnergyMin() const { return log_energy_min_; }
+    double invLogStep() const { return inv_log_step_; }
+
+private:
+    KleinNishinaTable();
+
+    double log_energy_min_;
+    double inv_log_step_;
+    std::vector<double> q_;
+};
+
+} // namespace shield_lite
@@ -1,4 +1,11 @@
+#include "async_run.h"
+#include "checkpoint.h"
 #include "photon_transport.h"
+#include "run_batch.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <fstream>
 #include <map>
 #include <stdexcept>
 
@@ -7,7 +14,7 @@ namespace shield_lite {
 // Helper class for easy Python interface
 class MonteCarloSimulator {
 public:
-    MonteCarloSimulator(unsigned int seed = 42) : transport_(seed) {}
+    MonteCarloSimulator(unsigned int seed = 42) : transport_(seed), seed_(seed) {}
 
     // Add a material layer to the shield
     void addLayer(const std::string& material_name,
@@ -20,17 +27,251 @@ public:
                            mu_compton, mu_photoelectric, density_g_cm3);
     }
 
+    // Append material_names.size() layers given as columns (one native call
+    // for a whole shield)
+    void addLayers(const std::vector<std::string>& material_names,
+                   const double* thickness_cm,
+                   const double* mu_total,
+                   const double* mu_compton,
+                   const double* mu_photoelectric,
+                   const double* density_g_cm3) {
+        layers_.reserve(layers_.size() + material_names.size());
+        for (size_t i = 0; i < material_names.size(); ++i) {
+            layers_.emplace_back(material_names[i], thickness_cm[i], mu_total[i],
+                                 mu_compton[i], mu_photoelectric[i], density_g_cm3[i]);
+        }
+    }
+
+    // Layers added so far, in order from the source
+    const std::vector<MaterialLayer>& layers() const {
+        return layers_;
+    }
+
+    // Generator used by run, run_until and run_batch
+    void setRandomGenerator(RandomGenerator generator) {
+        transport_.setRandomGenerator(generator);
+    }
+
+    RandomGenerator getRandomGenerator() const {
+        return transport_.randomGenerator();
+    }
+
     // Clear all layers
     void clearLayers() {
         layers_.clear();
     }
 
+    // Attach energy-dependent coefficients to every layer of this material.
+    // The table is built once and shared by all the layers that use it.
+    void setCrossSections(const std::string& material_name,
+                          const std::vector<double>& energy_MeV,
+                          const std::vector<double>& mu_total,
+                          const std::vector<double>& mu_compton,
+                          const std::vector<double>& mu_photoelectric,
+                          int points_per_decade = 100) {
+        cross_sections_[material_name] = std::make_shared<const CrossSectionTable>(
+            energy_MeV, mu_total, mu_compton, mu_photoelectric, points_per_decade);
+    }
+
+    // Go back to the constant coefficients of add_layer for this material
+    void clearCrossSections(const std::string& material_name) {
+        cross_sections_.erase(material_name);
+    }
+
+    bool hasCrossSections(const std::string& material_name) const {
+        return cross_sections_.count(material_name) > 0;
+    }
+
+    // Emit secondary photons when a photon is absorbed in this material
+    // (annihilation photons after pair production, fluorescence X-rays)
+    void setSecondaryPhysics(const std::string& material_name,
+                             double pair_mu_cm,
+                             double fluorescence_yield,
+                             double fluorescence_energy_MeV) {
+        if (pair_mu_cm < 0) {
+            throw std::invalid_argument("pair_mu must be non-negative");
+        }
+        if (!(fluorescence_yield >= 0.0 && fluorescence_yield <= 1.0)) {
+            throw std::invalid_argument("fluorescence_yield must be in [0, 1]");
+        }
+        if (fluorescence_yield > 0 && !(fluorescence_energy_MeV > 0)) {
+            throw std::invalid_argument("fluorescence_energy_MeV must be positive");
+        }
+        secondaries_[material_name] = {pair_mu_cm, fluorescence_yield, fluorescence_energy_MeV};
+    }
+
+    // Go back to local deposition of the absorbed energy for this material
+    void clearSecondaryPhysics(const std::string& material_name) {
+        secondaries_.erase(material_name);
+    }
+
+    bool hasSecondaryPhysics(const std::string& material_name) const {
+        return secondaries_.count(material_name) > 0;
+    }
+
     // Run the simulation
     MonteCarloResult run(double source_energy_MeV,
                         int num_photons,
-                        double source_area_cm2 = 1.0) {
-        transport_.setShieldLayers(layers_);
-        return transport_.simulate(source_energy_MeV, num_photons, source_area_cm2);
+                        double source_area_cm2 = 1.0,
+                        int num_threads = 1,
+                        TransportEngine engine = TransportEngine::Scalar,
+                        const VarianceReduction& variance_reduction = VarianceReduction(),
+                        const MeshTallies& mesh_tallies = MeshTallies()) {
+        transport_.setShieldLayers(resolvedLayers());
+        transport_.setVarianceReduction(variance_reduction);
+        transport_.setMeshTallies(mesh_tallies);
+        return transport_.simulate(source_energy_MeV, num_photons, source_area_cm2,
+                                   num_threads, engine);
+    }
+
+    // Run until the stopping criteria are met
+    MonteCarloResult runUntil(double source_energy_MeV,
+                              const StoppingCriteria& stopping,
+                              int num_threads = 1,
+                              TransportEngine engine = TransportEngine::Scalar,
+                              const VarianceReduction& variance_reduction = VarianceReduction(),
+                              const MeshTallies& mesh_tallies = MeshTallies()) {
+        transport_.setShieldLayers(resolvedLayers());
+        transport_.setVarianceReduction(variance_reduction);
+        transport_.setMeshTallies(mesh_tallies);
+        return transport_.simulateUntil(source_energy_MeV, stopping, num_threads, engine);
+    }
+
+    // Start run on a background thread and return its handle; the result is
+    // the one run would give at this point of the simulator stream.
+    // Configuration errors are thrown here, before the thread starts.
+    std::unique_ptr<AsyncRun> startRun(double source_energy_MeV,
+                                       int num_photons,
+                                       int num_threads = 1,
+                                       TransportEngine engine = TransportEngine::Scalar,
+                                       const VarianceReduction& variance_reduction = VarianceReduction(),
+                                       const MeshTallies& mesh_tallies = MeshTallies()) {
+        if (num_photons <= 0) {
+            throw std::invalid_argument("num_photons must be positive");
+        }
+        transport_.setShieldLayers(resolvedLayers());
+        transport_.setVarianceReduction(variance_reduction);
+        transport_.setMeshTallies(mesh_tallies);
+        transport_.prepare(source_energy_MeV, engine);
+        const uint64_t run_key = transport_.nextRunKey();
+        return std::make_unique<AsyncRun>(transport_, run_key, source_energy_MeV, num_photons,
+                                          num_threads, engine);
+    }
+
+    // Tally of histories [first_history, first_history + num_photons) of the
+    // first run of a simulator with this seed, without advancing the
+    // simulator stream: run(N) gives summarize(runTally(0, N)), and
+    // runTally(N, M) extends it by M histories (see core/result_cache.py)
+    TransportTally runTally(double source_energy_MeV,
+                            uint64_t first_history,
+                            int num_photons,
+                            int num_threads = 1,
+                            TransportEngine engine = TransportEngine::Scalar,
+                            const VarianceReduction& variance_reduction = VarianceReduction(),
+                            const MeshTallies& mesh_tallies = MeshTallies()) {
+        transport_.setShieldLayers(resolvedLayers());
+        transport_.setVarianceReduction(variance_reduction);
+        transport_.setMeshTallies(mesh_tallies);
+        transport_.prepare(source_energy_MeV, engine);
+        return transport_.runHistories(PhotonTransport::firstRunKey(seed_), first_history,
+                                       source_energy_MeV, num_photons, num_threads, engine);
+    }
+
+    // Result of a tally of num_photons histories through the current layers
+    MonteCarloResult summarize(const TransportTally& tally,
+                               long long num_photons,
+                               double source_energy_MeV,
+                               double elapsed_seconds = 0.0) {
+        transport_.setShieldLayers(resolvedLayers());
+        return transport_.summarize(tally, num_photons, source_energy_MeV, elapsed_seconds);
+    }
+
+    // Run histories [first_history, first_history + num_photons) of the
+    // first run of this seed (as runTally), saving the tally to
+    // checkpoint_path every checkpoint_photons histories. If checkpoint_path
+    // already holds a checkpoint of this configuration and range, the run
+    // resumes after its last saved history; a finished checkpoint is read
+    // back without running anything. Separate processes can run disjoint
+    // ranges and combine them with mergeCheckpoints.
+    MonteCarloResult runCheckpointed(double source_energy_MeV,
+                                     const std::string& checkpoint_path,
+                                     long long num_photons,
+                                     long long checkpoint_photons = 10000000,
+                                     uint64_t first_history = 0,
+                                     int num_threads = 1,
+                                     TransportEngine engine = TransportEngine::Scalar,
+                                     const VarianceReduction& variance_reduction = VarianceReduction(),
+                                     const MeshTallies& mesh_tallies = MeshTallies()) {
+        if (num_photons < 0 || checkpoint_photons <= 0) {
+            throw std::invalid_argument("num_photons must be non-negative and checkpoint_photons positive");
+        }
+        transport_.setShieldLayers(resolvedLayers());
+        transport_.setVarianceReduction(variance_reduction);
+        transport_.setMeshTallies(mesh_tallies);
+        transport_.prepare(source_energy_MeV, engine);
+
+        Checkpoint checkpoint;
+        checkpoint.config_hash = transport_.configurationHash(source_energy_MeV, engine);
+        checkpoint.run_key = PhotonTransport::firstRunKey(seed_);
+        checkpoint.first_history = first_history;
+        checkpoint.next_history = first_history;
+        checkpoint.end_history = first_history + static_cast<uint64_t>(num_photons);
+        checkpoint.source_energy_MeV = source_energy_MeV;
+        checkpoint.tally = transport_.newTally(source_energy_MeV);
+        if (std::ifstream(checkpoint_path).good()) {
+            Checkpoint saved = loadCheckpoint(checkpoint_path);
+            if (saved.config_hash != checkpoint.config_hash || saved.run_key != checkpoint.run_key ||
+                saved.first_history != checkpoint.first_history ||
+                saved.end_history != checkpoint.end_history) {
+                throw std::invalid_argument("Checkpoint " + checkpoint_path +
+                                            " belongs to another configuration or history range");
+            }
+            checkpoint = std::move(saved);
+        }
+
+        // Segments stay within the int histories of runHistories
+        const long long segment = std::min<long long>(checkpoint_photons, INT_MAX);
+        while (!checkpoint.complete()) {
+            const int n = static_cast<int>(std::min<long long>(
+                segment, static_cast<long long>(checkpoint.end_history - checkpoint.next_history)));
+            const auto start_time = std::chrono::steady_clock::now();
+            checkpoint.tally.merge(transport_.runHistories(checkpoint.run_key, checkpoint.next_history,
+                                                           source_energy_MeV, n, num_threads, engine));
+            checkpoint.elapsed_seconds +=
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            checkpoint.next_history += n;
+            saveCheckpoint(checkpoint_path, checkpoint);
+        }
+        return transport_.summarize(checkpoint.tally, checkpoint.histories(), source_energy_MeV,
+                                    checkpoint.elapsed_seconds);
+    }
+
+    // One result from the checkpoints of disjoint ranges of the same run
+    // (e.g. one per cluster node), summarized with the current layers
+    MonteCarloResult mergeCheckpoints(const std::vector<std::string>& checkpoint_paths) {
+        std::vector<Checkpoint> parts;
+        parts.reserve(checkpoint_paths.size());
+        for (const auto& path : checkpoint_paths) {
+            parts.push_back(loadCheckpoint(path));
+        }
+        MergedCheckpoints merged = shield_lite::mergeCheckpoints(std::move(parts));
+        transport_.setShieldLayers(resolvedLayers());
+        return transport_.summarize(merged.tally, merged.num_photons, merged.source_energy_MeV,
+                                    merged.elapsed_seconds);
+    }
+
+    // Run many packed configurations at once (see simulateBatch). materials
+    // are prototypes indexed by material id; registered cross-section tables
+    // and secondary physics are attached by name. The added layers are not used.
+    void runBatch(std::vector<MaterialLayer> materials,
+                  const ShieldBatch& batch,
+                  BatchResult* results,
+                  int num_threads = 0,
+                  TransportEngine engine = TransportEngine::Scalar,
+                  const VarianceReduction& variance_reduction = VarianceReduction()) const {
+        attachMaterialData(materials);
+        simulateBatch(materials, batch, seed_, results, num_threads, engine, variance_reduction,
+                      transport_.randomGenerator());
     }
 
     // Get number of layers
@@ -40,7 +281,30 @@ public:
 
 private:
     PhotonTransport transport_;
+    unsigned int seed_;
     std::vector<MaterialLayer> layers_;
+    std::map<std::string, std::shared_ptr<const CrossSectionTable>> cross_sections_;
+    std::map<std::string, SecondaryPhysics> secondaries_;
+
+    void attachMaterialData(std::vector<MaterialLayer>& layers) const {
+        for (auto& layer : layers) {
+            auto it = cross_sections_.find(layer.name);
+            if (it != cross_sections_.end()) {
+                layer.cross_sections = it->second;
+            }
+            auto secondary = secondaries_.find(layer.name);
+            if (secondary != secondaries_.end()) {
+                layer.secondaries = secondary->second;
+            }
+        }
+    }
+
+    // Layers with the registered cross-section tables and secondary physics attached
+    std::vector<MaterialLayer> resolvedLayers() const {
+        std::vector<MaterialLayer> layers = layers_;
+        attachMaterialData(layers);
+        return layers;
+    }
 };
 
 } // namespace shield_lite
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace shield_lite {
+
+// Fixed-capacity LIFO of particles waiting to be transported. The storage
+// is allocated once when the bank is built, so pushing and popping never
+// touch the heap and the footprint is capacity * sizeof(Particle). push
+// refuses a particle when the bank is full; the caller decides what to do
+// with it (see PhotonTransport::emitSecondary).
+template <typename Particle>
+class ParticleBank {
+    static_assert(std::is_trivially_copyable<Particle>::value &&
+                  std::is_trivially_destructible<Particle>::value,
+                  "ParticleBank stores particles as raw bytes");
+
+public:
+    explicit ParticleBank(std::size_t capacity)
+        : storage_(new Slot[capacity]), capacity_(capacity), size_(0) {}
+
+    ParticleBank(const ParticleBank&) = delete;
+    ParticleBank& operator=(const ParticleBank&) = delete;
+
+    bool push(const Particle& particle) {
+        if (size_ == capacity_) {
+            return false;
+        }
+        new (&storage_[size_++]) Particle(particle);
+        return true;
+    }
+
+    // Last particle pushed (the bank must not be empty)
+    Particle pop() {
+        return *std::launder(reinterpret_cast<Particle*>(&storage_[--size_]));
+    }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot {
+        alignas(Particle) unsigned char bytes[sizeof(Particle)];
+    };
+
+    std::unique_ptr<Slot[]> storage_;
+    std::size_t capacity_;
+    std::size_t size_;
+};
+
+} // namespace shield_lite
@@ -1,130 +1,356 @@
 #include "photon_transport.h"
+#include "scheduler.h"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 #include <stdexcept>
+#ifdef SHIELD_LITE_CUDA
+#include "gpu_transport.h"
+#endif
 
 namespace shield_lite {
 
-constexpr double ELECTRON_REST_MASS_MEV = 0.511; // MeV
 constexpr double PI = 3.14159265358979323846;
+constexpr double MAX_AUTO_STRETCH = 0.9;         // Upper bound for auto_stretch
+
+namespace {
+
+// Uniform direction on the unit sphere
+template <typename Rng>
+void isotropicDirection(Rng& rng, double* direction) {
+    const double cos_theta = 2.0 * uniform(rng) - 1.0;
+    const double phi = 2.0 * PI * uniform(rng);
+    const double sin_theta = std::sqrt(std::max(0.0, 1.0 - cos_theta * cos_theta));
+    direction[0] = sin_theta * std::cos(phi);
+    direction[1] = sin_theta * std::sin(phi);
+    direction[2] = cos_theta;
+}
+
+} // namespace
 
 PhotonTransport::PhotonTransport(unsigned int seed)
-    : rng_(seed), uniform_dist_(0.0, 1.0) {}
+    : layer_bounds_(1, 0.0), total_thickness_(0.0),
+      random_generator_(RandomGenerator::MT19937),
+      klein_nishina_(&KleinNishinaTable::instance()), rng_(seed) {}
 
 void PhotonTransport::setShieldLayers(const std::vector<MaterialLayer>& layers) {
     layers_ = layers;
-}
 
-double PhotonTransport::getTotalThickness() const {
-    double total = 0.0;
+    // Build the boundary table and the packed records once so the transport
+    // loops never touch layers_
+    layer_bounds_.assign(1, 0.0);
+    layer_bounds_.reserve(layers_.size() + 1);
+    records_.clear();
+    records_.reserve(layers_.size());
+    double accumulated_z = 0.0;
     for (const auto& layer : layers_) {
-        total += layer.thickness_cm;
+        records_.push_back({accumulated_z, accumulated_z + layer.thickness_cm, 0.0, layer.mu_total_cm,
+                            layer.mu_compton_cm, layer.mu_photoelectric_cm, layer.cross_sections.get()});
+        accumulated_z += layer.thickness_cm;
+        layer_bounds_.push_back(accumulated_z);
+    }
+    total_thickness_ = accumulated_z;
+
+    // Left empty when no layer emits secondaries: absorption stays a plain deposit
+    layer_secondaries_.clear();
+    for (const auto& layer : layers_) {
+        if (layer.secondaries.enabled()) {
+            for (const auto& l : layers_) {
+                layer_secondaries_.push_back(l.secondaries);
+            }
+            break;
+        }
     }
-    return total;
+}
+
+void PhotonTransport::setVarianceReduction(const VarianceReduction& variance_reduction) {
+    const VarianceReduction& vr = variance_reduction;
+    if (vr.roulette_weight < 0 || vr.split_weight < 0) {
+        throw std::invalid_argument("Weight thresholds must be non-negative");
+    }
+    if (vr.roulette_weight > 0 && vr.survival_weight <= vr.roulette_weight) {
+        throw std::invalid_argument("survival_weight must be greater than roulette_weight");
+    }
+    if (vr.split_weight > 0) {
+        if (vr.max_split < 2) {
+            throw std::invalid_argument("max_split must be at least 2 when splitting is enabled");
+        }
+        if (vr.split_weight < 2.0 * vr.roulette_weight) {
+            throw std::invalid_argument("split_weight must be at least twice roulette_weight");
+        }
+    }
+    for (double p : vr.stretch) {
+        if (!(p >= 0.0 && p < 1.0)) {
+            throw std::invalid_argument("Exponential transform parameters must be in [0, 1)");
+        }
+    }
+    if (vr.auto_stretch && !vr.stretch.empty()) {
+        throw std::invalid_argument("Give either stretch or auto_stretch, not both");
+    }
+    variance_reduction_ = vr;
+}
+
+void PhotonTransport::setMeshTallies(const MeshTallies& mesh_tallies) {
+    if (mesh_tallies.depth_bins < 0 || mesh_tallies.spectrum_bins < 0) {
+        throw std::invalid_argument("Mesh tally bin counts must be non-negative");
+    }
+    mesh_tallies_ = mesh_tallies;
+}
+
+void PhotonTransport::resolveStretch(double source_energy_MeV) {
+    const VarianceReduction& vr = variance_reduction_;
+    layer_stretch_.assign(layers_.size(), 0.0);
+
+    if (vr.auto_stretch) {
+        // p = 1 - 1 / (mu t) makes the stretched forward mean free path equal
+        // to the layer thickness; optically thin layers are left analog
+        for (size_t i = 0; i < layers_.size(); ++i) {
+            double optical_thickness =
+                layers_[i].attenuation(source_energy_MeV).mu_total_cm * layers_[i].thickness_cm;
+            if (optical_thickness > 1.0) {
+                layer_stretch_[i] = std::min(MAX_AUTO_STRETCH, 1.0 - 1.0 / optical_thickness);
+            }
+        }
+    } else if (!vr.stretch.empty()) {
+        if (vr.stretch.size() != layers_.size()) {
+            throw std::invalid_argument("stretch must have one parameter per layer");
+        }
+        layer_stretch_ = vr.stretch;
+    }
+    for (size_t i = 0; i < records_.size(); ++i) {
+        records_[i].stretch = layer_stretch_[i];
+    }
+}
+
+double PhotonTransport::getTotalThickness() const {
+    return total_thickness_;
 }
 
 int PhotonTransport::findLayer(double z_position) const {
-    double accumulated_z = 0.0;
-    for (size_t i = 0; i < layers_.size(); ++i) {
-        accumulated_z += layers_[i].thickness_cm;
-        if (z_position < accumulated_z) {
-            return static_cast<int>(i);
+    // First boundary strictly above z gives the layer end
+    auto it = std::upper_bound(layer_bounds_.begin() + 1, layer_bounds_.end(), z_position);
+    if (it == layer_bounds_.end()) {
+        return -1; // Beyond shield
+    }
+    return static_cast<int>(it - (layer_bounds_.begin() + 1));
+}
+
+template <typename Rng>
+void PhotonTransport::absorb(Rng& rng, const Photon& photon, double fraction, int layer_idx,
+                             const Attenuation& att, ParticleBank<Photon>& secondaries,
+                             TransportTally& tally) const {
+    double deposited = photon.energy_MeV;
+    if (!layer_secondaries_.empty() && fraction > 0) {
+        const SecondaryPhysics& physics = layer_secondaries_[layer_idx];
+        const double weight = photon.weight * fraction;
+        const double mu_absorption = att.mu_total_cm - att.mu_compton_cm;
+        double direction[3];
+        if (physics.pair_mu_cm > 0 && photon.energy_MeV > 2.0 * ELECTRON_REST_MASS_MEV &&
+            uniform(rng) * mu_absorption < physics.pair_mu_cm) {
+            // Pair production: the pair's kinetic energy deposits locally and
+            // the positron annihilates at rest into two back-to-back 511 keV photons
+            isotropicDirection(rng, direction);
+            double opposite[3] = {-direction[0], -direction[1], -direction[2]};
+            deposited -= 2.0 * ELECTRON_REST_MASS_MEV;
+            deposited += emitSecondary(photon, ELECTRON_REST_MASS_MEV, weight, direction, secondaries, tally);
+            deposited += emitSecondary(photon, ELECTRON_REST_MASS_MEV, weight, opposite, secondaries, tally);
+        } else if (physics.fluorescence_yield > 0 && photon.energy_MeV > physics.fluorescence_energy_MeV &&
+                   uniform(rng) < physics.fluorescence_yield) {
+            // Photoelectric absorption followed by an isotropic fluorescence photon
+            isotropicDirection(rng, direction);
+            deposited -= physics.fluorescence_energy_MeV;
+            deposited += emitSecondary(photon, physics.fluorescence_energy_MeV, weight, direction,
+                                       secondaries, tally);
         }
     }
-    return -1; // Beyond shield
+    tally.deposit(photon.z, deposited * photon.weight * fraction);
+}
+
+double PhotonTransport::emitSecondary(const Photon& parent, double energy_MeV, double weight,
+                                      const double* direction, ParticleBank<Photon>& secondaries,
+                                      TransportTally& tally) const {
+    Photon secondary(energy_MeV, weight);
+    secondary.x = parent.x;
+    secondary.y = parent.y;
+    secondary.z = parent.z;
+    secondary.dx = direction[0];
+    secondary.dy = direction[1];
+    secondary.dz = direction[2];
+    secondary.secondary = true;
+    if (secondaries.push(secondary)) {
+        count(tally.stats.secondaries);
+        return 0.0;
+    }
+    // Bank full: the secondary deposits where it was born
+    count(tally.stats.bank_overflows);
+    return energy_MeV;
 }
 
-double PhotonTransport::sampleFreePath(double mu_total) {
+template <typename Rng>
+double PhotonTransport::sampleFreePath(Rng& rng, double mu_total) const {
     // Sample exponential distribution: -ln(xi) / mu
-    double xi = uniform_dist_(rng_);
+    double xi = uniform(rng);
     return -std::log(xi) / mu_total;
 }
 
-bool PhotonTransport::isComptonScattering(double mu_compton, double mu_total) {
+template <typename Rng>
+bool PhotonTransport::isComptonScattering(Rng& rng, double mu_compton, double mu_total) const {
     double prob_compton = mu_compton / mu_total;
-    return uniform_dist_(rng_) < prob_compton;
+    return uniform(rng) < prob_compton;
 }
 
-void PhotonTransport::comptonScatter(Photon& photon) {
-    // Klein-Nishina formula - simplified version
-    // Sample scattering angle (isotropic approximation for simplicity)
-    double cos_theta = 2.0 * uniform_dist_(rng_) - 1.0;
-    double phi = 2.0 * PI * uniform_dist_(rng_);
-
-    // Energy after Compton scattering
+template <typename Rng>
+void PhotonTransport::comptonScatter(Rng& rng, Photon& photon) const {
+    // Klein-Nishina polar angle: rejection-free table in its energy range,
+    // Kahn's rejection method outside
     double alpha = photon.energy_MeV / ELECTRON_REST_MASS_MEV;
-    double energy_ratio = 1.0 / (1.0 + alpha * (1.0 - cos_theta));
-
-    // Update photon energy
-    double new_energy = photon.energy_MeV * energy_ratio;
-
-    // Deposit energy to material
-    // (In a full simulation, this would be tracked as dose)
-
-    photon.energy_MeV = new_energy;
+    ComptonSample sample = klein_nishina_->covers(photon.energy_MeV)
+        ? klein_nishina_->sample(photon.energy_MeV, uniform(rng))
+        : sampleKahn(alpha, [&rng]() { return uniform(rng); });
+    double cos_theta = sample.cos_theta;
+    double phi = 2.0 * PI * uniform(rng);
+
+    // Update photon energy (the caller deposits the recoil electron's share)
+    photon.energy_MeV *= sample.energy_ratio;
+
+    // Rotate the direction by (theta, phi) relative to the incoming one
+    double sin_theta = std::sqrt(std::max(0.0, 1.0 - cos_theta * cos_theta));
+    double cos_phi = std::cos(phi);
+    double sin_phi = std::sin(phi);
+    double u = photon.dx, v = photon.dy, w = photon.dz;
+    if (std::abs(w) > 0.99999) {
+        // Nearly along z: the rotation about z is arbitrary
+        photon.dx = sin_theta * cos_phi;
+        photon.dy = sin_theta * sin_phi;
+        photon.dz = (w > 0 ? cos_theta : -cos_theta);
+    } else {
+        double t = std::sqrt(1.0 - w * w);
+        photon.dx = sin_theta * (u * w * cos_phi - v * sin_phi) / t + u * cos_theta;
+        photon.dy = sin_theta * (v * w * cos_phi + u * sin_phi) / t + v * cos_theta;
+        photon.dz = w * cos_theta - sin_theta * cos_phi * t;
+    }
+}
 
-    // Update direction (simplified - assume isotropic scattering)
-    double sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
-    photon.dx = sin_theta * std::cos(phi);
-    photon.dy = sin_theta * std::sin(phi);
-    photon.dz = cos_theta;
+template <typename Rng>
+bool PhotonTransport::applyWeightWindow(Rng& rng, Photon& photon,
+                                        std::vector<Photon>& bank) const {
+    const VarianceReduction& vr = variance_reduction_;
 
-    // Adjust weight for scattering probability (optional - simplified here)
-    photon.weight *= 0.95; // Approximate scattering efficiency
+    if (photon.weight < vr.roulette_weight) {
+        // Survive with probability w / w_s at weight w_s (unbiased on average)
+        if (uniform(rng) * vr.survival_weight < photon.weight) {
+            photon.weight = vr.survival_weight;
+        } else {
+            photon.alive = false;
+            return false;
+        }
+    } else if (vr.split_weight > 0 && photon.weight > vr.split_weight) {
+        // Split into n fragments of weight w / n <= split_weight
+        int n = std::min(vr.max_split, static_cast<int>(std::ceil(photon.weight / vr.split_weight)));
+        photon.weight /= n;
+        for (int i = 1; i < n; ++i) {
+            bank.push_back(photon);
+        }
+    }
+    return true;
 }
 
-void PhotonTransport::transportPhoton(Photon& photon, double& dose_deposited, bool& transmitted) {
+template <typename Rng>
+void PhotonTransport::transportPhoton(Rng& rng, Photon& photon, bool& transmitted,
+                                      std::vector<Photon>& bank, ParticleBank<Photon>& secondaries,
+                                      TransportTally& tally) const {
     transmitted = false;
-    dose_deposited = 0.0;
 
-    double total_thickness = getTotalThickness();
+    const double total_thickness = total_thickness_;
+    const LayerRecord* layers = records_.data();
+    const int num_layers = static_cast<int>(records_.size());
+
+    // Current layer is tracked across steps (collisions never leave the layer)
+    int layer_idx = findLayer(photon.z);
 
     // Transport loop
     while (photon.alive && photon.z < total_thickness && photon.energy_MeV > 0.01) {
-        // Find current layer
-        int layer_idx = findLayer(photon.z);
-
         if (layer_idx < 0) {
             // Photon exited the shield
             transmitted = true;
             break;
         }
 
-        const MaterialLayer& current_layer = layers_[layer_idx];
-
-        // Sample free path
-        double free_path = sampleFreePath(current_layer.mu_total_cm);
-
-        // Calculate distance to layer boundary
-        double layer_start_z = 0.0;
-        for (int i = 0; i < layer_idx; ++i) {
-            layer_start_z += layers_[i].thickness_cm;
+        // Coefficients at the current energy (changes at each Compton scatter)
+        const LayerRecord& layer = layers[layer_idx];
+        const Attenuation att = layer.attenuation(photon.energy_MeV);
+
+        // Sample free path (stretched along +z by the exponential transform)
+        count(tally.stats.flights);
+        const double mu = att.mu_total_cm;
+        const double stretch = layer.stretch;
+        const double sigma = (stretch > 0) ? mu * (1.0 - stretch * photon.dz) : mu;
+        double free_path = sampleFreePath(rng, sigma);
+
+        // Calculate distance to the layer boundary ahead of the photon
+        const bool backward = photon.dz < 0;
+        double boundary_z = backward ? layer.start_z : layer.end_z;
+        double distance_to_boundary = (boundary_z - photon.z) / std::abs(photon.dz);
+        bool collision = free_path < distance_to_boundary;
+
+        if (stretch > 0) {
+            // Weight correction: ratio of the analog to the sampled path density
+            // (collision) or survival probability (boundary crossing)
+            double path = collision ? free_path : distance_to_boundary;
+            photon.weight *= std::exp((sigma - mu) * path) * (collision ? mu / sigma : 1.0);
         }
-        double layer_end_z = layer_start_z + current_layer.thickness_cm;
-        double distance_to_boundary = (layer_end_z - photon.z) / std::abs(photon.dz);
 
         // Move photon
-        if (free_path < distance_to_boundary) {
+        if (collision) {
             // Interaction occurs within the layer
             photon.z += free_path * photon.dz;
+            ++tally.collisions;
+            countCollision(tally.stats, photon.energy_MeV);
 
             // Determine interaction type
-            if (isComptonScattering(current_layer.mu_compton_cm, current_layer.mu_total_cm)) {
-                // Compton scattering
-                comptonScatter(photon);
-            } else {
+            if (variance_reduction_.implicit_capture) {
+                // Implicit capture: deposit the absorbed fraction, always scatter
+                double p_scatter = att.mu_compton_cm / att.mu_total_cm;
+                absorb(rng, photon, 1.0 - p_scatter, layer_idx, att, secondaries, tally);
+                photon.weight *= p_scatter;
+            } else if (!isComptonScattering(rng, att.mu_compton_cm, att.mu_total_cm)) {
                 // Photoelectric absorption - photon dies
-                dose_deposited += photon.energy_MeV * photon.weight;
+                count(tally.stats.photoelectric);
+                absorb(rng, photon, 1.0, layer_idx, att, secondaries, tally);
+                photon.alive = false;
+                break;
+            }
+            count(tally.stats.compton);
+
+            // Compton scattering: the recoil electron deposits locally
+            const double incident_energy = photon.energy_MeV;
+            comptonScatter(rng, photon);
+            tally.deposit(photon.z, (incident_energy - photon.energy_MeV) * photon.weight);
+
+            if (photon.energy_MeV >= 0.01 && !applyWeightWindow(rng, photon, bank)) {
+                count(tally.stats.roulette_kills);
+                break;
+            }
+        } else if (backward) {
+            // Move to the boundary and step into the previous layer
+            count(tally.stats.boundary_crossings);
+            photon.z = boundary_z;
+            if (--layer_idx < 0) {
+                // Backscattered out of the source face
+                count(tally.stats.backscatter_escapes);
                 photon.alive = false;
                 break;
             }
         } else {
-            // Move to boundary
-            photon.z += distance_to_boundary * std::abs(photon.dz);
+            // Move to the boundary and step into the next layer
+            count(tally.stats.boundary_crossings);
+            photon.z = boundary_z;
+            layer_idx = (layer_idx + 1 < num_layers) ? layer_idx + 1 : -1;
         }
 
         // Check if photon has very low energy
         if (photon.energy_MeV < 0.01) {
+            count(tally.stats.cutoff_kills);
             photon.alive = false;
         }
     }
@@ -135,57 +361,363 @@ void PhotonTransport::transportPhoton(Photon& photon, double& dose_deposited, bo
     }
 }
 
-MonteCarloResult PhotonTransport::simulate(double source_energy_MeV,
-                                          int num_photons,
-                                          double source_area_cm2) {
+template <typename Rng>
+void PhotonTransport::runPhotons(Rng& rng, uint64_t first_history, double source_energy_MeV,
+                                 int num_photons, TransportTally& tally) const {
+    std::vector<Photon> bank;
+    // Allocated once per worker thread; empty again at the end of each history
+    thread_local ParticleBank<Photon> secondaries(kSecondaryBankCapacity);
+    for (int i = 0; i < num_photons; ++i) {
+        // A history is the source photon plus any fragments split from it,
+        // then the secondary photons they emitted
+        startHistory(rng, first_history + i);
+        double history_weight = 0.0;
+        double history_dose = 0.0;
+        bank.emplace_back(source_energy_MeV);
+
+        while (!bank.empty() || !secondaries.empty()) {
+            const bool from_bank = !bank.empty();
+            Photon photon = from_bank ? bank.back() : secondaries.pop();
+            if (from_bank) {
+                bank.pop_back();
+            }
+            bool transmitted = false;
+
+            {
+                PhaseTimer timer(tally.stats, TransportPhase::Flight);
+                transportPhoton(rng, photon, transmitted, bank, secondaries, tally);
+            }
+
+            if (transmitted && photon.secondary) {
+                tally.scoreSecondary(photon.energy_MeV, photon.weight);
+            } else if (transmitted) {
+                tally.scoreTransmitted(photon.energy_MeV, photon.weight);
+                history_weight += photon.weight;
+                history_dose += photon.energy_MeV * photon.weight;
+            }
+        }
+
+        tally.scoreHistory(history_weight, history_dose);
+    }
+}
+
+template <typename Rng>
+void PhotonTransport::runChunkWith(uint64_t stream_key, uint64_t first_history, double source_energy_MeV,
+                                   int num_photons, TransportEngine engine, TransportTally& tally) const {
+    Rng rng = makeChunkGenerator<Rng>(stream_key, first_history);
+    if (engine == TransportEngine::Batched) {
+        runPhotonsBatched(rng, first_history, source_energy_MeV, num_photons, tally);
+    } else {
+        runPhotons(rng, first_history, source_energy_MeV, num_photons, tally);
+    }
+}
+
+void PhotonTransport::runChunk(uint64_t stream_key, uint64_t first_history, double source_energy_MeV,
+                               int num_photons, TransportEngine engine, TransportTally& tally) const {
+#ifdef SHIELD_LITE_CUDA
+    if (engine == TransportEngine::Gpu) {
+        tally.merge(runHistoriesGpu(records_, total_thickness_, variance_reduction_, mesh_tallies_,
+                                    stream_key, first_history, source_energy_MeV, num_photons));
+        return;
+    }
+#endif
+    if (random_generator_ == RandomGenerator::Philox) {
+        runChunkWith<Philox4x32>(stream_key, first_history, source_energy_MeV, num_photons, engine, tally);
+    } else {
+        runChunkWith<std::mt19937>(stream_key, first_history, source_energy_MeV, num_photons, engine, tally);
+    }
+}
+
+void PhotonTransport::prepare(double source_energy_MeV, TransportEngine engine) {
     if (layers_.empty()) {
         throw std::runtime_error("No shield layers defined");
     }
 
-    MonteCarloResult result;
-    result.total_photons = num_photons;
+    if (engine != TransportEngine::Scalar && variance_reduction_.split_weight > 0) {
+        throw std::invalid_argument("Particle splitting is only supported by the scalar engine");
+    }
+    if (engine != TransportEngine::Scalar && !layer_secondaries_.empty()) {
+        throw std::invalid_argument("Secondary particles are only supported by the scalar engine");
+    }
+    if (engine == TransportEngine::Gpu) {
+        if (!gpuAvailable()) {
+            throw std::invalid_argument("The GPU engine needs a build with SHIELD_LITE_CUDA and a CUDA device");
+        }
+        if (random_generator_ != RandomGenerator::Philox) {
+            throw std::invalid_argument("The GPU engine requires the Philox generator");
+        }
+    }
 
-    double total_dose_transmitted = 0.0;
-    double total_dose_absorbed = 0.0;
-    std::vector<double> transmitted_doses;
+    resolveStretch(source_energy_MeV);
+}
 
-    // Run Monte Carlo simulation
-    for (int i = 0; i < num_photons; ++i) {
-        Photon photon(source_energy_MeV);
-        double dose_deposited = 0.0;
-        bool transmitted = false;
+TransportTally PhotonTransport::newTally(double source_energy_MeV) const {
+    TransportTally tally;
+    if (mesh_tallies_.depth_bins > 0) {
+        tally.depth_dose = Histogram(mesh_tallies_.depth_bins, 0.0, total_thickness_);
+    }
+    if (mesh_tallies_.spectrum_bins > 0) {
+        tally.spectrum = Histogram(mesh_tallies_.spectrum_bins, 0.0, source_energy_MeV);
+        if (!layer_secondaries_.empty()) {
+            tally.secondary_spectrum = Histogram(mesh_tallies_.spectrum_bins, 0.0, source_energy_MeV);
+        }
+    }
+    return tally;
+}
 
-        transportPhoton(photon, dose_deposited, transmitted);
+namespace {
+
+// Two draws from the simulator stream key a run, so successive runs differ
+// while staying reproducible for a given seed
+uint64_t drawRunKey(std::mt19937& rng) {
+    const uint64_t key_hi = rng();
+    return key_hi << 32 | rng();
+}
 
-        if (transmitted) {
-            result.transmitted_photons++;
-            total_dose_transmitted += photon.energy_MeV * photon.weight;
-            transmitted_doses.push_back(photon.energy_MeV * photon.weight);
+} // namespace
+
+uint64_t PhotonTransport::configurationHash(double source_energy_MeV, TransportEngine engine) const {
+    // FNV-1a over the raw bytes of each field
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* data, std::size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
         }
+    };
+    auto mixValue = [&mix](const auto& value) { mix(&value, sizeof(value)); };
 
-        total_dose_absorbed += dose_deposited;
+    for (const auto& layer : layers_) {
+        mixValue(layer.thickness_cm);
+        mixValue(layer.mu_total_cm);
+        mixValue(layer.mu_compton_cm);
+        mixValue(layer.mu_photoelectric_cm);
+        const bool has_table = static_cast<bool>(layer.cross_sections);
+        mixValue(has_table);
+        if (has_table) {
+            const auto& points = layer.cross_sections->points();
+            mix(points.data(), points.size() * sizeof(Attenuation));
+            mixValue(layer.cross_sections->minEnergy());
+            mixValue(layer.cross_sections->maxEnergy());
+        }
+        // Only when enabled, so the hash of runs without secondaries is unchanged
+        if (layer.secondaries.enabled()) {
+            mixValue(layer.secondaries.pair_mu_cm);
+            mixValue(layer.secondaries.fluorescence_yield);
+            mixValue(layer.secondaries.fluorescence_energy_MeV);
+        }
     }
+    const std::size_t num_layers = layers_.size();
+    mixValue(num_layers);
+    mixValue(variance_reduction_.implicit_capture);
+    mixValue(variance_reduction_.roulette_weight);
+    mixValue(variance_reduction_.survival_weight);
+    mixValue(variance_reduction_.split_weight);
+    mixValue(variance_reduction_.max_split);
+    const std::size_t num_stretch = variance_reduction_.stretch.size();
+    mixValue(num_stretch);
+    mix(variance_reduction_.stretch.data(), num_stretch * sizeof(double));
+    mixValue(variance_reduction_.auto_stretch);
+    mixValue(mesh_tallies_.depth_bins);
+    mixValue(mesh_tallies_.spectrum_bins);
+    mixValue(random_generator_);
+    mixValue(engine);
+    mixValue(source_energy_MeV);
+    return hash;
+}
+
+double RunControl::relativeUncertainty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StreamingTally history_dose = history_dose_;
+    history_dose.merge(StreamingTally::constant(0.0, histories_done_ - history_dose.count()));
+    return history_dose.mean() > 0 ? history_dose.standardError() / history_dose.mean() : 0.0;
+}
+
+void RunControl::chunkDone(const TransportTally& chunk, long long histories) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    history_dose_.merge(chunk.history_dose);
+    histories_done_ += histories;
+}
+
+bool PhotonTransport::gpuAvailable() {
+#ifdef SHIELD_LITE_CUDA
+    return gpuDeviceCount() > 0;
+#else
+    return false;
+#endif
+}
+
+uint64_t PhotonTransport::firstRunKey(unsigned int seed) {
+    std::mt19937 rng(seed);
+    return drawRunKey(rng);
+}
+
+uint64_t PhotonTransport::nextRunKey() {
+    return drawRunKey(rng_);
+}
+
+TransportTally PhotonTransport::runParallel(double source_energy_MeV, int num_photons,
+                                            int num_threads, TransportEngine engine) {
+    return runHistories(nextRunKey(), 0, source_energy_MeV, num_photons, num_threads, engine);
+}
+
+TransportTally PhotonTransport::runHistories(uint64_t run_key, uint64_t first_history,
+                                             double source_energy_MeV, int num_photons,
+                                             int num_threads, TransportEngine engine,
+                                             RunControl* control) const {
+#ifdef SHIELD_LITE_CUDA
+    if (engine == TransportEngine::Gpu) {
+        // One device run for the whole range (the device does its own scheduling)
+        return runHistoriesGpu(records_, total_thickness_, variance_reduction_, mesh_tallies_,
+                               run_key, first_history, source_energy_MeV, num_photons, control);
+    }
+#endif
+    const std::size_t num_chunks = (static_cast<std::size_t>(num_photons) + kChunkPhotons - 1) / kChunkPhotons;
+
+    std::vector<TransportTally> tallies(std::max<std::size_t>(1, num_chunks), newTally(source_energy_MeV));
+    std::atomic<bool> skipped(false);
+    runWorkStealing(num_chunks, num_threads, [&](std::size_t chunk, std::size_t) {
+        if (control && control->cancelled()) {
+            skipped = true;
+            return;
+        }
+        int begin = static_cast<int>(chunk) * kChunkPhotons;
+        int count = std::min(kChunkPhotons, num_photons - begin);
+        runChunk(run_key, first_history + begin, source_energy_MeV, count, engine, tallies[chunk]);
+        if (control) {
+            control->chunkDone(tallies[chunk], count);
+        }
+    });
+    if (skipped) {
+        throw RunCancelled();
+    }
+
+    // Reduce chunk tallies (in chunk order for bit-identical results)
+    for (std::size_t c = 1; c < tallies.size(); ++c) {
+        tallies[0].merge(tallies[c]);
+    }
+    return tallies[0];
+}
+
+MonteCarloResult PhotonTransport::summarize(const TransportTally& tally, long long num_photons,
+                                            double source_energy_MeV, double elapsed_seconds) const {
+    MonteCarloResult result;
+    result.total_photons = num_photons;
+    result.transmitted_tally = tally.transmitted;
+    const StreamingTally& transmitted = result.transmitted_tally;
+    result.transmitted_photons = transmitted.count();
+
+    // Histories that transmitted nothing score zero
+    StreamingTally history_weight = tally.history_weight;
+    StreamingTally history_dose = tally.history_dose;
+    const StreamingTally no_score = StreamingTally::constant(0.0, num_photons - history_weight.count());
+    history_weight.merge(no_score);
+    history_dose.merge(no_score);
 
     // Calculate results
-    result.dose_transmitted = total_dose_transmitted / num_photons;
-    result.dose_absorbed = total_dose_absorbed / num_photons;
-    result.transmission_factor = static_cast<double>(result.transmitted_photons) / num_photons;
+    result.dose_transmitted = history_dose.mean();
+    result.dose_absorbed = tally.dose_absorbed / num_photons;
+    result.collisions = tally.collisions;
+    result.stats = tally.stats;
+    result.depth_dose = tally.depth_dose;
+    result.depth_dose.scale(1.0 / num_photons);
+    result.spectrum = tally.spectrum;
+    result.spectrum.scale(1.0 / num_photons);
+    result.transmission_factor = history_weight.mean();
+    result.transmission_uncertainty = history_weight.standardError();
+    result.secondary_transmission = tally.secondary_weight / num_photons;
+    result.secondary_dose_transmitted = tally.secondary_dose / num_photons;
+    result.secondary_spectrum = tally.secondary_spectrum;
+    result.secondary_spectrum.scale(1.0 / num_photons);
 
     // Calculate buildup factor (ratio of total dose to uncollided dose)
-    double uncollided_transmission = std::exp(-getTotalThickness() * layers_[0].mu_total_cm);
+    double optical_thickness = 0.0;
+    for (const auto& layer : layers_) {
+        optical_thickness += layer.attenuation(source_energy_MeV).mu_total_cm * layer.thickness_cm;
+    }
+    double uncollided_transmission = std::exp(-optical_thickness);
     if (uncollided_transmission > 1e-10) {
         result.buildup_factor = result.transmission_factor / uncollided_transmission;
     }
 
-    // Calculate statistical uncertainty (standard error)
-    if (!transmitted_doses.empty()) {
-        double mean = total_dose_transmitted / transmitted_doses.size();
-        double variance = 0.0;
-        for (double dose : transmitted_doses) {
-            variance += (dose - mean) * (dose - mean);
+    // Calculate statistical uncertainty (standard error of the transmitted doses)
+    result.uncertainty = transmitted.standardError();
+    if (history_dose.mean() > 0) {
+        result.relative_uncertainty = history_dose.standardError() / history_dose.mean();
+    }
+
+    // Figure of merit: higher means less time to reach a given uncertainty
+    result.elapsed_seconds = elapsed_seconds;
+    if (result.relative_uncertainty > 0 && result.elapsed_seconds > 0) {
+        result.figure_of_merit = 1.0 / (result.relative_uncertainty * result.relative_uncertainty *
+                                        result.elapsed_seconds);
+    }
+
+    return result;
+}
+
+MonteCarloResult PhotonTransport::simulate(double source_energy_MeV,
+                                          int num_photons,
+                                          double source_area_cm2,
+                                          int num_threads,
+                                          TransportEngine engine) {
+    prepare(source_energy_MeV, engine);
+
+    const auto start_time = std::chrono::steady_clock::now();
+    TransportTally tally = runParallel(source_energy_MeV, num_photons, num_threads, engine);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    return summarize(tally, num_photons, source_energy_MeV, elapsed);
+}
+
+MonteCarloResult PhotonTransport::simulateUntil(double source_energy_MeV,
+                                               const StoppingCriteria& stopping,
+                                               int num_threads,
+                                               TransportEngine engine) {
+    if (stopping.target_relative_uncertainty < 0 || stopping.max_seconds < 0) {
+        throw std::invalid_argument("Stopping targets must be non-negative");
+    }
+    if (stopping.max_photons <= 0 || stopping.batch_photons <= 0) {
+        throw std::invalid_argument("max_photons and batch_photons must be positive");
+    }
+    prepare(source_energy_MeV, engine);
+
+    const auto start_time = std::chrono::steady_clock::now();
+    TransportTally total;
+    MonteCarloResult result;
+    int done = 0;
+    int next_batch = std::min(stopping.batch_photons, stopping.max_photons);
+
+    while (true) {
+        total.merge(runParallel(source_energy_MeV, next_batch, num_threads, engine));
+        done += next_batch;
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        result = summarize(total, done, source_energy_MeV, elapsed);
+
+        const double R = result.relative_uncertainty;
+        if (stopping.target_relative_uncertainty > 0 && R > 0 && R <= stopping.target_relative_uncertainty) {
+            result.converged = true;
+            break;
+        }
+        if (done >= stopping.max_photons ||
+            (stopping.max_seconds > 0 && elapsed >= stopping.max_seconds)) {
+            break;
+        }
+
+        // R falls as 1/sqrt(N): project the histories still needed, growing
+        // at most 2x per batch so a noisy early estimate cannot overshoot
+        double projected = static_cast<double>(done);
+        if (stopping.target_relative_uncertainty > 0 && R > 0) {
+            double ratio = R / stopping.target_relative_uncertainty;
+            projected = done * (ratio * ratio - 1.0);
+        }
+        if (stopping.max_seconds > 0) {
+            projected = std::min(projected, (stopping.max_seconds - elapsed) * done / elapsed);
         }
-        variance /= transmitted_doses.size();
-        result.uncertainty = std::sqrt(variance / transmitted_doses.size());
+        projected = std::min(std::max(projected, static_cast<double>(stopping.batch_photons)),
+                             static_cast<double>(done));
+        next_batch = std::min(static_cast<int>(projected), stopping.max_photons - done);
     }
 
     return result;
@@ -1,10 +1,30 @@
 #pragma once
+#include <atomic>
 #include <vector>
 #include <string>
 #include <random>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include "cross_section.h"
+#include "instrumentation.h"
+#include "klein_nishina.h"
+#include "particle_bank.h"
+#include "random.h"
+#include "tally.h"
 
 namespace shield_lite {
 
+// Secondary photons emitted when a photon is absorbed in a material (all
+// off by default: the absorbed energy deposits locally)
+struct SecondaryPhysics {
+    double pair_mu_cm = 0.0;               // Pair production part of the absorption above 1.022 MeV (cm^-1)
+    double fluorescence_yield = 0.0;       // Probability that a photoelectric absorption emits an X-ray
+    double fluorescence_energy_MeV = 0.0;  // Energy of that X-ray (emitted by photons above it)
+
+    bool enabled() const { return pair_mu_cm > 0 || fluorescence_yield > 0; }
+};
+
 // Material layer structure
 struct MaterialLayer {
     std::string name;
@@ -13,12 +33,41 @@ struct MaterialLayer {
     double mu_compton_cm;          // Compton scattering coefficient (cm^-1)
     double mu_photoelectric_cm;    // Photoelectric absorption coefficient (cm^-1)
     double density_g_cm3;          // Density (g/cm^3)
+    std::shared_ptr<const CrossSectionTable> cross_sections;   // mu(E), shared per material (optional)
+    SecondaryPhysics secondaries;  // Annihilation and fluorescence photons (off by default)
 
     MaterialLayer(const std::string& n, double thick, double mu_tot,
                   double mu_comp, double mu_photo, double dens)
         : name(n), thickness_cm(thick), mu_total_cm(mu_tot),
           mu_compton_cm(mu_comp), mu_photoelectric_cm(mu_photo),
           density_g_cm3(dens) {}
+
+    // Coefficients at the given energy (the constant ones without a table)
+    Attenuation attenuation(double energy_MeV) const {
+        if (cross_sections) {
+            return cross_sections->lookup(energy_MeV);
+        }
+        return {mu_total_cm, mu_compton_cm, mu_photoelectric_cm};
+    }
+};
+
+// Hot transport data of a layer, packed in one cache line: what the
+// transport loops read at every step, without the name and the table
+// ownership kept by MaterialLayer (built by PhotonTransport::setShieldLayers)
+struct alignas(64) LayerRecord {
+    double start_z, end_z;         // The layer spans [start_z, end_z)
+    double stretch;                // Exponential transform parameter (resolved by prepare)
+    double mu_total_cm;
+    double mu_compton_cm;
+    double mu_photoelectric_cm;
+    const CrossSectionTable* cross_sections;   // Owned by the MaterialLayer (nullptr = constant)
+
+    Attenuation attenuation(double energy_MeV) const {
+        if (cross_sections) {
+            return cross_sections->lookup(energy_MeV);
+        }
+        return {mu_total_cm, mu_compton_cm, mu_photoelectric_cm};
+    }
 };
 
 // Photon particle
@@ -28,25 +77,166 @@ struct Photon {
     double dx, dy, dz;            // Direction (normalized)
     double weight;                // Statistical weight
     bool alive;
+    bool secondary;               // Emitted on absorption (SecondaryPhysics), or split from one
 
     Photon(double E, double weight_init = 1.0)
         : energy_MeV(E), x(0), y(0), z(0),
-          dx(0), dy(0), dz(1), weight(weight_init), alive(true) {}
+          dx(0), dy(0), dz(1), weight(weight_init), alive(true), secondary(false) {}
 };
 
 // Result structure
 struct MonteCarloResult {
     double dose_transmitted;       // Dose transmitted through shield
-    double dose_absorbed;          // Dose absorbed in shield
+    double dose_absorbed;          // Dose absorbed in shield (photoelectric and Compton electrons)
     double transmission_factor;    // Fraction of photons transmitted
     double buildup_factor;         // Dose buildup factor
     double uncertainty;            // Statistical uncertainty
-    int total_photons;
-    int transmitted_photons;
+    double relative_uncertainty;   // Relative standard error of dose_transmitted (per history)
+    double transmission_uncertainty;   // Standard error of transmission_factor (per history)
+    double elapsed_seconds;        // Wall-clock time of the simulation
+    double figure_of_merit;        // 1 / (relative_uncertainty^2 * elapsed_seconds)
+    long long total_photons;
+    long long transmitted_photons; // Transmitted particles (may exceed histories with splitting)
+    long long collisions;          // Interactions (absorptions and scatters) over all histories
+    bool converged;                // Target uncertainty reached (simulateUntil)
+    StreamingTally transmitted_tally;  // Doses of the transmitted photons
+    Histogram depth_dose;          // Energy deposited per depth bin (MeV per photon, MeshTallies)
+    Histogram spectrum;            // Transmitted weight per energy bin (per photon, MeshTallies)
+    TransportStats stats;          // Event counters and phase times (zero unless SHIELD_LITE_INSTRUMENT)
+
+    // Secondary photons (SecondaryPhysics) leaving the far face, kept out of
+    // the source photon results above
+    double secondary_transmission;     // Transmitted secondary weight per source photon
+    double secondary_dose_transmitted; // Their transmitted energy per source photon (MeV)
+    Histogram secondary_spectrum;      // Their weight per energy bin (per photon, with spectrum)
 
     MonteCarloResult() : dose_transmitted(0), dose_absorbed(0),
                         transmission_factor(0), buildup_factor(1.0),
-                        uncertainty(0), total_photons(0), transmitted_photons(0) {}
+                        uncertainty(0), relative_uncertainty(0),
+                        transmission_uncertainty(0), elapsed_seconds(0),
+                        figure_of_merit(0), total_photons(0), transmitted_photons(0),
+                        collisions(0), converged(false), secondary_transmission(0),
+                        secondary_dose_transmitted(0) {}
+};
+
+// Stopping rules for PhotonTransport::simulateUntil, checked between batches
+struct StoppingCriteria {
+    double target_relative_uncertainty = 0.01;  // Stop when relative_uncertainty <= target (0 = off)
+    double max_seconds = 0.0;                   // Wall-clock budget (0 = unlimited)
+    int max_photons = 10000000;                 // History budget
+    int batch_photons = 10000;                  // Histories in the first batch (and minimum batch)
+};
+
+// Survival biasing parameters (all off by default: analog transport)
+struct VarianceReduction {
+    bool implicit_capture = false;  // Absorption reduces the weight instead of killing
+    double roulette_weight = 0.0;   // Russian roulette below this weight (0 = off)
+    double survival_weight = 0.5;   // Weight given to roulette survivors
+    double split_weight = 0.0;      // Split photons above this weight (0 = off)
+    int max_split = 10;             // Maximum number of fragments per split
+
+    // Exponential transform: free paths sampled with mu * (1 - p * dz), p in [0, 1)
+    std::vector<double> stretch;    // Parameter p per layer (empty = off)
+    bool auto_stretch = false;      // Choose p from each layer's mu * thickness
+};
+
+// Optional mesh tallies of simulate / simulateUntil (off by default)
+struct MeshTallies {
+    int depth_bins = 0;        // Uniform bins over [0, total thickness] for the deposited energy (0 = off)
+    int spectrum_bins = 0;     // Uniform bins over [0, source energy] for the transmitted photons (0 = off)
+};
+
+// Tallies of a run chunk; chunk tallies are reduced in chunk order so the
+// result does not depend on which thread ran which chunk
+struct TransportTally {
+    StreamingTally transmitted;      // Dose of each transmitted particle
+    StreamingTally history_weight;   // Transmitted weight per history (scoring histories only)
+    StreamingTally history_dose;     // Transmitted dose per history (scoring histories only)
+    double dose_absorbed = 0.0;
+    long long collisions = 0;
+    Histogram depth_dose;            // Deposited energy by depth (disabled unless requested)
+    Histogram spectrum;              // Transmitted weight by energy (disabled unless requested)
+    TransportStats stats;            // Instrumentation (see instrumentation.h)
+    double secondary_weight = 0.0;   // Transmitted weight of secondary photons
+    double secondary_dose = 0.0;     // Transmitted energy of secondary photons
+    Histogram secondary_spectrum;    // Secondary weight by energy (with spectrum and secondaries)
+
+    // Energy deposited at depth z
+    void deposit(double z, double energy) {
+        dose_absorbed += energy;
+        depth_dose.add(z, energy);
+    }
+
+    // Particle leaving the far face
+    void scoreTransmitted(double energy_MeV, double weight) {
+        transmitted.add(energy_MeV * weight);
+        spectrum.add(energy_MeV, weight);
+    }
+
+    // Secondary photon leaving the far face: scored apart from the source
+    // photons so transmission_factor keeps its meaning
+    void scoreSecondary(double energy_MeV, double weight) {
+        secondary_weight += weight;
+        secondary_dose += energy_MeV * weight;
+        secondary_spectrum.add(energy_MeV, weight);
+    }
+
+    void scoreHistory(double weight, double dose) {
+        if (weight > 0) {
+            history_weight.add(weight);
+            history_dose.add(dose);
+        }
+    }
+
+    void merge(const TransportTally& other) {
+        transmitted.merge(other.transmitted);
+        history_weight.merge(other.history_weight);
+        history_dose.merge(other.history_dose);
+        dose_absorbed += other.dose_absorbed;
+        collisions += other.collisions;
+        depth_dose.merge(other.depth_dose);
+        spectrum.merge(other.spectrum);
+        stats.merge(other.stats);
+        secondary_weight += other.secondary_weight;
+        secondary_dose += other.secondary_dose;
+        secondary_spectrum.merge(other.secondary_spectrum);
+    }
+};
+
+// Thrown by a run whose RunControl was cancelled before it finished
+class RunCancelled : public std::runtime_error {
+public:
+    RunCancelled() : std::runtime_error("Run cancelled") {}
+};
+
+// Progress and cooperative cancellation of a run, shared between the
+// transport workers and the caller (see async_run.h): workers report every
+// finished chunk, and stop taking chunks once cancel() is called
+class RunControl {
+public:
+    void cancel() { cancelled_ = true; }
+    bool cancelled() const { return cancelled_; }
+    long long historiesDone() const { return histories_done_; }
+
+    // Relative uncertainty of dose_transmitted over the finished histories
+    // (0 until one of them transmits)
+    double relativeUncertainty() const;
+
+    // Called once per finished chunk of `histories` histories
+    void chunkDone(const TransportTally& chunk, long long histories);
+
+private:
+    std::atomic<bool> cancelled_{false};
+    std::atomic<long long> histories_done_{0};
+    mutable std::mutex mutex_;
+    StreamingTally history_dose_;      // Scoring histories of the finished chunks
+};
+
+// Transport kernel used by PhotonTransport::simulate
+enum class TransportEngine {
+    Scalar,     // One photon at a time (reference implementation)
+    Batched,    // SoA photon batches with a SIMD kernel (see batch_transport.cpp)
+    Gpu         // History-based CUDA kernel, Philox only (see gpu_transport.h)
 };
 
 // Monte Carlo photon transport engine
@@ -57,32 +247,170 @@ public:
     // Set the shield configuration
     void setShieldLayers(const std::vector<MaterialLayer>& layers);
 
+    // Restart the simulator stream from a new seed
+    void reseed(unsigned int seed) { rng_.seed(seed); }
+
+    // Generator used by the transport (the simulator stream itself only
+    // draws the per-run keys and stays an mt19937)
+    void setRandomGenerator(RandomGenerator generator) { random_generator_ = generator; }
+    RandomGenerator randomGenerator() const { return random_generator_; }
+
+    // Set survival biasing (throws std::invalid_argument on inconsistent thresholds)
+    void setVarianceReduction(const VarianceReduction& variance_reduction);
+
+    // Set the mesh tallies (throws std::invalid_argument on negative bin counts)
+    void setMeshTallies(const MeshTallies& mesh_tallies);
+
+    // True if the extension is built with SHIELD_LITE_CUDA and a CUDA device is present
+    static bool gpuAvailable();
+
+    // Histories per chunk: the unit of work handed to the scheduler
+    static constexpr int kChunkPhotons = 8192;
+
+    // Secondary photons a worker can hold at once (ParticleBank capacity);
+    // beyond it a secondary deposits its energy where it was emitted
+    static constexpr std::size_t kSecondaryBankCapacity = 256;
+
     // Run Monte Carlo simulation
+    // The photons are split into chunks of kChunkPhotons, each with its own
+    // stream keyed by a draw from the simulator stream and the chunk's first
+    // history (one stream per history with Philox), and run by num_threads
+    // work-stealing workers (<= 0 uses all hardware threads): results depend
+    // on the seed only, not on the thread count.
     MonteCarloResult simulate(double source_energy_MeV,
                              int num_photons,
-                             double source_area_cm2 = 1.0);
+                             double source_area_cm2 = 1.0,
+                             int num_threads = 1,
+                             TransportEngine engine = TransportEngine::Scalar);
+
+    // Run batches until the target relative uncertainty of dose_transmitted is
+    // reached or a budget is exhausted; total_photons reports the histories used
+    MonteCarloResult simulateUntil(double source_energy_MeV,
+                                   const StoppingCriteria& stopping,
+                                   int num_threads = 1,
+                                   TransportEngine engine = TransportEngine::Scalar);
+
+    // Chunk-level API for external schedulers (see run_batch.cpp): prepare
+    // once per configuration, run chunks with caller-seeded streams, then
+    // summarize the merged tally.
+    // Validate the configuration and resolve per-run layer parameters
+    void prepare(double source_energy_MeV, TransportEngine engine);
+
+    // Run histories [first_history, first_history + num_photons) of the run
+    // keyed by stream_key (see makeChunkGenerator). With Philox a single
+    // history can be replayed by running it as a chunk of one.
+    void runChunk(uint64_t stream_key, uint64_t first_history, double source_energy_MeV,
+                  int num_photons, TransportEngine engine, TransportTally& tally) const;
+
+    // Empty chunk tally with the histograms of the mesh tallies
+    TransportTally newTally(double source_energy_MeV) const;
+
+    // Key of the first run drawn by a simulator stream seeded with seed
+    static uint64_t firstRunKey(unsigned int seed);
+
+    // Draw the key of the next run from the simulator stream, as simulate does
+    uint64_t nextRunKey();
+
+    // Run histories [first_history, first_history + num_photons) of the run
+    // keyed by run_key over num_threads workers, as simulate does (after
+    // prepare). Merging the tallies of consecutive ranges gives the tally of
+    // the whole range, which lets a stored run be extended later.
+    // With a control, progress is reported per chunk and cancel() makes the
+    // run throw RunCancelled once the chunks in flight finish.
+    TransportTally runHistories(uint64_t run_key, uint64_t first_history, double source_energy_MeV,
+                                int num_photons, int num_threads, TransportEngine engine,
+                                RunControl* control = nullptr) const;
+
+    // Fingerprint of everything that determines the tally of a history
+    // (layers and their tables, variance reduction, mesh tallies, generator,
+    // engine, energy), used to check checkpoints before resuming or merging
+    uint64_t configurationHash(double source_energy_MeV, TransportEngine engine) const;
+
+    // Turn the tally of num_photons histories into a result
+    MonteCarloResult summarize(const TransportTally& tally, long long num_photons, double source_energy_MeV,
+                               double elapsed_seconds) const;
 
 private:
     std::vector<MaterialLayer> layers_;
+    std::vector<LayerRecord> records_;   // Packed hot data of layers_ (the tables stay owned by layers_)
+    std::vector<double> layer_bounds_;   // Cumulative boundaries: layer i spans [b[i], b[i+1])
+    double total_thickness_;
+    VarianceReduction variance_reduction_;
+    std::vector<double> layer_stretch_;  // Exponential transform parameter per layer (resolved by simulate)
+    std::vector<SecondaryPhysics> layer_secondaries_;   // Per layer, empty unless a layer emits secondaries
+    MeshTallies mesh_tallies_;
+    RandomGenerator random_generator_;
+    const KleinNishinaTable* klein_nishina_;   // Shared inverse-CDF table
     std::mt19937 rng_;
-    std::uniform_real_distribution<double> uniform_dist_;
 
-    // Transport a single photon through the shield
-    void transportPhoton(Photon& photon, double& dose_deposited, bool& transmitted);
+    // Run photon chunks over num_threads workers and reduce their tallies
+    TransportTally runParallel(double source_energy_MeV, int num_photons,
+                               int num_threads, TransportEngine engine);
+
+    // Transport loops are templates on the generator (std::mt19937 or
+    // Philox4x32, instantiated by runChunk)
+
+    // Run a contiguous batch of photons with the given stream
+    template <typename Rng>
+    void runPhotons(Rng& rng, uint64_t first_history, double source_energy_MeV,
+                    int num_photons, TransportTally& tally) const;
+
+    // Same as runPhotons, using the SoA/SIMD kernel (batch_transport.cpp)
+    template <typename Rng>
+    void runPhotonsBatched(Rng& rng, uint64_t first_history, double source_energy_MeV,
+                           int num_photons, TransportTally& tally) const;
+
+    template <typename Rng>
+    void runChunkWith(uint64_t stream_key, uint64_t first_history, double source_energy_MeV,
+                      int num_photons, TransportEngine engine, TransportTally& tally) const;
+
+    // Transport a single photon through the shield, depositing into tally;
+    // split fragments go to bank, secondary photons to secondaries.
+    // Scope change: one generic loop for every layer count. Kernels
+    // specialised for N = 1..8 layers were measured 6-10% slower (the
+    // per-step log/sqrt/sin/cos dominate the boundary logic they unroll,
+    // and their copies lose the inlining of the RNG and collision code).
+    template <typename Rng>
+    void transportPhoton(Rng& rng, Photon& photon, bool& transmitted, std::vector<Photon>& bank,
+                         ParticleBank<Photon>& secondaries, TransportTally& tally) const;
+
+    // Absorb the fraction of the photon's weight in layer layer_idx: deposit
+    // its energy, less that of the secondary photons it emits (pair
+    // production then annihilation, or fluorescence; see SecondaryPhysics)
+    template <typename Rng>
+    void absorb(Rng& rng, const Photon& photon, double fraction, int layer_idx, const Attenuation& att,
+                ParticleBank<Photon>& secondaries, TransportTally& tally) const;
+
+    // Queue a secondary photon leaving the position of parent along
+    // direction; returns the energy to deposit instead when the bank is full
+    double emitSecondary(const Photon& parent, double energy_MeV, double weight,
+                         const double* direction, ParticleBank<Photon>& secondaries,
+                         TransportTally& tally) const;
+
+    // Russian roulette and splitting after a collision; false if the photon is killed
+    template <typename Rng>
+    bool applyWeightWindow(Rng& rng, Photon& photon,
+                           std::vector<Photon>& bank) const;
+
+    // Resolve layer_stretch_ (and the records' stretch) from variance_reduction_ and the current layers
+    void resolveStretch(double source_energy_MeV);
 
     // Sample free path length
-    double sampleFreePath(double mu_total);
+    template <typename Rng>
+    double sampleFreePath(Rng& rng, double mu_total) const;
 
     // Sample interaction type (Compton or photoelectric)
-    bool isComptonScattering(double mu_compton, double mu_total);
+    template <typename Rng>
+    bool isComptonScattering(Rng& rng, double mu_compton, double mu_total) const;
 
-    // Perform Compton scattering
-    void comptonScatter(Photon& photon);
+    // Perform Compton scattering (Klein-Nishina angle, 3D direction rotation)
+    template <typename Rng>
+    void comptonScatter(Rng& rng, Photon& photon) const;
 
-    // Find which layer the photon is in
+    // Find which layer the photon is in (binary search over layer_bounds_)
     int findLayer(double z_position) const;
 
-    // Calculate total shield thickness
+    // Total shield thickness (cached by setShieldLayers)
     double getTotalThickness() const;
 };
 
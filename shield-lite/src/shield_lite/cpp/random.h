@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+// Random number generators of the transport. A generator is a template
+// parameter of the transport loops (see photon_transport.cpp); the choice
+// between them is made once per run through RandomGenerator.
+
+namespace shield_lite {
+
+enum class RandomGenerator {
+    MT19937,    // One sequential std::mt19937 stream per chunk of histories
+    Philox      // Counter-based Philox4x32-10: one stream per history
+};
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3", SC 2011). Block k of stream s is a pure function of (key, s, k), so
+// any history can be replayed on its own and lanes can jump straight to
+// their own stream; the state is 32 bytes instead of 2.5 KB.
+class Philox4x32 {
+public:
+    using result_type = uint32_t;
+    using Block = std::array<uint32_t, 4>;
+
+    explicit Philox4x32(uint64_t key = 0, uint64_t stream = 0)
+        : key_{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)} {
+        setStream(stream);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint32_t>::max(); }
+
+    // Restart at the first block of stream s
+    void setStream(uint64_t stream) {
+        stream_ = stream;
+        position_ = 0;
+        index_ = 4;
+    }
+
+    result_type operator()() {
+        if (index_ == 4) {
+            buffer_ = block(stream_, position_++);
+            index_ = 0;
+        }
+        return buffer_[index_++];
+    }
+
+    // Block `position` of stream `stream` (counter = position, stream)
+    Block block(uint64_t stream, uint64_t position) const {
+        Block ctr = {static_cast<uint32_t>(position), static_cast<uint32_t>(position >> 32),
+                     static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+        uint32_t k0 = key_[0], k1 = key_[1];
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+            uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+            ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ k0, static_cast<uint32_t>(p1),
+                   static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ k1, static_cast<uint32_t>(p0)};
+            k0 += W0;
+            k1 += W1;
+        }
+        return ctr;
+    }
+
+    // Uniform double in [0, 1) with 53 random bits from two words
+    static double toUniform(uint32_t hi, uint32_t lo) {
+        return ((hi >> 5) * 67108864.0 + (lo >> 6)) * (1.0 / 9007199254740992.0);
+    }
+
+    // Uniform double in [0, 1) with 32 random bits
+    static double toUniform(uint32_t word) {
+        return word * (1.0 / 4294967296.0);
+    }
+
+private:
+    static constexpr uint32_t M0 = 0xD2511F53u;
+    static constexpr uint32_t M1 = 0xCD9E8D57u;
+    static constexpr uint32_t W0 = 0x9E3779B9u;
+    static constexpr uint32_t W1 = 0xBB67AE85u;
+
+    uint32_t key_[2];
+    uint64_t stream_ = 0;
+    uint64_t position_ = 0;
+    Block buffer_{};
+    int index_ = 4;
+};
+
+// Uniform random number in [0, 1)
+inline double uniform(std::mt19937& rng) {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+}
+
+inline double uniform(Philox4x32& rng) {
+    uint32_t hi = rng();
+    return Philox4x32::toUniform(hi, rng());
+}
+
+// Generator of a chunk of histories keyed by (stream_key, first_history).
+// mt19937 is seeded from both; Philox only takes the key since every
+// history selects its own stream (see startHistory).
+template <typename Rng>
+Rng makeChunkGenerator(uint64_t stream_key, uint64_t first_history);
+
+template <>
+inline std::mt19937 makeChunkGenerator<std::mt19937>(uint64_t stream_key, uint64_t first_history) {
+    std::seed_seq seq{static_cast<uint32_t>(stream_key), static_cast<uint32_t>(stream_key >> 32),
+                      static_cast<uint32_t>(first_history), static_cast<uint32_t>(first_history >> 32)};
+    return std::mt19937(seq);
+}
+
+template <>
+inline Philox4x32 makeChunkGenerator<Philox4x32>(uint64_t stream_key, uint64_t) {
+    return Philox4x32(stream_key);
+}
+
+// Called before each history: a sequential stream just carries on, a
+// counter-based one jumps to the stream of that history
+inline void startHistory(std::mt19937&, uint64_t) {}
+
+inline void startHistory(Philox4x32& rng, uint64_t history) {
+    rng.setStream(history);
+}
+
+} // namespace shield_lite
@@ -0,0 +1,183 @@
+#include "run_batch.h"
+#include "scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace shield_lite {
+
+namespace {
+
+// Unit of work: a chunk of histories of one configuration
+struct BatchChunk {
+    std::size_t config;
+    unsigned int index;     // Chunk index within the configuration
+    int num_photons;
+};
+
+// Stream key of one configuration; chunks and histories are told apart by
+// their first history, so no stream depends on which worker runs it
+uint64_t configKey(unsigned int seed, std::size_t config) {
+    std::seed_seq seq{seed, static_cast<unsigned int>(config),
+                      static_cast<unsigned int>(static_cast<uint64_t>(config) >> 32)};
+    uint32_t key[2];
+    seq.generate(key, key + 2);
+    return static_cast<uint64_t>(key[1]) << 32 | key[0];
+}
+
+} // namespace
+
+void validateShieldBatch(const ShieldBatch& batch, std::size_t num_materials) {
+    if (batch.layer_offsets[0] != 0) {
+        throw std::invalid_argument("layer_offsets must start at 0");
+    }
+    for (std::size_t c = 0; c < batch.num_configs; ++c) {
+        if (batch.layer_offsets[c + 1] <= batch.layer_offsets[c]) {
+            throw std::invalid_argument("Every configuration needs at least one layer");
+        }
+        if (batch.num_photons[c] <= 0 || !(batch.energy_MeV[c] > 0)) {
+            throw std::invalid_argument("Energies and photon counts must be positive");
+        }
+    }
+    for (int64_t l = 0; l < batch.layer_offsets[batch.num_configs]; ++l) {
+        if (batch.material_ids[l] < 0 || static_cast<std::size_t>(batch.material_ids[l]) >= num_materials) {
+            throw std::invalid_argument("Material id out of range");
+        }
+        if (batch.thickness_cm[l] < 0) {
+            throw std::invalid_argument("Thicknesses must be non-negative");
+        }
+    }
+}
+
+void simulateBatch(const std::vector<MaterialLayer>& materials,
+                   const ShieldBatch& batch,
+                   unsigned int seed,
+                   BatchResult* results,
+                   int num_threads,
+                   TransportEngine engine,
+                   const VarianceReduction& variance_reduction,
+                   RandomGenerator random_generator) {
+    validateShieldBatch(batch, materials.size());
+    if (engine != TransportEngine::Scalar && variance_reduction.split_weight > 0) {
+        throw std::invalid_argument("Particle splitting is only supported by the scalar engine");
+    }
+    if (engine != TransportEngine::Scalar &&
+        std::any_of(materials.begin(), materials.end(),
+                    [](const MaterialLayer& m) { return m.secondaries.enabled(); })) {
+        throw std::invalid_argument("Secondary particles are only supported by the scalar engine");
+    }
+    if (!variance_reduction.stretch.empty()) {
+        throw std::invalid_argument("Per-layer stretch does not apply to a batch, use auto_stretch");
+    }
+    if (engine == TransportEngine::Gpu) {
+        if (!PhotonTransport::gpuAvailable()) {
+            throw std::invalid_argument("The GPU engine needs a build with SHIELD_LITE_CUDA and a CUDA device");
+        }
+        if (random_generator != RandomGenerator::Philox) {
+            throw std::invalid_argument("The GPU engine requires the Philox generator");
+        }
+    }
+    // Validate once here: workers must not throw
+    PhotonTransport(seed).setVarianceReduction(variance_reduction);
+
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (engine == TransportEngine::Gpu) {
+        num_threads = 1;   // Configurations run one after another on this thread (see below)
+    }
+
+    // Split every configuration into chunks so a few expensive configurations
+    // (thick shields, many photons) spread over idle workers. The GPU engine
+    // runs each configuration in one device run, which keeps the device full;
+    // the histories, and so their streams, are the same.
+    const int chunk_photons = engine == TransportEngine::Gpu ? std::numeric_limits<int>::max()
+                                                             : PhotonTransport::kChunkPhotons;
+    std::vector<BatchChunk> chunks;
+    std::vector<std::size_t> first_chunk(batch.num_configs + 1, 0);
+    for (std::size_t c = 0; c < batch.num_configs; ++c) {
+        first_chunk[c] = chunks.size();
+        for (int64_t begin = 0, index = 0; begin < batch.num_photons[c]; begin += chunk_photons, ++index) {
+            chunks.push_back({c, static_cast<unsigned int>(index),
+                              static_cast<int>(std::min<int64_t>(chunk_photons, batch.num_photons[c] - begin))});
+        }
+    }
+    first_chunk[batch.num_configs] = chunks.size();
+
+    std::vector<TransportTally> tallies(chunks.size());
+    std::vector<double> chunk_seconds(chunks.size(), 0.0);
+    std::unique_ptr<std::atomic<std::size_t>[]> pending(new std::atomic<std::size_t>[batch.num_configs]);
+    for (std::size_t c = 0; c < batch.num_configs; ++c) {
+        pending[c] = first_chunk[c + 1] - first_chunk[c];
+    }
+
+    // Per-worker transport, reconfigured only when the worker moves to
+    // another configuration (neighbouring chunks usually share one)
+    struct WorkerState {
+        PhotonTransport transport;
+        std::size_t config = static_cast<std::size_t>(-1);
+    };
+    std::vector<WorkerState> states(num_threads);
+    for (auto& state : states) {
+        state.transport.setVarianceReduction(variance_reduction);
+        state.transport.setRandomGenerator(random_generator);
+    }
+
+    auto run_task = [&](std::size_t task, std::size_t worker) {
+        const BatchChunk& chunk = chunks[task];
+        const std::size_t c = chunk.config;
+        WorkerState& state = states[worker];
+        if (state.config != c) {
+            std::vector<MaterialLayer> layers;
+            for (int64_t l = batch.layer_offsets[c]; l < batch.layer_offsets[c + 1]; ++l) {
+                layers.push_back(materials[batch.material_ids[l]]);
+                layers.back().thickness_cm = batch.thickness_cm[l];
+            }
+            state.transport.setShieldLayers(layers);
+            state.transport.prepare(batch.energy_MeV[c], engine);
+            state.config = c;
+        }
+
+        const auto start_time = std::chrono::steady_clock::now();
+        state.transport.runChunk(configKey(seed, c),
+                                 static_cast<uint64_t>(chunk.index) * chunk_photons,
+                                 batch.energy_MeV[c], chunk.num_photons, engine, tallies[task]);
+        chunk_seconds[task] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+        // The worker finishing the last chunk of a configuration reduces it
+        if (pending[c].fetch_sub(1) != 1) {
+            return;
+        }
+        TransportTally total;
+        double elapsed = 0.0;
+        for (std::size_t k = first_chunk[c]; k < first_chunk[c + 1]; ++k) {
+            total.merge(tallies[k]);
+            elapsed += chunk_seconds[k];
+        }
+        MonteCarloResult r = state.transport.summarize(total, batch.num_photons[c],
+                                                       batch.energy_MeV[c], elapsed);
+        results[c] = {r.transmission_factor, r.transmission_uncertainty,
+                      r.dose_transmitted, r.dose_absorbed, r.buildup_factor,
+                      r.uncertainty, r.relative_uncertainty, r.elapsed_seconds,
+                      static_cast<int32_t>(r.total_photons),
+                      static_cast<int32_t>(r.transmitted_photons)};
+    };
+
+    if (engine == TransportEngine::Gpu) {
+        // Device runs throw std::runtime_error on CUDA failures, which must
+        // reach the caller instead of a worker thread (and one device run per
+        // configuration already keeps the device busy)
+        for (std::size_t task = 0; task < chunks.size(); ++task) {
+            run_task(task, 0);
+        }
+        return;
+    }
+    runWorkStealing(chunks.size(), num_threads, run_task);
+}
+
+} // namespace shield_lite
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "photon_transport.h"
+
+namespace shield_lite {
+
+// Many shield configurations packed into flat arrays. Configuration c uses
+// layers [layer_offsets[c], layer_offsets[c + 1]) of material_ids and
+// thickness_cm; material ids index the prototype layers given to
+// simulateBatch (their thickness is ignored).
+struct ShieldBatch {
+    const int64_t* layer_offsets;   // num_configs + 1 entries, starts at 0
+    const int32_t* material_ids;
+    const double* thickness_cm;
+    const double* energy_MeV;       // Source energy per configuration
+    const int32_t* num_photons;     // Histories per configuration
+    std::size_t num_configs;
+};
+
+// One result row; plain data so it maps onto a structured NumPy dtype
+struct BatchResult {
+    double transmission_factor;
+    double transmission_uncertainty;
+    double dose_transmitted;
+    double dose_absorbed;
+    double buildup_factor;
+    double uncertainty;
+    double relative_uncertainty;
+    double elapsed_seconds;         // Summed over the chunks of the configuration
+    int32_t total_photons;
+    int32_t transmitted_photons;
+};
+
+// Check the packed arrays against num_materials; throws std::invalid_argument
+void validateShieldBatch(const ShieldBatch& batch, std::size_t num_materials);
+
+// Simulate every configuration of the batch and write one row per
+// configuration to results. Configurations are split into chunks of
+// PhotonTransport::kChunkPhotons histories, run by num_threads work-stealing
+// workers (<= 0 uses all hardware threads); each chunk has a stream keyed by
+// (seed, configuration index, first history of the chunk) and chunk tallies
+// are reduced in chunk order, so the results do not depend on the thread
+// count or on the scheduling. The GPU engine runs the configurations one
+// after another on the calling thread (num_threads is ignored), so a CUDA
+// failure propagates as std::runtime_error.
+void simulateBatch(const std::vector<MaterialLayer>& materials,
+                   const ShieldBatch& batch,
+                   unsigned int seed,
+                   BatchResult* results,
+                   int num_threads = 0,
+                   TransportEngine engine = TransportEngine::Scalar,
+                   const VarianceReduction& variance_reduction = VarianceReduction(),
+                   RandomGenerator random_generator = RandomGenerator::MT19937);
+
+} // namespace shield_lite
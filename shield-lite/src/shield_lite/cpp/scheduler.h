@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shield_lite {
+
+// Work-stealing execution of a fixed set of independent tasks [0, num_tasks).
+// Each worker starts with a contiguous range of tasks (neighbouring chunks of
+// one configuration stay on one worker) and pops from its front; a worker
+// that runs dry steals the upper half of another worker's remaining range, so
+// expensive tasks at the tail do not leave threads idle. No task is created
+// while running, so a worker stops once every range is empty.
+// fn(task, worker) must not throw. num_threads <= 0 uses all hardware threads.
+template <typename Fn>
+void runWorkStealing(std::size_t num_tasks, int num_threads, Fn&& fn) {
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const std::size_t num_workers =
+        std::max<std::size_t>(1, std::min<std::size_t>(num_threads, num_tasks));
+
+    if (num_workers == 1) {
+        for (std::size_t task = 0; task < num_tasks; ++task) {
+            fn(task, 0);
+        }
+        return;
+    }
+
+    struct alignas(64) TaskRange {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+    std::unique_ptr<TaskRange[]> ranges(new TaskRange[num_workers]);
+    for (std::size_t w = 0; w < num_workers; ++w) {
+        ranges[w].begin = num_tasks * w / num_workers;
+        ranges[w].end = num_tasks * (w + 1) / num_workers;
+    }
+
+    auto pop = [&](std::size_t w, std::size_t& task) {
+        std::lock_guard<std::mutex> lock(ranges[w].mutex);
+        if (ranges[w].begin == ranges[w].end) {
+            return false;
+        }
+        task = ranges[w].begin++;
+        return true;
+    };
+
+    // Move the upper half of a victim's range into the (empty) own range
+    auto steal = [&](std::size_t w) {
+        for (std::size_t k = 1; k < num_workers; ++k) {
+            TaskRange& victim = ranges[(w + k) % num_workers];
+            std::size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                std::size_t remaining = victim.end - victim.begin;
+                if (remaining == 0) {
+                    continue;
+                }
+                end = victim.end;
+                begin = victim.end - (remaining + 1) / 2;
+                victim.end = begin;
+            }
+            std::lock_guard<std::mutex> lock(ranges[w].mutex);
+            ranges[w].begin = begin;
+            ranges[w].end = end;
+            return true;
+        }
+        return false;
+    };
+
+    auto work = [&](std::size_t w) {
+        std::size_t task;
+        while (true) {
+            while (pop(w, task)) {
+                fn(task, w);
+            }
+            if (!steal(w)) {
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_workers - 1);
+    for (std::size_t w = 1; w < num_workers; ++w) {
+        workers.emplace_back(work, w);
+    }
+    work(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace shield_lite
@@ -0,0 +1,259 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Minimal SIMD layer for the batched transport kernel.
+// The widest instruction set enabled at compile time (-march=native in
+// Release) is selected; otherwise every operation falls back to one lane.
+namespace shield_lite {
+namespace simd {
+
+constexpr double LN2 = 0.69314718055994530942;
+constexpr double SQRT2 = 1.41421356237309504880;
+constexpr double LOG2E = 1.44269504088896340736;
+constexpr double LN2_HI = 6.93147180369123816490e-01;   // ln2 split for exact k * ln2
+constexpr double LN2_LO = 1.90821492927058770002e-10;
+constexpr double EXP_LIMIT = 708.0;
+
+// Taylor coefficients of e^r, highest degree first (1/12!, ..., 1/1!, 1)
+constexpr int EXP_DEGREE = 12;
+constexpr double EXP_COEFFS[EXP_DEGREE + 1] = {
+    1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0,
+    1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0,
+    1.0 / 24.0, 1.0 / 6.0, 1.0 / 2.0, 1.0, 1.0};
+
+#if defined(__AVX512F__)
+
+constexpr int kWidth = 8;
+constexpr const char* kIsa = "avx512";
+using vdouble = __m512d;
+using vmask = __mmask8;
+using vindex = __m256i;
+
+inline vdouble load(const double* p) { return _mm512_loadu_pd(p); }
+inline void store(double* p, vdouble v) { _mm512_storeu_pd(p, v); }
+inline vdouble set1(double x) { return _mm512_set1_pd(x); }
+inline vdouble add(vdouble a, vdouble b) { return _mm512_add_pd(a, b); }
+inline vdouble sub(vdouble a, vdouble b) { return _mm512_sub_pd(a, b); }
+inline vdouble mul(vdouble a, vdouble b) { return _mm512_mul_pd(a, b); }
+inline vdouble div(vdouble a, vdouble b) { return _mm512_div_pd(a, b); }
+inline vdouble max(vdouble a, vdouble b) { return _mm512_max_pd(a, b); }
+inline vdouble min(vdouble a, vdouble b) { return _mm512_min_pd(a, b); }
+inline vdouble abs(vdouble a) {
+    return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a),
+                                                _mm512_set1_epi64(0x7FFFFFFFFFFFFFFFLL)));
+}
+inline vmask less(vdouble a, vdouble b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+inline vmask mask_and(vmask a, vmask b) { return static_cast<vmask>(a & b); }
+inline vmask mask_andnot(vmask a, vmask b) { return static_cast<vmask>(a & ~b); }
+inline unsigned mask_bits(vmask m) { return m; }
+// select(m, a, b) = m ? a : b per lane
+inline vdouble select(vmask m, vdouble a, vdouble b) { return _mm512_mask_blend_pd(m, b, a); }
+inline vindex load_index(const int32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+inline void store_index(int32_t* p, vindex v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+inline vdouble gather(const double* base, vindex idx) { return _mm512_i32gather_pd(idx, base, 8); }
+inline vdouble sqrt(vdouble a) { return _mm512_sqrt_pd(a); }
+inline vdouble trunc(vdouble a) { return _mm512_roundscale_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+// Truncated to int32 (inputs must be in range)
+inline vindex to_index(vdouble a) { return _mm512_cvttpd_epi32(a); }
+
+// Natural log for positive normal inputs (~1e-15 relative error)
+inline vdouble log(vdouble x) {
+    const __m512i bits = _mm512_castpd_si512(x);
+    // Exponent as a double via the 2^52 magic-number trick (no AVX512DQ needed)
+    const __m512i magic = _mm512_set1_epi64(0x4330000000000000LL);
+    vdouble k = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bits, 52), magic)),
+                              set1(4503599627370496.0));
+    vdouble m = _mm512_castsi512_pd(_mm512_or_si512(
+        _mm512_and_si512(bits, _mm512_set1_epi64(0x000FFFFFFFFFFFFFLL)),
+        _mm512_set1_epi64(0x3FF0000000000000LL)));
+    vmask big = _mm512_cmp_pd_mask(m, set1(SQRT2), _CMP_GT_OQ);
+    m = _mm512_mask_mul_pd(m, big, m, set1(0.5));
+    k = _mm512_mask_add_pd(k, big, k, set1(1.0));
+    vdouble e = sub(k, set1(1023.0));
+
+    // log(m) = 2 atanh(f), f = (m - 1) / (m + 1), |f| <= 0.1716
+    vdouble f = div(sub(m, set1(1.0)), add(m, set1(1.0)));
+    vdouble s = mul(f, f);
+    vdouble p = set1(1.0 / 15.0);
+    p = _mm512_fmadd_pd(p, s, set1(1.0 / 13.0));
+    p = _mm512_fmadd_pd(p, s, set1(1.0 / 11.0));
+    p = _mm512_fmadd_pd(p, s, set1(1.0 / 9.0));
+    p = _mm512_fmadd_pd(p, s, set1(1.0 / 7.0));
+    p = _mm512_fmadd_pd(p, s, set1(1.0 / 5.0));
+    p = _mm512_fmadd_pd(p, s, set1(1.0 / 3.0));
+    p = _mm512_fmadd_pd(p, s, set1(1.0));
+    return _mm512_fmadd_pd(e, set1(LN2), mul(mul(set1(2.0), f), p));
+}
+
+// Exponential, inputs clamped to [-708, 708] (~1e-15 relative error)
+inline vdouble exp(vdouble x) {
+    x = min(max(x, set1(-EXP_LIMIT)), set1(EXP_LIMIT));
+    vdouble k = _mm512_roundscale_pd(mul(x, set1(LOG2E)), _MM_FROUND_TO_NEAREST_INT);
+    vdouble r = _mm512_fnmadd_pd(k, set1(LN2_LO), _mm512_fnmadd_pd(k, set1(LN2_HI), x));
+
+    // e^r, |r| <= ln2 / 2, Taylor series to degree 12
+    vdouble p = set1(EXP_COEFFS[0]);
+    for (int i = 1; i < EXP_DEGREE + 1; ++i) {
+        p = _mm512_fmadd_pd(p, r, set1(EXP_COEFFS[i]));
+    }
+
+    // 2^k from the biased exponent, again via the 2^52 magic number
+    __m512i biased = _mm512_castpd_si512(add(k, set1(4503599627370496.0 + 1023.0)));
+    return mul(p, _mm512_castsi512_pd(_mm512_slli_epi64(biased, 52)));
+}
+
+#elif defined(__AVX2__)
+
+constexpr int kWidth = 4;
+constexpr const char* kIsa = "avx2";
+using vdouble = __m256d;
+using vmask = __m256d;
+using vindex = __m128i;
+
+inline vdouble load(const double* p) { return _mm256_loadu_pd(p); }
+inline void store(double* p, vdouble v) { _mm256_storeu_pd(p, v); }
+inline vdouble set1(double x) { return _mm256_set1_pd(x); }
+inline vdouble add(vdouble a, vdouble b) { return _mm256_add_pd(a, b); }
+inline vdouble sub(vdouble a, vdouble b) { return _mm256_sub_pd(a, b); }
+inline vdouble mul(vdouble a, vdouble b) { return _mm256_mul_pd(a, b); }
+inline vdouble div(vdouble a, vdouble b) { return _mm256_div_pd(a, b); }
+inline vdouble max(vdouble a, vdouble b) { return _mm256_max_pd(a, b); }
+inline vdouble min(vdouble a, vdouble b) { return _mm256_min_pd(a, b); }
+inline vdouble abs(vdouble a) { return _mm256_andnot_pd(set1(-0.0), a); }
+inline vmask less(vdouble a, vdouble b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+inline vmask mask_and(vmask a, vmask b) { return _mm256_and_pd(a, b); }
+inline vmask mask_andnot(vmask a, vmask b) { return _mm256_andnot_pd(b, a); }
+inline unsigned mask_bits(vmask m) { return static_cast<unsigned>(_mm256_movemask_pd(m)); }
+// select(m, a, b) = m ? a : b per lane
+inline vdouble select(vmask m, vdouble a, vdouble b) { return _mm256_blendv_pd(b, a, m); }
+inline vindex load_index(const int32_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+inline void store_index(int32_t* p, vindex v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+inline vdouble gather(const double* base, vindex idx) { return _mm256_i32gather_pd(base, idx, 8); }
+inline vdouble sqrt(vdouble a) { return _mm256_sqrt_pd(a); }
+inline vdouble trunc(vdouble a) { return _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+// Truncated to int32 (inputs must be in range)
+inline vindex to_index(vdouble a) { return _mm256_cvttpd_epi32(a); }
+
+inline vdouble fmadd(vdouble a, vdouble b, vdouble c) {
+#if defined(__FMA__)
+    return _mm256_fmadd_pd(a, b, c);
+#else
+    return add(mul(a, b), c);
+#endif
+}
+
+// Natural log for positive normal inputs (~1e-15 relative error)
+inline vdouble log(vdouble x) {
+    const __m256i bits = _mm256_castpd_si256(x);
+    // Exponent as a double via the 2^52 magic-number trick (no int64 -> double in AVX2)
+    const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+    vdouble k = sub(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), magic)),
+                    set1(4503599627370496.0));
+    vdouble m = _mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+        _mm256_set1_epi64x(0x3FF0000000000000LL)));
+    vmask big = _mm256_cmp_pd(m, set1(SQRT2), _CMP_GT_OQ);
+    m = select(big, mul(m, set1(0.5)), m);
+    k = add(k, _mm256_and_pd(big, set1(1.0)));
+    vdouble e = sub(k, set1(1023.0));
+
+    // log(m) = 2 atanh(f), f = (m - 1) / (m + 1), |f| <= 0.1716
+    vdouble f = div(sub(m, set1(1.0)), add(m, set1(1.0)));
+    vdouble s = mul(f, f);
+    vdouble p = set1(1.0 / 15.0);
+    p = fmadd(p, s, set1(1.0 / 13.0));
+    p = fmadd(p, s, set1(1.0 / 11.0));
+    p = fmadd(p, s, set1(1.0 / 9.0));
+    p = fmadd(p, s, set1(1.0 / 7.0));
+    p = fmadd(p, s, set1(1.0 / 5.0));
+    p = fmadd(p, s, set1(1.0 / 3.0));
+    p = fmadd(p, s, set1(1.0));
+    return fmadd(e, set1(LN2), mul(mul(set1(2.0), f), p));
+}
+
+// Exponential, inputs clamped to [-708, 708] (~1e-15 relative error)
+inline vdouble exp(vdouble x) {
+    x = min(max(x, set1(-EXP_LIMIT)), set1(EXP_LIMIT));
+    vdouble k = _mm256_round_pd(mul(x, set1(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    vdouble r = sub(sub(x, mul(k, set1(LN2_HI))), mul(k, set1(LN2_LO)));
+
+    // e^r, |r| <= ln2 / 2, Taylor series to degree 12
+    vdouble p = set1(EXP_COEFFS[0]);
+    for (int i = 1; i < EXP_DEGREE + 1; ++i) {
+        p = fmadd(p, r, set1(EXP_COEFFS[i]));
+    }
+
+    // 2^k from the biased exponent, again via the 2^52 magic number
+    __m256i biased = _mm256_castpd_si256(add(k, set1(4503599627370496.0 + 1023.0)));
+    return mul(p, _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52)));
+}
+
+#else
+
+constexpr int kWidth = 1;
+constexpr const char* kIsa = "scalar";
+using vdouble = double;
+using vmask = bool;
+using vindex = int32_t;
+
+inline vdouble load(const double* p) { return *p; }
+inline void store(double* p, vdouble v) { *p = v; }
+inline vdouble set1(double x) { return x; }
+inline vdouble add(vdouble a, vdouble b) { return a + b; }
+inline vdouble sub(vdouble a, vdouble b) { return a - b; }
+inline vdouble mul(vdouble a, vdouble b) { return a * b; }
+inline vdouble div(vdouble a, vdouble b) { return a / b; }
+inline vdouble max(vdouble a, vdouble b) { return a > b ? a : b; }
+inline vdouble min(vdouble a, vdouble b) { return a < b ? a : b; }
+inline vdouble abs(vdouble a) { return std::abs(a); }
+inline vmask less(vdouble a, vdouble b) { return a < b; }
+inline vmask mask_and(vmask a, vmask b) { return a && b; }
+inline vmask mask_andnot(vmask a, vmask b) { return a && !b; }
+inline unsigned mask_bits(vmask m) { return m ? 1u : 0u; }
+inline vdouble select(vmask m, vdouble a, vdouble b) { return m ? a : b; }
+inline vindex load_index(const int32_t* p) { return *p; }
+inline void store_index(int32_t* p, vindex v) { *p = v; }
+inline vdouble gather(const double* base, vindex idx) { return base[idx]; }
+inline vdouble sqrt(vdouble a) { return std::sqrt(a); }
+inline vdouble trunc(vdouble a) { return std::trunc(a); }
+inline vindex to_index(vdouble a) { return static_cast<int32_t>(a); }
+inline vdouble log(vdouble x) { return std::log(x); }
+inline vdouble exp(vdouble x) { return std::exp(x); }
+
+#endif
+
+// Taylor coefficients of cos(x) in x^2, highest degree first (x^20 / 20!, ..., 1)
+constexpr int COS_DEGREE = 10;
+constexpr double COS_COEFFS[COS_DEGREE + 1] = {
+    1.0 / 2432902008176640000.0, -1.0 / 6402373705728000.0, 1.0 / 20922789888000.0,
+    -1.0 / 87178291200.0, 1.0 / 479001600.0, -1.0 / 3628800.0, 1.0 / 40320.0,
+    -1.0 / 720.0, 1.0 / 24.0, -1.0 / 2.0, 1.0};
+
+// cos(2 pi u) for u in [0, 1) (~1e-16 absolute error), built on the
+// primitives above: folded to an argument in [0, pi / 2]
+inline vdouble cos2pi(vdouble u) {
+    // cos(2 pi u) = -cos(2 pi s), s = |u - 1/2| in [0, 1/2]
+    vdouble s = abs(sub(u, set1(0.5)));
+    // cos(2 pi s) = -cos(2 pi (1/2 - s)) folds s onto t in [0, 1/4]
+    vmask upper = less(set1(0.25), s);
+    vdouble t = min(s, sub(set1(0.5), s));
+    vdouble x = mul(t, set1(6.28318530717958647693));
+    vdouble x2 = mul(x, x);
+    vdouble p = set1(COS_COEFFS[0]);
+    for (int i = 1; i < COS_DEGREE + 1; ++i) {
+        p = add(mul(p, x2), set1(COS_COEFFS[i]));
+    }
+    return select(upper, p, sub(set1(0.0), p));
+}
+
+} // namespace simd
+} // namespace shield_lite
@@ -0,0 +1,126 @@
+#include "surrogate.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace shield_lite {
+
+namespace {
+
+// Below this many rows per worker, thread startup costs more than it saves
+constexpr std::size_t MIN_ROWS_PER_THREAD = 1024;
+
+} // namespace
+
+SurrogateEnsemble::SurrogateEnsemble(std::vector<double> input_shift,
+                                     std::vector<double> input_scale,
+                                     std::vector<std::vector<DenseLayer>> members)
+    : input_shift_(std::move(input_shift)),
+      input_scale_(std::move(input_scale)),
+      members_(std::move(members)),
+      max_width_(static_cast<int>(input_shift_.size())) {
+    if (input_shift_.empty() || input_scale_.size() != input_shift_.size()) {
+        throw std::invalid_argument("input_shift and input_scale need one entry per feature");
+    }
+    for (double scale : input_scale_) {
+        if (!(scale > 0)) {
+            throw std::invalid_argument("input_scale must be positive");
+        }
+    }
+    if (members_.empty()) {
+        throw std::invalid_argument("The ensemble needs at least one member");
+    }
+    for (std::size_t m = 0; m < members_.size(); ++m) {
+        const std::vector<DenseLayer>& layers = members_[m];
+        int width = numInputs();
+        for (const DenseLayer& layer : layers) {
+            if (layer.inputs != width || layer.outputs <= 0 ||
+                layer.weights.size() != static_cast<std::size_t>(layer.inputs) * layer.outputs ||
+                layer.bias.size() != static_cast<std::size_t>(layer.outputs)) {
+                throw std::invalid_argument("Inconsistent layer shapes in member " + std::to_string(m));
+            }
+            width = layer.outputs;
+            max_width_ = std::max(max_width_, width);
+        }
+        if (layers.empty() || width != 1) {
+            throw std::invalid_argument("Member " + std::to_string(m) + " must end with one output");
+        }
+    }
+}
+
+void SurrogateEnsemble::evaluateRange(const double* features, std::size_t begin, std::size_t end,
+                                      double* mean, double* stddev) const {
+    const int num_inputs = numInputs();
+    std::vector<double> standardized(num_inputs);
+    std::vector<double> current(max_width_);
+    std::vector<double> next(max_width_);
+    std::vector<double> outputs(members_.size());
+
+    for (std::size_t row = begin; row < end; ++row) {
+        const double* x = features + row * num_inputs;
+        for (int i = 0; i < num_inputs; ++i) {
+            standardized[i] = (x[i] - input_shift_[i]) / input_scale_[i];
+        }
+
+        for (std::size_t m = 0; m < members_.size(); ++m) {
+            const std::vector<DenseLayer>& layers = members_[m];
+            std::copy(standardized.begin(), standardized.end(), current.begin());
+            for (std::size_t l = 0; l < layers.size(); ++l) {
+                const DenseLayer& layer = layers[l];
+                const bool hidden = l + 1 < layers.size();
+                for (int o = 0; o < layer.outputs; ++o) {
+                    const double* w = layer.weights.data() + static_cast<std::size_t>(o) * layer.inputs;
+                    double sum = layer.bias[o];
+                    for (int i = 0; i < layer.inputs; ++i) {
+                        sum += w[i] * current[i];
+                    }
+                    next[o] = hidden ? std::max(sum, 0.0) : sum;
+                }
+                std::swap(current, next);
+            }
+            outputs[m] = current[0];
+        }
+
+        // Two-pass mean and (sample) standard deviation over the members
+        double total = 0.0;
+        for (double y : outputs) {
+            total += y;
+        }
+        const double mu = total / outputs.size();
+        double m2 = 0.0;
+        for (double y : outputs) {
+            m2 += (y - mu) * (y - mu);
+        }
+        mean[row] = mu;
+        stddev[row] = outputs.size() > 1 ? std::sqrt(m2 / (outputs.size() - 1)) : 0.0;
+    }
+}
+
+void SurrogateEnsemble::evaluate(const double* features, std::size_t num_rows,
+                                 double* mean, double* stddev, int num_threads) const {
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t max_threads = std::max<std::size_t>(1, num_rows / MIN_ROWS_PER_THREAD);
+    std::size_t workers_count = std::min<std::size_t>(num_threads, max_threads);
+
+    if (workers_count == 1) {
+        evaluateRange(features, 0, num_rows, mean, stddev);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(workers_count);
+    for (std::size_t t = 0; t < workers_count; ++t) {
+        std::size_t begin = num_rows * t / workers_count;
+        std::size_t end = num_rows * (t + 1) / workers_count;
+        workers.emplace_back(&SurrogateEnsemble::evaluateRange, this, features, begin, end, mean, stddev);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace shield_lite
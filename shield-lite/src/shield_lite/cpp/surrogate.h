@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace shield_lite {
+
+// Fully connected layer y = W x + b, W row-major [outputs x inputs]
+struct DenseLayer {
+    int inputs;
+    int outputs;
+    std::vector<double> weights;
+    std::vector<double> bias;
+};
+
+// Ensemble of small MLPs (ReLU hidden layers, one linear output) trained on
+// Monte Carlo results. Inputs are standardized as (x - shift) / scale
+// before the first layer. The spread of the member outputs estimates the
+// model uncertainty, used to decide when to fall back to a real run.
+class SurrogateEnsemble {
+public:
+    // Every member maps input_shift.size() features to one output.
+    // Throws std::invalid_argument on inconsistent shapes.
+    SurrogateEnsemble(std::vector<double> input_shift,
+                      std::vector<double> input_scale,
+                      std::vector<std::vector<DenseLayer>> members);
+
+    int numInputs() const { return static_cast<int>(input_shift_.size()); }
+    int numMembers() const { return static_cast<int>(members_.size()); }
+
+    // features is row-major [num_rows x numInputs()]; writes the mean and the
+    // standard deviation of the member outputs of each row. Rows are split
+    // over num_threads workers (<= 0 uses all hardware threads).
+    void evaluate(const double* features, std::size_t num_rows,
+                  double* mean, double* stddev, int num_threads = 0) const;
+
+private:
+    void evaluateRange(const double* features, std::size_t begin, std::size_t end,
+                       double* mean, double* stddev) const;
+
+    std::vector<double> input_shift_;
+    std::vector<double> input_scale_;
+    std::vector<std::vector<DenseLayer>> members_;
+    int max_width_;
+};
+
+} // namespace shield_lite
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "host_device.h"
+
+namespace shield_lite {
+
+// Constant-memory streaming tally (Welford / Pébay update formulas).
+// Tracks the count, mean and central moments up to order 4 in one pass,
+// and two tallies can be merged exactly, so per-thread and per-run tallies
+// combine into the one that a single pass over all samples would give.
+// The update and merge also run on the GPU (gpu_transport.cu).
+class StreamingTally {
+public:
+    SHIELD_LITE_HD StreamingTally() : count_(0), mean_(0), m2_(0), m3_(0), m4_(0) {}
+
+    // Tally of `count` identical samples
+    static StreamingTally constant(double value, long long count) {
+        StreamingTally t;
+        if (count > 0) {
+            t.count_ = count;
+            t.mean_ = value;
+        }
+        return t;
+    }
+
+    // Tally with the given central moments (restoring a saved tally)
+    static StreamingTally fromMoments(long long count, double mean, double m2, double m3, double m4) {
+        StreamingTally t;
+        if (count > 0) {
+            t.count_ = count;
+            t.mean_ = mean;
+            t.m2_ = m2;
+            t.m3_ = m3;
+            t.m4_ = m4;
+        }
+        return t;
+    }
+
+    SHIELD_LITE_HD void add(double x) {
+        const double n1 = static_cast<double>(count_);
+        ++count_;
+        const double n = static_cast<double>(count_);
+        const double delta = x - mean_;
+        const double delta_n = delta / n;
+        const double delta_n2 = delta_n * delta_n;
+        const double term1 = delta * delta_n * n1;
+
+        mean_ += delta_n;
+        m4_ += term1 * delta_n2 * (n * n - 3.0 * n + 3.0) + 6.0 * delta_n2 * m2_ - 4.0 * delta_n * m3_;
+        m3_ += term1 * delta_n * (n - 2.0) - 3.0 * delta_n * m2_;
+        m2_ += term1;
+    }
+
+    SHIELD_LITE_HD void merge(const StreamingTally& other) {
+        if (other.count_ == 0) {
+            return;
+        }
+        if (count_ == 0) {
+            *this = other;
+            return;
+        }
+        const double na = static_cast<double>(count_);
+        const double nb = static_cast<double>(other.count_);
+        const double n = na + nb;
+        const double delta = other.mean_ - mean_;
+        const double delta2 = delta * delta;
+
+        const double m2 = m2_ + other.m2_ + delta2 * na * nb / n;
+        const double m3 = m3_ + other.m3_
+                        + delta * delta2 * na * nb * (na - nb) / (n * n)
+                        + 3.0 * delta * (na * other.m2_ - nb * m2_) / n;
+        const double m4 = m4_ + other.m4_
+                        + delta2 * delta2 * na * nb * (na * na - na * nb + nb * nb) / (n * n * n)
+                        + 6.0 * delta2 * (na * na * other.m2_ + nb * nb * m2_) / (n * n)
+                        + 4.0 * delta * (na * other.m3_ - nb * m3_) / n;
+
+        count_ += other.count_;
+        mean_ += delta * nb / n;
+        m2_ = m2;
+        m3_ = m3;
+        m4_ = m4;
+    }
+
+    SHIELD_LITE_HD long long count() const { return count_; }
+    SHIELD_LITE_HD double mean() const { return mean_; }
+
+    // Sums of squared, cubed and fourth-power deviations from the mean
+    SHIELD_LITE_HD double m2() const { return m2_; }
+    SHIELD_LITE_HD double m3() const { return m3_; }
+    SHIELD_LITE_HD double m4() const { return m4_; }
+    double sum() const { return mean_ * static_cast<double>(count_); }
+
+    // Population variance (divides by n)
+    double variance() const { return count_ > 0 ? m2_ / count_ : 0.0; }
+
+    // Standard error of the mean
+    double standardError() const { return count_ > 0 ? std::sqrt(variance() / count_) : 0.0; }
+
+    double skewness() const {
+        return m2_ > 0 ? std::sqrt(static_cast<double>(count_)) * m3_ / std::pow(m2_, 1.5) : 0.0;
+    }
+
+    // Excess kurtosis
+    double kurtosis() const {
+        return m2_ > 0 ? static_cast<double>(count_) * m4_ / (m2_ * m2_) - 3.0 : 0.0;
+    }
+
+    // Relative variance of the variance (MCNP-style VOV), should fall as 1/n
+    double varianceOfVariance() const {
+        return m2_ > 0 ? m4_ / (m2_ * m2_) - 1.0 / count_ : 0.0;
+    }
+
+private:
+    long long count_;
+    double mean_;
+    double m2_, m3_, m4_;   // Sums of powers of deviations from the mean
+};
+
+// Fixed-width histogram over [lower, upper]; samples outside are clamped to
+// the end bins. A default-constructed histogram is disabled and add() only
+// costs the emptiness test, so the transport always scores into it.
+class Histogram {
+public:
+    Histogram() : lower_(0), upper_(0), inv_width_(0) {}
+
+    Histogram(int bins, double lower, double upper)
+        : lower_(lower), upper_(upper),
+          inv_width_(upper > lower ? bins / (upper - lower) : 0.0),
+          values_(std::max(bins, 0), 0.0) {}
+
+    // Histogram with the given bin contents (restoring a saved tally)
+    Histogram(double lower, double upper, std::vector<double> values)
+        : lower_(lower), upper_(upper),
+          inv_width_(upper > lower ? values.size() / (upper - lower) : 0.0),
+          values_(std::move(values)) {}
+
+    bool enabled() const { return !values_.empty(); }
+
+    void add(double x, double weight) {
+        if (values_.empty()) {
+            return;
+        }
+        const int last = static_cast<int>(values_.size()) - 1;
+        const double position = (x - lower_) * inv_width_;
+        const int bin = position <= 0 ? 0 : std::min(static_cast<int>(position), last);
+        values_[bin] += weight;
+    }
+
+    // Bin-wise sum (both histograms must share the binning, or one be disabled)
+    void merge(const Histogram& other) {
+        if (!other.enabled()) {
+            return;
+        }
+        if (!enabled()) {
+            *this = other;
+            return;
+        }
+        for (std::size_t i = 0; i < values_.size(); ++i) {
+            values_[i] += other.values_[i];
+        }
+    }
+
+    void scale(double factor) {
+        for (double& v : values_) {
+            v *= factor;
+        }
+    }
+
+    int bins() const { return static_cast<int>(values_.size()); }
+    double lower() const { return lower_; }
+    double upper() const { return upper_; }
+    const double* data() const { return values_.data(); }
+    const std::vector<double>& values() const { return values_; }
+
+private:
+    double lower_, upper_;
+    double inv_width_;
+    std::vector<double> values_;
+};
+
+} // namespace shield_lite
@@ -0,0 +1,169 @@
+"""
+Classement Monte Carlo de designs avec nombres aléatoires communs (CRN).
+
+Deux designs voisins simulés indépendamment diffèrent surtout par le bruit
+statistique. Ici, tous les candidats rejouent les mêmes histoires : même seed,
+générateur Philox (un flux par histoire) et mêmes plages d'histoires via
+MonteCarloSimulator.run_tally, de sorte que l'histoire h voit les mêmes tirages
+dans chaque design. Les différences de dose sont alors estimées par paires de
+lots, avec une variance bien plus faible que celle de chaque dose.
+
+Le classement procède par élimination successive (racing) : après chaque
+tranche de lots, les candidats significativement moins bons que le meilleur
+sont écartés, et seuls les survivants reçoivent de nouvelles histoires,
+ajoutées à la suite de celles déjà simulées.
+"""
+
+from typing import Any, Dict, List, Optional
+
+import numpy as np
+
+try:
+    from shield_lite.core.monte_carlo import (
+        MeshTallies, MonteCarloShieldSimulator, TransportTally, VarianceReduction, parse_engine
+    )
+except ImportError:
+    MonteCarloShieldSimulator = None
+
+OBJECTIVES = ('dose_transmitted', 'transmission_factor')
+
+
+def rank_designs(
+    designs: List[Dict[str, float]],
+    materials: Dict[str, Dict[str, float]],
+    source_energy_MeV: float,
+    objective: str = 'dose_transmitted',
+    batch_photons: int = 10000,
+    initial_batches: int = 8,
+    max_batches: int = 64,
+    z: float = 3.0,
+    keep: int = 1,
+    seed: int = 42,
+    rng: str = "philox",
+    num_threads: int = 0,
+    engine: str = "scalar",
+    variance_reduction: Optional[Any] = None
+) -> List[Dict[str, Any]]:
+    """
+    Classe des designs par dose Monte Carlo croissante, avec nombres aléatoires communs.
+
+    Parameters
+    ----------
+    designs : list of dict
+        Épaisseurs en cm par matériau, couches dans l'ordre du dict (depuis la
+        source), ex. les "thicknesses" (mm) de grid_search divisées par 10
+    materials : dict
+        Propriétés par matériau : 'mu_total', 'mu_compton', 'mu_photoelectric'
+        (cm^-1) et 'density_g_cm3'
+    source_energy_MeV : float
+        Énergie de la source
+    objective : str
+        Grandeur à minimiser : 'dose_transmitted' ou 'transmission_factor'
+    batch_photons : int
+        Histoires par lot ; les estimations et leurs incertitudes sont faites
+        sur les moyennes par lot
+    initial_batches : int
+        Lots simulés par tranche (et au premier passage) pour chaque survivant
+    max_batches : int
+        Budget maximal de lots par design
+    z : float
+        Seuil d'élimination : un design est écarté quand sa différence avec le
+        meilleur dépasse z écarts-types de la différence appariée
+    keep : int
+        Arrêt dès qu'il ne reste que keep candidats
+    seed, rng : int, str
+        Seed et générateur communs à tous les designs ("philox" donne un flux
+        par histoire ; avec "mt19937", seuls les paquets de 8192 histoires
+        partagent leurs flux et la corrélation est plus faible)
+    num_threads, engine, variance_reduction :
+        Comme MonteCarloShieldSimulator.run
+
+    Returns
+    -------
+    list of dict
+        Un dict par design, du meilleur au moins bon : 'thicknesses', 'value'
+        (objectif sur toutes ses histoires), 'uncertainty' (erreur type par
+        lots), 'difference' et 'difference_uncertainty' (écart apparié au
+        meilleur, sur les lots communs), 'photons', 'eliminated' et 'result'
+        (MonteCarloResult de toutes ses histoires)
+    """
+    if MonteCarloShieldSimulator is None:
+        raise ImportError("Le module C++ _monte_carlo n'est pas compilé")
+    if objective not in OBJECTIVES:
+        raise ValueError(f"Objectif inconnu '{objective}'. Disponibles : {list(OBJECTIVES)}")
+    if batch_photons <= 0 or initial_batches < 2 or max_batches < initial_batches:
+        raise ValueError("Il faut batch_photons > 0 et 2 <= initial_batches <= max_batches")
+    if not designs:
+        raise ValueError("Aucun design à classer")
+    if variance_reduction is None:
+        variance_reduction = VarianceReduction()
+    transport_engine = parse_engine(engine)
+
+    candidates = []
+    for thicknesses in designs:
+        sim = MonteCarloShieldSimulator(seed=seed, rng=rng)
+        names = list(thicknesses)
+        sim.add_layers(names, [thicknesses[m] for m in names],
+                       [materials[m]['mu_total'] for m in names],
+                       [materials[m]['mu_compton'] for m in names],
+                       [materials[m]['mu_photoelectric'] for m in names],
+                       [materials[m]['density_g_cm3'] for m in names])
+        candidates.append({'thicknesses': dict(thicknesses), 'sim': sim,
+                           'tally': TransportTally(), 'batches': [], 'eliminated': False})
+
+    def run_batches(candidate, count):
+        # Lots consécutifs : le lot b couvre les histoires [b n, (b + 1) n) dans tous les designs
+        sim = candidate['sim'].simulator
+        for _ in range(count):
+            first = len(candidate['batches']) * batch_photons
+            tally = sim.run_tally(source_energy_MeV, first, batch_photons, num_threads,
+                                  transport_engine, variance_reduction, MeshTallies())
+            batch = sim.summarize(tally, batch_photons, source_energy_MeV)
+            candidate['batches'].append(getattr(batch, objective))
+            candidate['tally'].merge(tally)
+
+    def paired(candidate, best):
+        # Différence appariée sur les lots communs (mêmes histoires)
+        n = min(len(candidate['batches']), len(best['batches']))
+        d = np.asarray(candidate['batches'][:n]) - np.asarray(best['batches'][:n])
+        return float(d.mean()), float(d.std(ddof=1) / np.sqrt(n))
+
+    active = list(candidates)
+    for candidate in active:
+        run_batches(candidate, initial_batches)
+
+    while True:
+        best = min(active, key=lambda c: np.mean(c['batches']))
+        survivors = []
+        for candidate in active:
+            if candidate is not best:
+                mean, se = paired(candidate, best)
+                if mean > z * se:
+                    candidate['eliminated'] = True
+                    continue
+            survivors.append(candidate)
+        active = survivors
+        if len(active) <= keep or len(best['batches']) >= max_batches:
+            break
+        for candidate in active:
+            run_batches(candidate, min(initial_batches, max_batches - len(candidate['batches'])))
+
+    best = min(candidates, key=lambda c: (c['eliminated'], np.mean(c['batches'])))
+    ranking = []
+    for candidate in candidates:
+        values = np.asarray(candidate['batches'])
+        photons = len(values) * batch_photons
+        difference, difference_se = (0.0, 0.0) if candidate is best else paired(candidate, best)
+        ranking.append({
+            'thicknesses': candidate['thicknesses'],
+            'value': float(values.mean()),
+            'uncertainty': float(values.std(ddof=1) / np.sqrt(len(values))),
+            'difference': difference,
+            'difference_uncertainty': difference_se,
+            'photons': photons,
+            'eliminated': candidate['eliminated'],
+            'result': candidate['sim'].simulator.summarize(candidate['tally'], photons,
+                                                           source_energy_MeV),
+        })
+    ranking.sort(key=lambda r: (r['eliminated'], r['value']))
+    return ranking
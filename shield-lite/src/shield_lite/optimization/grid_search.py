@@ -1,8 +1,18 @@
 # filepath: 
+import heapq
 import numpy as np
 from itertools import product
-from typing import List, Dict, Any
-from shield_lite.core.shield import Shield, Material, Source
+from typing import List, Dict, Any, Optional
+from shield_lite.core.shield import Shield, Layer, Material, Source
+
+# Noyau C++ d'évaluation par lots (optionnel, nécessite la compilation du module)
+try:
+    from shield_lite._monte_carlo import evaluate_shields
+except ImportError:
+    evaluate_shields = None
+
+# Nombre de combinaisons évaluées par appel au noyau C++ (borne la mémoire)
+BATCH_SIZE = 1 << 20
 
 def parse_range(range_str: str) -> np.ndarray:
     """
@@ -31,10 +41,42 @@ def grid_search(
     source: Source,  # <--- Changement ici : Type Source au lieu de float
     Dmax: float,
     area_m2: float = 1.0,
-    topk: int = 5
+    topk: int = 5,
+    vectorized: Optional[bool] = None,
+    num_threads: int = 0,
+    pruned: bool = False,
+    buildup: Optional[Dict[str, Any]] = None,
+    surrogate: Optional[Any] = None,
+    surrogate_options: Optional[Dict[str, Any]] = None
 ) -> List[Dict[str, Any]]:
     """
     Effectue une recherche par grille en utilisant les objets Shield Material et Source.
+
+    Si le module C++ est compilé (ou si vectorized=True), les combinaisons sont
+    évaluées par lots via evaluate_shields (multithreadé, num_threads=0 : tous
+    les cœurs) ; seuls les topk résultats sont reconstruits en objets Shield.
+    vectorized=False force la boucle Python de référence.
+
+    pruned=True active une recherche par séparation et évaluation (branch and
+    bound) : la dose décroît et la masse croît avec chaque épaisseur, donc les
+    sous-arbres infaisables ou plus lourds que le k-ième meilleur candidat sont
+    élagués. Le résultat est identique à la recherche exhaustive.
+
+    buildup={matériau: BuildupTable} remplace la loi de Beer-Lambert par le
+    noyau ponctuel (atténuation non collisionnée × facteur d'accumulation G-P
+    multicouche de Broder à source.energy_MeV, couches dans l'ordre de order).
+    Les matériaux sans table ne font qu'atténuer. Ce pré-tri analytique sert à
+    ne garder que les meilleurs candidats pour une simulation Monte Carlo
+    complète ; il nécessite le noyau C++ (ni pruned ni vectorized=False).
+
+    surrogate=SurrogateModel (shield_lite.core.surrogate) remplace la dose
+    analytique par S × la transmission Monte Carlo prédite par le modèle de
+    substitution ; les combinaisons dont l'incertitude dépasse le seuil, ou
+    hors du domaine d'entraînement, sont simulées (run_batch). Seules les
+    combinaisons plus légères que le k-ième meilleur candidat sont évaluées.
+    surrogate_options est passé à SurrogateModel.estimate (max_uncertainty,
+    num_photons, materials, on_fallback, seed, engine). Les résultats ont en
+    plus les clés "relative_uncertainty" et "fallback".
     """
     
     # 1. Génération des grilles d'épaisseurs pour chaque matériau
@@ -45,6 +87,48 @@ def grid_search(
             raise ValueError(f"Pas de plage définie pour {mat_name}")
         thickness_grids[mat_name] = parse_range(ranges_str[mat_name])
 
+    if surrogate is not None:
+        if buildup is not None or pruned or vectorized is False:
+            raise ValueError("Le modèle de substitution n'est disponible qu'avec la recherche par lots")
+        return _grid_search_surrogate(thickness_grids, materials_db, source, Dmax,
+                                      area_m2, topk, num_threads, surrogate,
+                                      surrogate_options or {})
+
+    if buildup is not None:
+        if pruned or vectorized is False:
+            raise ValueError("Le facteur d'accumulation n'est disponible qu'avec le noyau C++ vectorisé")
+        if evaluate_shields is None:
+            raise ImportError("Le module C++ _monte_carlo n'est pas compilé (evaluate_shields indisponible)")
+        return _grid_search_batched(thickness_grids, materials_db, source, Dmax,
+                                    area_m2, topk, num_threads, buildup)
+
+    if pruned:
+        return _grid_search_pruned(thickness_grids, materials_db, source, Dmax,
+                                   area_m2, topk)
+
+    if vectorized is None:
+        vectorized = evaluate_shields is not None
+    elif vectorized and evaluate_shields is None:
+        raise ImportError("Le module C++ _monte_carlo n'est pas compilé (evaluate_shields indisponible)")
+
+    if vectorized:
+        return _grid_search_batched(thickness_grids, materials_db, source, Dmax,
+                                    area_m2, topk, num_threads)
+
+    return _grid_search_exhaustive(thickness_grids, materials_db, source, Dmax,
+                                   area_m2, topk)
+
+
+def _grid_search_exhaustive(
+    thickness_grids: Dict[str, np.ndarray],
+    materials_db: Dict[str, Material],
+    source: Source,
+    Dmax: float,
+    area_m2: float,
+    topk: int
+) -> List[Dict[str, Any]]:
+    """Boucle Python de référence : évalue chaque combinaison avec un objet Shield."""
+
     # 2. Produit Cartésien (toutes les combinaisons possibles)
     # keys: ['Lead', 'Concrete']
     # values: [(0, 10), (0, 20), (1, 10)...]
@@ -84,4 +168,261 @@ def grid_search(
     # 4. Tri par masse croissante (le plus léger en premier)
     valid_results.sort(key=lambda x: x["mass"])
 
-    return valid_results[:topk]
\ No newline at end of file
+    return valid_results[:topk]
+
+
+def _build_shield(thicknesses: Dict[str, float], materials_db: Dict[str, Material]) -> Shield:
+    shield = Shield()
+    for mat_name, t_mm in thicknesses.items():
+        shield.add_layer(materials_db[mat_name], t_mm)
+    return shield
+
+
+def _grid_search_batched(
+    thickness_grids: Dict[str, np.ndarray],
+    materials_db: Dict[str, Material],
+    source: Source,
+    Dmax: float,
+    area_m2: float,
+    topk: int,
+    num_threads: int,
+    buildup: Optional[Dict[str, Any]] = None
+) -> List[Dict[str, Any]]:
+    """
+    Même recherche que grid_search, évaluée par lots dans le noyau C++.
+    Les combinaisons sont parcourues dans l'ordre de itertools.product, et les
+    égalités de masse sont départagées par cet ordre (comme le tri stable).
+    """
+    keys = list(thickness_grids.keys())
+    for mat_name in keys:
+        if mat_name not in materials_db:
+            raise ValueError(f"Matériau inconnu: {mat_name}")
+
+    grids_mm = [np.asarray(thickness_grids[k], dtype=float) for k in keys]
+    grids_cm = [g / 10.0 for g in grids_mm]
+    mu = np.array([materials_db[k].mu for k in keys], dtype=float)
+    rho = np.array([materials_db[k].density for k in keys], dtype=float)
+    tables = [] if buildup is None else [buildup.get(k) for k in keys]
+    shape = tuple(len(g) for g in grids_mm)
+    total = int(np.prod(shape))
+
+    # Candidats retenus : indice de combinaison, masse, dose
+    best_idx = np.empty(0, dtype=np.int64)
+    best_mass = np.empty(0)
+    best_dose = np.empty(0)
+
+    for start in range(0, total, BATCH_SIZE):
+        idx = np.arange(start, min(start + BATCH_SIZE, total), dtype=np.int64)
+        multi = np.unravel_index(idx, shape)
+        thickness_cm = np.column_stack([g[i] for g, i in zip(grids_cm, multi)])
+
+        dose, mass = evaluate_shields(thickness_cm, mu, rho, source.intensity,
+                                      area_m2, num_threads, tables, source.energy_MeV)
+
+        # Contrainte de dose, puis on ne garde que les topk plus légers
+        ok = dose <= Dmax
+        best_idx = np.concatenate([best_idx, idx[ok]])
+        best_mass = np.concatenate([best_mass, mass[ok]])
+        best_dose = np.concatenate([best_dose, dose[ok]])
+        keep = np.lexsort((best_idx, best_mass))[:max(topk, 0)]
+        best_idx, best_mass, best_dose = best_idx[keep], best_mass[keep], best_dose[keep]
+
+    results = []
+    for i, mass_val, dose_val in zip(best_idx, best_mass, best_dose):
+        multi = np.unravel_index(i, shape)
+        current_thicknesses = {k: g[j] for k, g, j in zip(keys, grids_mm, multi)}
+        results.append({
+            "thicknesses": current_thicknesses,
+            "dose": float(dose_val),
+            "mass": float(mass_val),
+            "shield_obj": _build_shield(current_thicknesses, materials_db)
+        })
+    return results
+
+
+def _grid_search_surrogate(
+    thickness_grids: Dict[str, np.ndarray],
+    materials_db: Dict[str, Material],
+    source: Source,
+    Dmax: float,
+    area_m2: float,
+    topk: int,
+    num_threads: int,
+    surrogate: Any,
+    options: Dict[str, Any]
+) -> List[Dict[str, Any]]:
+    """
+    Recherche par lots dont la dose vient du modèle de substitution (avec
+    repli Monte Carlo). La masse est exacte : elle élimine d'abord les
+    combinaisons qui ne peuvent plus entrer dans les topk, puis seules les
+    restantes sont estimées. Départage des égalités comme _grid_search_batched.
+    """
+    keys = list(thickness_grids.keys())
+    for mat_name in keys:
+        if mat_name not in materials_db:
+            raise ValueError(f"Matériau inconnu: {mat_name}")
+    if topk <= 0:
+        return []
+
+    grids_mm = [np.asarray(thickness_grids[k], dtype=float) for k in keys]
+    grids_cm = [g / 10.0 for g in grids_mm]
+    rho = np.array([materials_db[k].density for k in keys], dtype=float)
+    names = np.array(keys)
+    shape = tuple(len(g) for g in grids_mm)
+    total = int(np.prod(shape))
+
+    best_idx = np.empty(0, dtype=np.int64)
+    best_mass = np.empty(0)
+    best_dose = np.empty(0)
+    best_unc = np.empty(0)
+    best_fallback = np.empty(0, dtype=bool)
+
+    for start in range(0, total, BATCH_SIZE):
+        idx = np.arange(start, min(start + BATCH_SIZE, total), dtype=np.int64)
+        multi = np.unravel_index(idx, shape)
+        thickness_cm = np.column_stack([g[i] for g, i in zip(grids_cm, multi)])
+        # kg = (area_m2 * 1e4 cm^2) * t_cm * rho_g_cm3 / 1000
+        mass = area_m2 * 10.0 * (thickness_cm @ rho)
+
+        # Les indices croissent d'un lot à l'autre : à masse égale, le candidat retenu gagne
+        if len(best_idx) == topk:
+            lighter = mass < best_mass[-1]
+            idx, mass, thickness_cm = idx[lighter], mass[lighter], thickness_cm[lighter]
+        if len(idx) == 0:
+            continue
+
+        estimate = surrogate.estimate(
+            source.energy_MeV, np.arange(0, thickness_cm.size + 1, len(keys)),
+            np.tile(names, len(idx)), thickness_cm.ravel(), num_threads=num_threads, **options)
+        dose = source.intensity * estimate['transmission']
+
+        ok = dose <= Dmax
+        best_idx = np.concatenate([best_idx, idx[ok]])
+        best_mass = np.concatenate([best_mass, mass[ok]])
+        best_dose = np.concatenate([best_dose, dose[ok]])
+        best_unc = np.concatenate([best_unc, estimate['relative_uncertainty'][ok]])
+        best_fallback = np.concatenate([best_fallback, estimate['fallback'][ok]])
+        keep = np.lexsort((best_idx, best_mass))[:topk]
+        best_idx, best_mass, best_dose = best_idx[keep], best_mass[keep], best_dose[keep]
+        best_unc, best_fallback = best_unc[keep], best_fallback[keep]
+
+    results = []
+    for i, mass_val, dose_val, unc, fallback in zip(best_idx, best_mass, best_dose,
+                                                     best_unc, best_fallback):
+        multi = np.unravel_index(i, shape)
+        current_thicknesses = {k: g[j] for k, g, j in zip(keys, grids_mm, multi)}
+        results.append({
+            "thicknesses": current_thicknesses,
+            "dose": float(dose_val),
+            "mass": float(mass_val),
+            "relative_uncertainty": float(unc),
+            "fallback": bool(fallback),
+            "shield_obj": _build_shield(current_thicknesses, materials_db)
+        })
+    return results
+
+
+def _grid_search_pruned(
+    thickness_grids: Dict[str, np.ndarray],
+    materials_db: Dict[str, Material],
+    source: Source,
+    Dmax: float,
+    area_m2: float,
+    topk: int
+) -> List[Dict[str, Any]]:
+    """
+    Recherche par séparation et évaluation, équivalente à la recherche exhaustive.
+
+    Parcours en profondeur, matériau par matériau, épaisseurs croissantes :
+    - borne de faisabilité : avec les épaisseurs maximales pour les matériaux
+      restants, la dose doit pouvoir passer sous Dmax ;
+    - borne de masse : avec les épaisseurs minimales restantes, la masse doit
+      rester sous celle du k-ième meilleur candidat (tas borné de taille topk).
+    Les transmissions et masses par couche sont calculées comme dans Layer et
+    cumulées dans le même ordre que Shield, pour des valeurs identiques.
+    """
+    keys = list(thickness_grids.keys())
+    for mat_name in keys:
+        if mat_name not in materials_db:
+            raise ValueError(f"Matériau inconnu: {mat_name}")
+    if topk <= 0:
+        return []
+
+    materials = [materials_db[k] for k in keys]
+    if not keys or any(m.mu < 0 or m.density < 0 for m in materials):
+        # Pas de monotonie garantie : on retombe sur la recherche exhaustive
+        return _grid_search_exhaustive(thickness_grids, materials_db, source,
+                                       Dmax, area_m2, topk)
+
+    grids = [list(thickness_grids[k]) for k in keys]
+    n_axes = len(grids)
+
+    # Position de chaque épaisseur dans l'ordre de itertools.product (départage des égalités)
+    strides = [1] * n_axes
+    for d in range(n_axes - 2, -1, -1):
+        strides[d] = strides[d + 1] * len(grids[d + 1])
+
+    # Par axe : (épaisseur, transmission, masse, position), épaisseurs croissantes
+    axes = []
+    for d, (grid, mat) in enumerate(zip(grids, materials)):
+        entries = []
+        for pos, t_mm in enumerate(grid):
+            layer = Layer(mat, t_mm)
+            entries.append((t_mm, layer.transmission(), layer.mass(area_m2), pos * strides[d]))
+        entries.sort(key=lambda e: (e[0], e[3]))
+        axes.append(entries)
+    if any(not entries for entries in axes):
+        return []
+
+    # Bornes sur les axes restants : transmission minimale, masse minimale
+    suffix_min_trans = [1.0] * (n_axes + 1)
+    suffix_min_mass = [0.0] * (n_axes + 1)
+    for d in range(n_axes - 1, -1, -1):
+        suffix_min_trans[d] = suffix_min_trans[d + 1] * min(e[1] for e in axes[d])
+        suffix_min_mass[d] = suffix_min_mass[d + 1] + min(e[2] for e in axes[d])
+
+    # Tolérance relative sur les bornes (arrondis flottants)
+    eps = 1e-9
+    S = source.intensity
+    heap = []  # (-masse, -indice, épaisseurs, dose) : le pire candidat en tête
+    chosen = [None] * n_axes
+
+    def search(d, trans, mass, index):
+        for t_mm, layer_trans, layer_mass, offset in axes[d]:
+            cur_trans = trans * layer_trans
+            cur_mass = mass + layer_mass
+            cur_index = index + offset
+
+            # Masse croissante le long de l'axe : tout le reste est plus lourd
+            if len(heap) == topk and cur_mass + suffix_min_mass[d + 1] > -heap[0][0] * (1 + eps) + eps:
+                break
+            # Même avec les épaisseurs maximales restantes, la dose reste trop haute
+            if S * cur_trans * suffix_min_trans[d + 1] > Dmax * (1 + eps):
+                continue
+
+            chosen[d] = t_mm
+            if d + 1 < n_axes:
+                search(d + 1, cur_trans, cur_mass, cur_index)
+                continue
+
+            dose_val = S * cur_trans
+            if dose_val > Dmax:
+                continue
+            entry = (-cur_mass, -cur_index, tuple(chosen), dose_val)
+            if len(heap) < topk:
+                heapq.heappush(heap, entry)
+            elif entry > heap[0]:
+                heapq.heapreplace(heap, entry)
+
+    search(0, 1.0, 0, 0)
+
+    results = []
+    for neg_mass, _, values, dose_val in sorted(heap, reverse=True):
+        current_thicknesses = dict(zip(keys, values))
+        results.append({
+            "thicknesses": current_thicknesses,
+            "dose": dose_val,
+            "mass": -neg_mass,
+            "shield_obj": _build_shield(current_thicknesses, materials_db)
+        })
+    return results
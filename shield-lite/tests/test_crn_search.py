@@ -0,0 +1,54 @@
+import numpy as np
+import pytest
+
+try:
+    from shield_lite.optimization.crn_search import rank_designs
+    from shield_lite.core import MonteCarloShieldSimulator
+    MONTE_CARLO_AVAILABLE = True
+except ImportError:
+    MONTE_CARLO_AVAILABLE = False
+
+MATERIALS = {
+    'Lead': {'mu_total': 0.77, 'mu_compton': 0.58, 'mu_photoelectric': 0.19,
+             'density_g_cm3': 11.34},
+    'Water': {'mu_total': 0.07, 'mu_compton': 0.06, 'mu_photoelectric': 0.001,
+              'density_g_cm3': 1.0},
+}
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_rank_designs_orders_by_dose():
+    designs = [{'Lead': 1.0, 'Water': 5.0}, {'Lead': 3.0, 'Water': 5.0},
+               {'Lead': 2.0, 'Water': 5.0}]
+    ranking = rank_designs(designs, MATERIALS, 1.0, batch_photons=2000,
+                           initial_batches=4, max_batches=16)
+
+    assert [r['thicknesses']['Lead'] for r in ranking] == [3.0, 2.0, 1.0]
+    assert ranking[0]['difference'] == 0.0
+    # Clearly worse designs are dropped after the first round of batches
+    assert all(r['eliminated'] and r['photons'] == 8000 for r in ranking[1:])
+    assert ranking[0]['result'].total_photons == ranking[0]['photons']
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_common_random_numbers_reduce_difference_noise():
+    designs = [{'Lead': 2.0}, {'Lead': 2.05}]
+    ranking = rank_designs(designs, MATERIALS, 1.0, batch_photons=5000,
+                           initial_batches=8, max_batches=8)
+
+    # The paired difference is much less noisy than either dose
+    second = ranking[1]
+    assert second['difference'] > 0
+    assert second['difference_uncertainty'] < 0.5 * second['uncertainty']
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_rank_designs_invalid_objective():
+    with pytest.raises(ValueError):
+        rank_designs([{'Lead': 1.0}], MATERIALS, 1.0, objective='mass')
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_rank_designs_without_designs_raises_error():
+    with pytest.raises(ValueError, match="Aucun design"):
+        rank_designs([], MATERIALS, 1.0)
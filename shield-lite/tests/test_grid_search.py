@@ -20,4 +20,124 @@ def test_grid_search():
     assert isinstance(result, dict)
     assert 'thicknesses' in result
     assert 'dose' in result
-    assert len(result['thicknesses']) <= topk
\ No newline at end of file
+    assert len(result['thicknesses']) <= topk
+
+try:
+    from shield_lite._monte_carlo import evaluate_shields
+    KERNEL_AVAILABLE = True
+except ImportError:
+    KERNEL_AVAILABLE = False
+
+
+@pytest.mark.skipif(not KERNEL_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_batched_grid_search_matches_reference():
+    from shield_lite.core.shield import Material, Source
+
+    materials_db = {
+        'Lead': Material(name='Lead', mu=0.77, density=11.34),
+        'Concrete': Material(name='Concrete', mu=0.16, density=2.3),
+        'Water': Material(name='Water', mu=0.07, density=1.0),
+    }
+    order = ['Lead', 'Concrete', 'Water']
+    ranges_mm = {'Lead': '0..50..5', 'Concrete': '0..200..20', 'Water': '0..100..25'}
+    source = Source(intensity=100.0)
+
+    reference = grid_search(order, ranges_mm, materials_db, source, Dmax=1.0,
+                            topk=5, vectorized=False)
+    batched = grid_search(order, ranges_mm, materials_db, source, Dmax=1.0,
+                          topk=5, vectorized=True)
+
+    assert len(batched) == len(reference)
+    for ref, res in zip(reference, batched):
+        assert res['thicknesses'] == ref['thicknesses']
+        assert res['mass'] == pytest.approx(ref['mass'])
+        assert res['dose'] == pytest.approx(ref['dose'])
+
+
+@pytest.mark.skipif(not KERNEL_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_evaluate_shields_kernel():
+    import numpy as np
+
+    thickness_cm = np.array([[1.0, 2.0], [0.0, 0.0], [3.0, 0.5]])
+    mu = np.array([0.77, 0.16])
+    rho = np.array([11.34, 2.3])
+
+    dose, mass = evaluate_shields(thickness_cm, mu, rho, source_intensity=10.0, area_m2=2.0)
+
+    np.testing.assert_allclose(dose, 10.0 * np.exp(-thickness_cm @ mu))
+    np.testing.assert_allclose(mass, 2.0 * 1e4 * (thickness_cm @ rho) / 1000.0)
+
+
+@pytest.mark.skipif(not KERNEL_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_evaluate_shields_point_kernel():
+    import numpy as np
+    from shield_lite._monte_carlo import BuildupTable
+
+    # c = 1, a = d = 0 gives K = 1, i.e. the linear buildup B(x) = 1 + (b - 1) x
+    linear = BuildupTable([0.5, 2.0], b=[3.0, 3.0], c=[1.0, 1.0], a=[0.0, 0.0],
+                          xk=[14.0, 14.0], d=[0.0, 0.0])
+    assert linear.buildup(1.0, 2.0) == pytest.approx(5.0)
+
+    thickness_cm = np.array([[1.0, 2.0], [0.0, 3.0], [2.5, 0.0]])
+    mu = np.array([0.77, 0.16])
+    rho = np.array([11.34, 2.3])
+    dose, _ = evaluate_shields(thickness_cm, mu, rho, source_intensity=10.0,
+                               buildup=[linear, None], energy_MeV=1.0)
+
+    # Broder: only the first layer builds up, B = 1 + (b - 1) mu_1 t_1
+    expected = 10.0 * np.exp(-thickness_cm @ mu) * (1.0 + 2.0 * mu[0] * thickness_cm[:, 0])
+    np.testing.assert_allclose(dose, expected, rtol=1e-12)
+
+    with pytest.raises(ValueError):
+        evaluate_shields(thickness_cm, mu, rho, buildup=[linear])
+
+
+@pytest.mark.skipif(not KERNEL_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_grid_search_with_buildup():
+    from shield_lite._monte_carlo import BuildupTable
+    from shield_lite.core.shield import Material, Source
+
+    materials_db = {
+        'Lead': Material(name='Lead', mu=0.77, density=11.34),
+        'Water': Material(name='Water', mu=0.07, density=1.0),
+    }
+    order = ['Lead', 'Water']
+    ranges_mm = {'Lead': '0..60..5', 'Water': '0..200..25'}
+    source = Source(intensity=100.0, energy_MeV=1.0)
+    lead = BuildupTable([1.0], b=[1.4], c=[0.9], a=[0.05], xk=[14.0], d=[-0.02])
+
+    plain = grid_search(order, ranges_mm, materials_db, source, Dmax=1.0, topk=3,
+                        vectorized=True)
+    screened = grid_search(order, ranges_mm, materials_db, source, Dmax=1.0, topk=3,
+                           buildup={'Lead': lead})
+
+    # Buildup raises the dose, so the feasible designs get heavier
+    assert screened and screened[0]['mass'] >= plain[0]['mass']
+    for res in screened:
+        assert res['dose'] > res['shield_obj'].calculate_dose(source)
+    with pytest.raises(ValueError):
+        grid_search(order, ranges_mm, materials_db, source, Dmax=1.0, pruned=True,
+                    buildup={'Lead': lead})
+
+
+def test_pruned_grid_search_matches_exhaustive():
+    from shield_lite.core.shield import Material, Source
+
+    materials_db = {
+        'Lead': Material(name='Lead', mu=0.77, density=11.34),
+        'Steel': Material(name='Steel', mu=0.47, density=7.85),
+        'Water': Material(name='Water', mu=0.07, density=1.0),
+    }
+    order = ['Lead', 'Steel', 'Water']
+    ranges_mm = {'Lead': '0..60..5', 'Steel': '0,80,9', 'Water': '0..200..25'}
+    source = Source(intensity=1000.0)
+
+    for topk in [1, 5, 20]:
+        exhaustive = grid_search(order, ranges_mm, materials_db, source, Dmax=2.0,
+                                 topk=topk, vectorized=False)
+        pruned = grid_search(order, ranges_mm, materials_db, source, Dmax=2.0,
+                             topk=topk, pruned=True)
+
+        assert [r['thicknesses'] for r in pruned] == [r['thicknesses'] for r in exhaustive]
+        assert [r['mass'] for r in pruned] == [r['mass'] for r in exhaustive]
+        assert [r['dose'] for r in pruned] == [r['dose'] for r in exhaustive]
@@ -6,12 +6,30 @@ import pytest
 import numpy as np
 
 try:
-    from shield_lite.core import MonteCarloShieldSimulator, estimate_required_photons
+    from shield_lite.core import (
+        MonteCarloShieldSimulator, VarianceReduction, estimate_required_photons
+    )
     MONTE_CARLO_AVAILABLE = True
 except ImportError:
     MONTE_CARLO_AVAILABLE = False
 
 
+# Attenuation coefficients (total, Compton, photoelectric in cm^-1) at the source energy
+LEAD_WATER_COEFFICIENTS = {
+    1.0: ((0.77, 0.58, 0.19), (0.07, 0.06, 0.001)),
+    2.0: ((0.52, 0.40, 0.12), (0.05, 0.049, 0.001)),
+}
+
+
+def lead_water_simulator(seed, rng="mt19937", energy_MeV=1.0):
+    """2 cm of lead backed by 5 cm of water, the shield shared by the run-management tests."""
+    lead, water = LEAD_WATER_COEFFICIENTS[energy_MeV]
+    sim = MonteCarloShieldSimulator(seed=seed, rng=rng)
+    sim.add_layer("Lead", 2.0, *lead, 11.34)
+    sim.add_layer("Water", 5.0, *water, 1.0)
+    return sim
+
+
 @pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
 class TestMonteCarloSimulator:
     """Test suite for Monte Carlo simulator."""
@@ -108,6 +126,429 @@ class TestMonteCarloSimulator:
         assert result1.transmission_factor == result2.transmission_factor
         assert result1.transmitted_photons == result2.transmitted_photons
 
+    def test_parallel_reproducibility(self):
+        """Test that multithreaded runs are reproducible for a given thread count."""
+        results = []
+        for _ in range(2):
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+            results.append(sim.run(source_energy_MeV=1.0, num_photons=20000, num_threads=4))
+
+        assert results[0].transmitted_photons == results[1].transmitted_photons
+        assert results[0].dose_transmitted == results[1].dose_transmitted
+        assert results[0].total_photons == 20000
+
+    def test_parallel_independent_of_thread_count(self):
+        """Test that chunked runs give bit-identical results for any thread count."""
+        results = []
+        for num_threads in [1, 3, 4]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+            results.append(sim.run(source_energy_MeV=1.0, num_photons=40000, num_threads=num_threads))
+
+        for result in results[1:]:
+            assert result.dose_transmitted == results[0].dose_transmitted
+            assert result.dose_absorbed == results[0].dose_absorbed
+            assert result.collisions == results[0].collisions
+        assert results[0].collisions > 0
+
+    def test_parallel_matches_serial_statistically(self):
+        """Test that the parallel engine agrees with the serial one within noise."""
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Lead", 2.0, 0.77, 0.58, 0.19, 11.34)
+
+        serial = sim.run(source_energy_MeV=1.0, num_photons=50000)
+        parallel = sim.run(source_energy_MeV=1.0, num_photons=50000, num_threads=4)
+
+        sigma = np.sqrt(serial.transmission_factor * (1 - serial.transmission_factor) / 50000)
+        assert abs(serial.transmission_factor - parallel.transmission_factor) < 5 * sigma * np.sqrt(2)
+
+    def test_batched_engine_matches_scalar(self):
+        """Test that the batched SIMD engine is statistically equivalent to the scalar one."""
+        n = 100000
+        results = {}
+        for engine in ["scalar", "batched"]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+            sim.add_layer("Concrete", 10.0, 0.16, 0.12, 0.04, 2.3)
+            results[engine] = sim.run(source_energy_MeV=1.0, num_photons=n, engine=engine)
+
+        t = results["scalar"].transmission_factor
+        sigma = np.sqrt(t * (1 - t) / n)
+        assert results["batched"].total_photons == n
+        assert abs(results["batched"].transmission_factor - t) < 5 * sigma * np.sqrt(2)
+
+    @pytest.mark.parametrize("engine", ["scalar", "batched"])
+    def test_philox_matches_mt19937(self, engine):
+        """Test that the counter-based generator is statistically equivalent to mt19937."""
+        n = 100000
+        results = {}
+        for rng in ["mt19937", "philox"]:
+            sim = MonteCarloShieldSimulator(seed=42, rng=rng)
+            sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+            sim.add_layer("Concrete", 10.0, 0.16, 0.12, 0.04, 2.3)
+            results[rng] = sim.run(source_energy_MeV=1.0, num_photons=n, engine=engine)
+
+        sigma = np.hypot(results["mt19937"].transmission_uncertainty,
+                         results["philox"].transmission_uncertainty)
+        diff = results["philox"].transmission_factor - results["mt19937"].transmission_factor
+        assert abs(diff) < 5 * sigma
+
+    def test_philox_independent_of_thread_count(self):
+        """Test that Philox runs are bit-identical for any thread count."""
+        results = []
+        for num_threads in [1, 4]:
+            sim = MonteCarloShieldSimulator(seed=7, rng="philox")
+            sim.add_layer("Steel", 4.0, 0.47, 0.35, 0.12, 7.85)
+            results.append(sim.run(source_energy_MeV=1.0, num_photons=30000,
+                                   num_threads=num_threads, engine="batched"))
+
+        assert results[0].dose_transmitted == results[1].dose_transmitted
+
+    def test_unknown_rng_raises_error(self):
+        """Test that an unknown generator name is rejected."""
+        with pytest.raises(ValueError):
+            MonteCarloShieldSimulator(rng="xorshift")
+
+    @pytest.mark.parametrize("engine", ["scalar", "batched"])
+    def test_klein_nishina_forward_peaking(self, engine):
+        """Test that Compton scattering gets forward-peaked as the energy rises."""
+        transmission = {}
+        for energy in [0.05, 6.0]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            # Pure scatterer with energy-independent mu: only the angular
+            # distribution differs between the two energies
+            sim.add_layer("Scatterer", 5.0, 0.2, 0.2, 0.0, 1.0)
+            transmission[energy] = sim.run(source_energy_MeV=energy, num_photons=20000,
+                                           engine=engine).transmission_factor
+
+        assert 0.52 < transmission[0.05] < 0.62
+        assert transmission[6.0] > transmission[0.05] + 0.1
+
+    def test_klein_nishina_beyond_table_matches_engines(self):
+        """Test that the Kahn fallback above the table range agrees between engines."""
+        results = {}
+        for engine in ["scalar", "batched"]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Water", 100.0, 0.05, 0.05, 0.0, 1.0)
+            results[engine] = sim.run(source_energy_MeV=2000.0, num_photons=50000, engine=engine)
+
+        sigma = np.hypot(results["scalar"].transmission_uncertainty,
+                         results["batched"].transmission_uncertainty)
+        diff = results["batched"].transmission_factor - results["scalar"].transmission_factor
+        assert abs(diff) < 5 * sigma
+
+    def test_unknown_engine_raises_error(self):
+        """Test that an unknown engine name is rejected."""
+        sim = MonteCarloShieldSimulator()
+        sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+
+        with pytest.raises(ValueError):
+            sim.run(source_energy_MeV=1.0, num_photons=1000, engine="gpu")
+
+    @pytest.mark.parametrize("engine", ["scalar", "batched"])
+    def test_variance_reduction_is_unbiased(self, engine):
+        """Test that implicit capture with roulette agrees with analog transport."""
+        n = 100000
+        vr = VarianceReduction(implicit_capture=True, roulette_weight=0.25, survival_weight=0.5)
+        results = []
+        for variance_reduction in [None, vr]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Lead", 5.0, 0.77, 0.58, 0.19, 11.34)
+            results.append(sim.run(source_energy_MeV=1.0, num_photons=n, engine=engine,
+                                   variance_reduction=variance_reduction))
+
+        analog, biased = results
+        sigma = np.hypot(analog.transmission_uncertainty, biased.transmission_uncertainty)
+        assert abs(analog.transmission_factor - biased.transmission_factor) < 5 * sigma
+        assert biased.transmission_uncertainty < analog.transmission_uncertainty
+        assert biased.figure_of_merit > 0
+
+    def test_splitting_is_unbiased(self):
+        """Test that splitting (scalar engine) keeps the transmission estimate."""
+        n = 50000
+        results = []
+        for split_weight in [0.0, 0.5]:
+            vr = VarianceReduction(implicit_capture=True, roulette_weight=0.2,
+                                   split_weight=split_weight)
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Lead", 5.0, 0.77, 0.58, 0.19, 11.34)
+            results.append(sim.run(source_energy_MeV=1.0, num_photons=n, variance_reduction=vr))
+
+        sigma = np.hypot(results[0].transmission_uncertainty, results[1].transmission_uncertainty)
+        assert abs(results[0].transmission_factor - results[1].transmission_factor) < 5 * sigma
+
+    @pytest.mark.parametrize("engine", ["scalar", "batched"])
+    def test_exponential_transform_is_unbiased(self, engine):
+        """Test that the exponential transform agrees with analog transport."""
+        n = 100000
+        results = []
+        for vr in [None, VarianceReduction(implicit_capture=True, auto_stretch=True)]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Concrete", 30.0, 0.16, 0.12, 0.04, 2.3)
+            results.append(sim.run(source_energy_MeV=1.0, num_photons=n, engine=engine,
+                                   variance_reduction=vr))
+
+        analog, stretched = results
+        sigma = np.hypot(analog.transmission_uncertainty, stretched.transmission_uncertainty)
+        assert abs(analog.transmission_factor - stretched.transmission_factor) < 5 * sigma
+        assert stretched.relative_uncertainty < analog.relative_uncertainty
+
+    def test_exponential_transform_deep_shield(self):
+        """Test that a 1.2 m concrete shield gets a usable estimate."""
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Concrete", 120.0, 0.16, 0.12, 0.04, 2.3)
+        vr = VarianceReduction(implicit_capture=True, auto_stretch=True)
+        result = sim.run(source_energy_MeV=1.0, num_photons=50000, engine="batched",
+                         variance_reduction=vr)
+
+        assert result.transmission_factor > 0
+        assert result.relative_uncertainty < 0.5
+
+    @pytest.mark.parametrize("engine", ["scalar", "batched"])
+    def test_laminated_slab_matches_single_slab(self, engine):
+        """Test that splitting a slab into thin layers does not change transport."""
+        n = 100000
+        single = MonteCarloShieldSimulator(seed=42)
+        single.add_layer("Steel", 4.0, 0.47, 0.35, 0.12, 7.85)
+        laminated = MonteCarloShieldSimulator(seed=7)
+        for _ in range(40):
+            laminated.add_layer("Steel", 0.1, 0.47, 0.35, 0.12, 7.85)
+
+        a = single.run(source_energy_MeV=1.0, num_photons=n, engine=engine)
+        b = laminated.run(source_energy_MeV=1.0, num_photons=n, engine=engine)
+        sigma = np.hypot(a.transmission_uncertainty, b.transmission_uncertainty)
+        assert abs(a.transmission_factor - b.transmission_factor) < 5 * sigma
+
+    def test_batched_laminate_with_stretch_matches_scalar(self):
+        """Test that crossing boundaries in the batched kernel keeps the transform weights."""
+        n = 100000
+        vr = VarianceReduction(implicit_capture=True, stretch=[0.4] * 6)
+        results = {}
+        for engine in ["scalar", "batched"]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            for _ in range(3):
+                sim.add_layer("Lead", 0.5, 0.77, 0.58, 0.19, 11.34)
+                sim.add_layer("Polyethylene", 2.0, 0.0665, 0.0665, 0.0, 0.94)
+            results[engine] = sim.run(source_energy_MeV=1.0, num_photons=n, engine=engine,
+                                      variance_reduction=vr)
+
+        sigma = np.hypot(results["scalar"].transmission_uncertainty,
+                         results["batched"].transmission_uncertainty)
+        diff = results["batched"].transmission_factor - results["scalar"].transmission_factor
+        assert abs(diff) < 5 * sigma
+
+    def test_invalid_variance_reduction_raises_error(self):
+        """Test that inconsistent weight thresholds and batched splitting are rejected."""
+        sim = MonteCarloShieldSimulator()
+        sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+
+        with pytest.raises(ValueError):
+            sim.run(1.0, 1000, variance_reduction=VarianceReduction(roulette_weight=0.6))
+        with pytest.raises(ValueError):
+            sim.run(1.0, 1000, engine="batched",
+                    variance_reduction=VarianceReduction(split_weight=2.0))
+        with pytest.raises(ValueError):
+            sim.run(1.0, 1000, variance_reduction=VarianceReduction(stretch=[0.5, 0.5]))
+        with pytest.raises(ValueError):
+            sim.run(1.0, 1000, variance_reduction=VarianceReduction(stretch=[1.0]))
+
+    def test_run_until_reaches_target(self):
+        """Test that adaptive stopping meets the target uncertainty."""
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+
+        result = sim.run_until(source_energy_MeV=1.0, target_relative_uncertainty=0.02,
+                               batch_photons=5000)
+
+        assert result.converged
+        assert result.relative_uncertainty <= 0.02
+        assert 5000 <= result.total_photons < 10_000_000
+
+    def test_run_until_respects_photon_budget(self):
+        """Test that adaptive stopping stops at the photon budget."""
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Lead", 20.0, 0.77, 0.58, 0.19, 11.34)
+
+        result = sim.run_until(source_energy_MeV=1.0, target_relative_uncertainty=0.001,
+                               max_photons=30000, batch_photons=5000, num_threads=2)
+
+        assert not result.converged
+        assert result.total_photons == 30000
+
+    def test_flat_cross_section_table_matches_constant(self):
+        """Test that an energy-independent table reproduces the constant coefficients."""
+        results = []
+        for tabulated in [False, True]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+            if tabulated:
+                sim.set_cross_sections("Lead", [0.01, 10.0], [0.77, 0.77],
+                                       [0.58, 0.58], [0.19, 0.19])
+            results.append(sim.run(source_energy_MeV=1.0, num_photons=20000))
+
+        assert results[0].transmission_factor == results[1].transmission_factor
+        assert results[0].dose_transmitted == results[1].dose_transmitted
+
+    def test_energy_dependent_cross_sections(self):
+        """Test that downscattered photons see the larger low-energy coefficients."""
+        energy = [0.01, 0.05, 0.1, 0.2, 0.5, 1.0, 2.0, 5.0]
+        mu_total = [1500.0, 90.0, 60.0, 10.7, 1.64, 0.77, 0.52, 0.48]
+        mu_compton = [0.5, 1.0, 1.2, 1.1, 0.86, 0.58, 0.42, 0.25]
+        mu_photo = [t - c for t, c in zip(mu_total, mu_compton)]
+
+        results = []
+        for tabulated in [False, True]:
+            sim = MonteCarloShieldSimulator(seed=42)
+            sim.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+            if tabulated:
+                sim.set_cross_sections("Lead", energy, mu_total, mu_compton, mu_photo)
+            results.append(sim.run(source_energy_MeV=1.0, num_photons=50000))
+
+        constant, tabulated = results
+        assert tabulated.transmission_factor < constant.transmission_factor
+        assert tabulated.buildup_factor >= 1.0
+
+    def test_invalid_cross_section_table_raises_error(self):
+        """Test that malformed tables are rejected."""
+        sim = MonteCarloShieldSimulator()
+        with pytest.raises(ValueError):
+            sim.set_cross_sections("Lead", [1.0, 0.5], [0.7, 0.8], [0.5, 0.5], [0.2, 0.3])
+        with pytest.raises(ValueError):
+            sim.set_cross_sections("Lead", [0.5, 1.0], [0.7], [0.5, 0.5], [0.2, 0.3])
+
+    def test_run_batch_matches_single_runs(self):
+        """Test that run_batch gives one structured row per configuration."""
+        materials = [
+            {"material_name": "Lead", "mu_total": 0.77, "mu_compton": 0.58,
+             "mu_photoelectric": 0.19, "density_g_cm3": 11.34},
+            {"material_name": "Concrete", "mu_total": 0.16, "mu_compton": 0.12,
+             "mu_photoelectric": 0.04, "density_g_cm3": 2.3},
+        ]
+        sim = MonteCarloShieldSimulator(seed=42)
+        results = sim.run_batch(
+            layer_offsets=[0, 1, 3],
+            material_ids=[0, 0, 1],
+            thickness_cm=[3.0, 2.0, 10.0],
+            energy_MeV=[1.0, 1.0],
+            num_photons=50000,
+            materials=materials,
+        )
+
+        assert results.shape == (2,)
+        assert "transmission_factor" in results.dtype.names
+        assert list(results["total_photons"]) == [50000, 50000]
+
+        single = MonteCarloShieldSimulator(seed=1)
+        single.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+        reference = single.run(source_energy_MeV=1.0, num_photons=50000)
+        sigma = np.hypot(reference.transmission_uncertainty, results[0]["transmission_uncertainty"])
+        assert abs(results[0]["transmission_factor"] - reference.transmission_factor) < 5 * sigma
+
+    def test_run_batch_independent_of_thread_count(self):
+        """Test that run_batch results depend only on the seed and configuration."""
+        materials = [{"material_name": "Steel", "mu_total": 0.47, "mu_compton": 0.35,
+                      "mu_photoelectric": 0.12, "density_g_cm3": 7.85}]
+        args = dict(layer_offsets=[0, 1, 2, 3, 4], material_ids=[0, 0, 0, 0],
+                    thickness_cm=[1.0, 2.0, 3.0, 4.0], energy_MeV=1.0,
+                    num_photons=[5000, 30000, 2000, 20000], materials=materials)
+
+        serial = MonteCarloShieldSimulator(seed=42).run_batch(num_threads=1, **args)
+        parallel = MonteCarloShieldSimulator(seed=42).run_batch(num_threads=4, **args)
+
+        np.testing.assert_array_equal(serial["transmission_factor"], parallel["transmission_factor"])
+        np.testing.assert_array_equal(serial["dose_absorbed"], parallel["dose_absorbed"])
+
+    def test_run_batch_accepts_material_columns(self):
+        """Test that materials given as arrays match the list of dicts."""
+        materials = [
+            {"material_name": "Lead", "mu_total": 0.77, "mu_compton": 0.58,
+             "mu_photoelectric": 0.19, "density_g_cm3": 11.34},
+            {"material_name": "Concrete", "mu_total": 0.16, "mu_compton": 0.12,
+             "mu_photoelectric": 0.04, "density_g_cm3": 2.3},
+        ]
+        columns = {key: np.array([m[key] for m in materials]) for key in materials[0]}
+        columns["material_name"] = ["Lead", "Concrete"]
+        args = dict(layer_offsets=[0, 1, 3], material_ids=[0, 0, 1],
+                    thickness_cm=[3.0, 2.0, 10.0], energy_MeV=1.0, num_photons=5000)
+
+        rows = MonteCarloShieldSimulator(seed=42).run_batch(materials=materials, **args)
+        arrays = MonteCarloShieldSimulator(seed=42).run_batch(materials=columns, **args)
+
+        np.testing.assert_array_equal(rows, arrays)
+
+    def test_run_batch_invalid_material_raises_error(self):
+        """Test that out-of-range material ids are rejected."""
+        materials = [{"material_name": "Lead", "mu_total": 0.77, "mu_compton": 0.58,
+                      "mu_photoelectric": 0.19, "density_g_cm3": 11.34}]
+        sim = MonteCarloShieldSimulator()
+        with pytest.raises(ValueError):
+            sim.run_batch([0, 1], [3], [1.0], 1.0, 1000, materials=materials)
+
+    @pytest.mark.parametrize("engine", ["scalar", "batched"])
+    def test_mesh_tallies_sum_to_totals(self, engine):
+        """Test that the depth-dose and spectrum histograms add up to the scalar results."""
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Lead", 2.0, 0.77, 0.58, 0.19, 11.34)
+        sim.add_layer("Steel", 3.0, 0.47, 0.35, 0.12, 7.85)
+
+        result = sim.run(source_energy_MeV=1.25, num_photons=50000, num_threads=2,
+                         engine=engine, depth_bins=25, spectrum_bins=40)
+
+        assert result.depth_dose.shape == (25,)
+        assert result.spectrum.shape == (40,)
+        np.testing.assert_allclose(result.depth_bin_edges[[0, -1]], [0.0, 5.0])
+        np.testing.assert_allclose(result.spectrum_bin_edges[[0, -1]], [0.0, 1.25])
+        assert result.depth_dose.sum() == pytest.approx(result.dose_absorbed, rel=1e-12)
+        assert result.spectrum.sum() == pytest.approx(result.transmission_factor, rel=1e-12)
+        # Uncollided photons land in the top energy bin
+        assert result.spectrum[-1] == result.spectrum.max()
+        # Views into the result, not copies
+        assert not result.depth_dose.flags.owndata
+        assert not result.spectrum.flags.writeable
+
+    def test_mesh_tallies_off_by_default(self):
+        """Test that no histograms are filled unless bins are requested."""
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Lead", 2.0, 0.77, 0.58, 0.19, 11.34)
+
+        result = sim.run(source_energy_MeV=1.0, num_photons=1000)
+
+        assert result.depth_dose.size == 0
+        assert result.spectrum.size == 0
+        with pytest.raises(ValueError):
+            sim.run(source_energy_MeV=1.0, num_photons=1000, depth_bins=-1)
+
+    @pytest.mark.parametrize("engine", ["scalar", "batched"])
+    def test_transport_stats_consistent(self, engine):
+        """Test that the instrumentation counters add up, or stay zero when compiled out."""
+        from shield_lite._monte_carlo import INSTRUMENTED
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Lead", 1.0, 0.77, 0.58, 0.19, 11.34)
+        sim.add_layer("Steel", 2.0, 0.47, 0.35, 0.12, 7.85)
+
+        result = sim.run(source_energy_MeV=1.0, num_photons=20000, engine=engine)
+        stats = result.stats
+
+        if INSTRUMENTED:
+            assert stats.compton + stats.photoelectric == result.collisions
+            assert stats.flights == result.collisions + stats.boundary_crossings
+            assert sum(stats.collisions_by_energy) == result.collisions
+            assert stats.phase_seconds["flight"] > 0
+        else:
+            assert stats.flights == 0
+            assert sum(stats.collisions_by_energy) == 0
+
+    def test_compton_electrons_deposit_energy(self):
+        """Test that a pure scatterer absorbs the recoil electron energy."""
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Scatterer", 5.0, 0.2, 0.2, 0.0, 1.0)
+
+        result = sim.run(source_energy_MeV=1.0, num_photons=20000)
+
+        assert result.dose_absorbed > 0.05
+        assert result.dose_transmitted + result.dose_absorbed <= 1.0
+
     def test_buildup_factor_greater_than_one(self):
         """Test that buildup factor is >= 1 (due to scattering)."""
         sim = MonteCarloShieldSimulator(seed=42)
@@ -145,6 +586,37 @@ class TestMonteCarloSimulator:
         assert sim.get_total_thickness() == 5.0
         assert len(sim.get_shield_info()) == 2
 
+    def test_add_layers_matches_add_layer(self):
+        """Test that column arrays build the same shield as add_layer calls."""
+        single = MonteCarloShieldSimulator(seed=42)
+        single.add_layer("Lead", 3.0, 0.77, 0.58, 0.19, 11.34)
+        single.add_layer("Steel", 2.0, 0.47, 0.35, 0.12, 7.85)
+
+        columns = MonteCarloShieldSimulator(seed=42)
+        columns.add_layers(["Lead", "Steel"],
+                           thickness_cm=np.array([3.0, 2.0]),
+                           mu_total=np.array([0.77, 0.47]),
+                           mu_compton=np.array([0.58, 0.35]),
+                           mu_photoelectric=np.array([0.19, 0.12]),
+                           density_g_cm3=np.array([11.34, 7.85]))
+
+        assert columns.get_shield_info() == single.get_shield_info()
+        layers = columns.get_layers()
+        assert layers["material"] == ["Lead", "Steel"]
+        np.testing.assert_array_equal(layers["thickness_cm"], [3.0, 2.0])
+
+        a = single.run(source_energy_MeV=1.0, num_photons=20000)
+        b = columns.run(source_energy_MeV=1.0, num_photons=20000)
+        assert a.transmission_factor == b.transmission_factor
+
+    def test_add_layers_length_mismatch_raises_error(self):
+        """Test that layer columns of the wrong length are rejected."""
+        sim = MonteCarloShieldSimulator()
+        with pytest.raises(ValueError):
+            sim.add_layers(["Lead", "Steel"], [3.0], [0.77, 0.47], [0.58, 0.35],
+                           [0.19, 0.12], [11.34, 7.85])
+        assert sim.get_shield_info() == []
+
     def test_compare_with_analytical(self):
         """Test comparison with analytical model."""
         sim = MonteCarloShieldSimulator(seed=42)
@@ -199,6 +671,431 @@ class TestMonteCarloSimulator:
         assert result_large.uncertainty >= 0
 
 
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+class TestStreamingTally:
+    """Test the streaming tally accumulator."""
+
+    def test_moments_match_numpy(self):
+        """Test that streaming moments match a two-pass computation."""
+        from shield_lite._monte_carlo import StreamingTally
+
+        x = np.random.default_rng(0).exponential(2.0, size=5000)
+        tally = StreamingTally()
+        for value in x:
+            tally.add(value)
+
+        centered = x - x.mean()
+        assert tally.count == len(x)
+        assert tally.mean == pytest.approx(x.mean(), rel=1e-12)
+        assert tally.variance == pytest.approx(x.var(), rel=1e-10)
+        assert tally.skewness == pytest.approx(
+            np.mean(centered**3) / x.var()**1.5, rel=1e-8)
+
+    def test_merge_equals_single_pass(self):
+        """Test that merging partial tallies gives the single-pass tally."""
+        from shield_lite._monte_carlo import StreamingTally
+
+        x = np.random.default_rng(1).normal(1.0, 0.5, size=3000)
+        full, left, right = StreamingTally(), StreamingTally(), StreamingTally()
+        for i, value in enumerate(x):
+            full.add(value)
+            (left if i < 1000 else right).add(value)
+        left.merge(right)
+
+        assert left.count == full.count
+        assert left.mean == pytest.approx(full.mean, rel=1e-12)
+        assert left.variance == pytest.approx(full.variance, rel=1e-10)
+        assert left.kurtosis == pytest.approx(full.kurtosis, rel=1e-8)
+
+    def test_result_tally_consistent(self):
+        """Test that the result tally agrees with the scalar result fields."""
+        sim = MonteCarloShieldSimulator(seed=42)
+        sim.add_layer("Lead", 2.0, 0.77, 0.58, 0.19, 11.34)
+        result = sim.run(source_energy_MeV=1.0, num_photons=20000, num_threads=2)
+
+        tally = result.transmitted_tally
+        assert tally.count == result.transmitted_photons
+        assert tally.sum / result.total_photons == pytest.approx(result.dose_transmitted)
+        assert result.uncertainty == pytest.approx(tally.standard_error)
+        assert 0 < result.relative_uncertainty < 1
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+class TestResultCache:
+    """Test the persistent result cache."""
+
+    def test_cache_hit_returns_stored_result(self, tmp_path):
+        """Test that a cached run equals the first run of a fresh simulator."""
+        from shield_lite.core import ResultCache
+
+        cache = ResultCache(tmp_path)
+        fresh = lead_water_simulator(7).run(1.0, num_photons=20000, depth_bins=5)
+        first = lead_water_simulator(7).run(1.0, num_photons=20000, depth_bins=5, cache=cache)
+        hit = lead_water_simulator(7).run(1.0, num_photons=10000, depth_bins=5, cache=cache)
+
+        assert len(cache) == 1
+        assert first.transmission_factor == fresh.transmission_factor
+        assert hit.transmission_factor == fresh.transmission_factor
+        assert hit.total_photons == 20000
+        assert np.array_equal(hit.depth_dose, fresh.depth_dose)
+
+    def test_cache_tops_up_tally(self, tmp_path):
+        """Test that asking for more photons only runs the missing histories."""
+        from shield_lite.core import ResultCache
+
+        cache = ResultCache(tmp_path)
+        sim = lead_water_simulator(7, "philox")
+        sim.run(1.0, num_photons=12000, cache=cache)
+        topped_up = sim.run(1.0, num_photons=30000, cache=cache)
+        fresh = lead_water_simulator(7, "philox").run(1.0, num_photons=30000)
+
+        # One stream per history: the top-up replays the same histories
+        assert topped_up.total_photons == 30000
+        assert topped_up.transmitted_photons == fresh.transmitted_photons
+        assert topped_up.transmission_factor == pytest.approx(fresh.transmission_factor,
+                                                              rel=1e-12)
+
+    def test_cache_key_depends_on_configuration(self):
+        """Test that the key follows the shield and run parameters."""
+        from shield_lite.core import ResultCache
+
+        sim = lead_water_simulator(7)
+        key = ResultCache.key(sim.cache_config(1.0))
+        assert ResultCache.key(lead_water_simulator(7).cache_config(1.0)) == key
+        assert ResultCache.key(sim.cache_config(1.25)) != key
+        assert ResultCache.key(sim.cache_config(1.0, engine="batched")) != key
+        assert ResultCache.key(sim.cache_config(
+            1.0, variance_reduction=VarianceReduction(implicit_capture=True))) != key
+
+        sim.set_cross_sections("Lead", [0.1, 10.0], [5.0, 0.5], [1.0, 0.4], [4.0, 0.1])
+        assert ResultCache.key(sim.cache_config(1.0)) != key
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+class TestCheckpoint:
+    """Test checkpointed, resumable and split runs."""
+
+    def test_checkpointed_run_resumes_from_file(self, tmp_path):
+        """Test that a finished checkpoint is read back and matches run_tally."""
+        from shield_lite._monte_carlo import Checkpoint
+
+        path = tmp_path / "run.ckpt"
+        sim = lead_water_simulator(11, "philox")
+        result = sim.run_checkpointed(1.0, path, num_photons=30000, checkpoint_photons=8192)
+        checkpoint = Checkpoint.load(str(path))
+        assert checkpoint.complete and checkpoint.histories == 30000
+        assert Checkpoint.from_bytes(checkpoint.to_bytes()).next_history == 30000
+
+        again = lead_water_simulator(11, "philox").run_checkpointed(
+            1.0, path, num_photons=30000, checkpoint_photons=8192)
+        assert again.transmission_factor == result.transmission_factor
+        assert again.elapsed_seconds == result.elapsed_seconds
+
+        tally = sim.simulator.run_tally(1.0, 0, 30000)
+        direct = sim.simulator.summarize(tally, 30000, 1.0)
+        assert result.transmitted_photons == direct.transmitted_photons
+        assert result.transmission_factor == pytest.approx(direct.transmission_factor, rel=1e-12)
+
+    def test_merge_checkpoints_of_split_run(self, tmp_path):
+        """Test that disjoint ranges merge into the result of the whole range."""
+        paths = [tmp_path / f"node{k}.ckpt" for k in range(3)]
+        for k, path in enumerate(paths):
+            lead_water_simulator(11, "philox").run_checkpointed(1.0, path, num_photons=10000,
+                                                                first_history=k * 10000)
+        merged = lead_water_simulator(11, "philox").merge_checkpoints(paths[::-1])
+        whole = lead_water_simulator(11, "philox").run(1.0, num_photons=30000)
+
+        assert merged.total_photons == 30000
+        assert merged.transmitted_photons == whole.transmitted_photons
+        assert merged.transmission_factor == pytest.approx(whole.transmission_factor, rel=1e-12)
+
+        with pytest.raises(ValueError):
+            lead_water_simulator(11, "philox").merge_checkpoints([paths[0], paths[0]])
+
+    def test_checkpoint_of_other_configuration_raises_error(self, tmp_path):
+        """Test that a checkpoint is not resumed with another shield."""
+        path = tmp_path / "run.ckpt"
+        lead_water_simulator(11, "philox").run_checkpointed(1.0, path, num_photons=5000)
+        other = lead_water_simulator(11, "philox")
+        other.add_layer("Water", 5.0, 0.07, 0.06, 0.001, 1.0)
+        with pytest.raises(ValueError):
+            other.run_checkpointed(1.0, path, num_photons=5000)
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+class TestAsyncRun:
+    """Test background runs, progress and cancellation."""
+
+    def test_start_run_matches_run(self):
+        """Test that a background run gives the result of run."""
+        handle = lead_water_simulator(21).start_run(1.0, num_photons=50000, num_threads=2)
+        assert handle.wait(timeout=60)
+        result = handle.result()
+        direct = lead_water_simulator(21).run(1.0, num_photons=50000)
+
+        assert handle.done() and handle.histories_done == 50000
+        assert result.transmitted_photons == direct.transmitted_photons
+        assert result.transmission_factor == direct.transmission_factor
+        assert handle.relative_uncertainty == pytest.approx(result.relative_uncertainty, rel=1e-9)
+
+    def test_cancel_raises_run_cancelled(self):
+        """Test that a cancelled run stops early and raises RunCancelled."""
+        from shield_lite.core import RunCancelled
+
+        handle = lead_water_simulator(21).start_run(1.0, num_photons=2_000_000_000)
+        handle.cancel()
+        with pytest.raises(RunCancelled):
+            handle.result()
+        assert handle.done() and handle.histories_done < 2_000_000_000
+
+    def test_run_async_reports_progress(self):
+        """Test the asyncio wrapper and its progress callback."""
+        import asyncio
+
+        seen = []
+        result = asyncio.run(lead_water_simulator(21).run_async(
+            1.0, num_photons=200000, progress=lambda h: seen.append(h.histories_done),
+            poll_interval=0.001))
+
+        direct = lead_water_simulator(21).run(1.0, 200000)
+        assert result.transmitted_photons == direct.transmitted_photons
+        assert seen == sorted(seen) and seen[-1] == 200000
+
+    def test_cancelling_task_cancels_run(self):
+        """Test that cancelling the awaiting task stops the run."""
+        import asyncio
+
+        async def main():
+            task = asyncio.ensure_future(
+                lead_water_simulator(21).run_async(1.0, num_photons=2_000_000_000,
+                                                   poll_interval=0.01))
+            await asyncio.sleep(0.05)
+            task.cancel()
+            with pytest.raises(asyncio.CancelledError):
+                await task
+
+        asyncio.run(main())
+
+    def test_invalid_configuration_raises_before_start(self):
+        """Test that configuration errors are raised by start_run itself."""
+        with pytest.raises(ValueError):
+            MonteCarloShieldSimulator().start_run(1.0, num_photons=1000)
+        with pytest.raises(ValueError):
+            lead_water_simulator(21).start_run(1.0, num_photons=0)
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+class TestGpuEngine:
+    """Test the CUDA transport backend."""
+
+    def test_gpu_engine_requires_device_and_philox(self):
+        """Test that the GPU engine is refused where it cannot run."""
+        from shield_lite.core import gpu_available
+
+        with pytest.raises(ValueError):
+            lead_water_simulator(3, "mt19937").run(1.0, num_photons=1000, engine="gpu")
+        if not gpu_available():
+            with pytest.raises(ValueError):
+                lead_water_simulator(3, "philox").run(1.0, num_photons=1000, engine="gpu")
+
+    def test_run_batch_gpu_requires_device_and_philox(self):
+        """Test that run_batch refuses the GPU engine up front, before any worker starts."""
+        from shield_lite.core import gpu_available
+
+        materials = [{'material_name': 'Lead', 'mu_total': 0.77, 'mu_compton': 0.58,
+                      'mu_photoelectric': 0.19, 'density_g_cm3': 11.34}]
+        args = ([0, 1, 2, 3], [0, 0, 0], [1.0, 2.0, 3.0], 1.0, 20000)
+        with pytest.raises(ValueError):
+            lead_water_simulator(3, "mt19937").run_batch(*args, materials=materials,
+                                                         num_threads=4, engine="gpu")
+        if not gpu_available():
+            with pytest.raises(ValueError):
+                lead_water_simulator(3, "philox").run_batch(*args, materials=materials,
+                                                            num_threads=4, engine="gpu")
+
+    def test_gpu_follows_scalar_histories(self):
+        """Test that the device runs the histories of the scalar Philox engine."""
+        from shield_lite.core import gpu_available
+        from shield_lite._monte_carlo import MeshTallies, TransportEngine
+
+        if not gpu_available():
+            pytest.skip("No CUDA device or module built without SHIELD_LITE_CUDA")
+        sim = lead_water_simulator(3, "philox")
+        mesh = MeshTallies(8, 8)
+        gpu = sim.simulator.summarize(
+            sim.simulator.run_tally(1.0, 0, 200000, engine=TransportEngine.GPU, mesh_tallies=mesh),
+            200000, 1.0)
+        scalar = sim.simulator.summarize(
+            sim.simulator.run_tally(1.0, 0, 200000, mesh_tallies=mesh), 200000, 1.0)
+
+        # Device math may round differently and flip a rare history
+        assert abs(gpu.transmitted_photons - scalar.transmitted_photons) <= 5
+        assert gpu.transmission_factor == pytest.approx(scalar.transmission_factor, rel=1e-3)
+        assert gpu.dose_absorbed == pytest.approx(scalar.dose_absorbed, rel=1e-3)
+        np.testing.assert_allclose(gpu.depth_dose, scalar.depth_dose, rtol=1e-2)
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+class TestSecondaryParticles:
+    """Test the annihilation and fluorescence photons of the secondary bank."""
+
+    @pytest.mark.parametrize("rng", ["mt19937", "philox"])
+    def test_other_materials_unchanged(self, rng):
+        """Test that secondary physics of an unused material leaves the histories as they were."""
+        reference = lead_water_simulator(11, rng, energy_MeV=2.0).run(2.0, num_photons=20000)
+        sim = lead_water_simulator(11, rng, energy_MeV=2.0)
+        sim.set_secondary_physics("Steel", pair_mu=0.03)
+        result = sim.run(2.0, num_photons=20000)
+
+        assert result.transmission_factor == reference.transmission_factor
+        assert result.dose_absorbed == reference.dose_absorbed
+
+    def test_annihilation_and_fluorescence_lines(self):
+        """Test that the 0.511 MeV and K-alpha lines appear in the transmitted spectrum."""
+        reference = lead_water_simulator(11, energy_MeV=2.0).run(2.0, num_photons=50000,
+                                                                 spectrum_bins=40)
+        sim = lead_water_simulator(11, energy_MeV=2.0)
+        sim.set_secondary_physics("Lead", pair_mu=0.06, fluorescence_yield=0.77,
+                                  fluorescence_energy_MeV=0.075)
+        result = sim.run(2.0, num_photons=50000, spectrum_bins=40)
+
+        # Bins of 0.05 MeV: [0.5, 0.55) holds the annihilation line, [0.05, 0.1) K-alpha
+        assert result.secondary_spectrum.shape == (40,)
+        assert result.secondary_spectrum[10] > 0.5 * result.secondary_spectrum.max()
+        assert result.secondary_spectrum[1] > 0.5 * result.secondary_spectrum.max()
+        assert result.secondary_spectrum.sum() == pytest.approx(result.secondary_transmission,
+                                                                rel=1e-12)
+        assert reference.secondary_transmission == 0.0
+        assert reference.secondary_spectrum.size == 0
+        # Secondaries carry absorbed energy out of the shield, in their own tallies:
+        # the source photon results keep their meaning
+        assert result.secondary_dose_transmitted > 0
+        assert result.dose_absorbed < reference.dose_absorbed
+        assert result.spectrum.sum() == pytest.approx(result.transmission_factor, rel=1e-12)
+        sigma = np.hypot(result.transmission_uncertainty, reference.transmission_uncertainty)
+        assert abs(result.transmission_factor - reference.transmission_factor) < 4 * sigma
+
+    def test_secondaries_counted(self):
+        """Test that emitted secondaries are counted when instrumented."""
+        from shield_lite._monte_carlo import INSTRUMENTED
+
+        sim = lead_water_simulator(11, energy_MeV=2.0)
+        sim.set_secondary_physics("Lead", pair_mu=0.06)
+        stats = sim.run(2.0, num_photons=20000).stats
+
+        if INSTRUMENTED:
+            assert stats.secondaries > 0
+            assert stats.secondaries % 2 == 0
+            assert stats.bank_overflows == 0
+        else:
+            assert stats.secondaries == 0
+
+    def test_scalar_engine_only(self):
+        """Test that the batched engine and run_batch refuse secondaries."""
+        sim = lead_water_simulator(11, energy_MeV=2.0)
+        sim.set_secondary_physics("Lead", fluorescence_yield=0.77, fluorescence_energy_MeV=0.075)
+
+        with pytest.raises(ValueError):
+            sim.run(2.0, num_photons=1000, engine="batched")
+        materials = [{'material_name': 'Lead', 'mu_total': 0.52, 'mu_compton': 0.40,
+                      'mu_photoelectric': 0.12, 'density_g_cm3': 11.34}]
+        with pytest.raises(ValueError):
+            sim.run_batch([0, 1], [0], [1.0], 2.0, 1000, materials=materials, engine="batched")
+        assert sim.run_batch([0, 1], [0], [1.0], 2.0, 1000,
+                             materials=materials)['total_photons'][0] == 1000
+
+    def test_invalid_parameters(self):
+        """Test that out-of-range secondary physics is rejected."""
+        sim = lead_water_simulator(11, energy_MeV=2.0)
+        with pytest.raises(ValueError):
+            sim.set_secondary_physics("Lead", pair_mu=-0.1)
+        with pytest.raises(ValueError):
+            sim.set_secondary_physics("Lead", fluorescence_yield=1.5, fluorescence_energy_MeV=0.075)
+        with pytest.raises(ValueError):
+            sim.set_secondary_physics("Lead", fluorescence_yield=0.5)
+
+    def test_cache_key_and_rebuild(self):
+        """Test that secondary physics is part of the cache key and survives a rebuild."""
+        from shield_lite.core import ResultCache
+        from shield_lite.core.distributed import simulator_from_config
+
+        sim = lead_water_simulator(11, energy_MeV=2.0)
+        key = ResultCache.key(sim.cache_config(2.0))
+        sim.set_secondary_physics("Steel", pair_mu=0.03)
+        assert ResultCache.key(sim.cache_config(2.0)) == key
+        sim.set_secondary_physics("Lead", pair_mu=0.06)
+        config = sim.cache_config(2.0)
+        assert ResultCache.key(config) != key
+
+        rebuilt = simulator_from_config(config)
+        assert rebuilt.cache_config(2.0) == config
+        assert (rebuilt.run(2.0, num_photons=5000).transmission_factor
+                == sim.run(2.0, num_photons=5000).transmission_factor)
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+class TestDistributedRun:
+    """Test runs split over worker pools."""
+
+    def test_process_pool_matches_single_process(self):
+        """Test that a run over processes matches the same histories in one process."""
+        from shield_lite._monte_carlo import MeshTallies
+
+        result = lead_water_simulator(5).run(1.0, num_photons=50000, processes=2, depth_bins=8)
+        sim = lead_water_simulator(5)
+        direct = sim.simulator.summarize(
+            sim.simulator.run_tally(1.0, 0, 50000, mesh_tallies=MeshTallies(8, 0)), 50000, 1.0)
+
+        assert result.total_photons == 50000
+        assert result.transmitted_photons == direct.transmitted_photons
+        assert result.collisions == direct.collisions
+        assert result.transmission_factor == pytest.approx(direct.transmission_factor, rel=1e-12)
+        np.testing.assert_allclose(result.depth_dose, direct.depth_dose, rtol=1e-12)
+
+    def test_result_does_not_depend_on_worker_count(self):
+        """Test that any executor and worker count give the same result."""
+        from concurrent.futures import ThreadPoolExecutor
+
+        with ThreadPoolExecutor(max_workers=3) as executor:
+            threaded = lead_water_simulator(5).run(1.0, num_photons=40000, executor=executor)
+        single = lead_water_simulator(5).run(1.0, num_photons=40000, processes=1)
+
+        assert threaded.transmitted_photons == single.transmitted_photons
+        assert threaded.dose_transmitted == pytest.approx(single.dose_transmitted, rel=1e-12)
+
+    def test_workers_sizes_the_split(self):
+        """Test that an executor run is split by the given worker count."""
+        from concurrent.futures import ThreadPoolExecutor
+        from shield_lite.core.distributed import CHUNK_PHOTONS, RANGES_PER_WORKER
+
+        class CountingExecutor(ThreadPoolExecutor):
+            submitted = 0
+
+            def submit(self, fn, *args, **kwargs):
+                self.submitted += 1
+                return super().submit(fn, *args, **kwargs)
+
+        n = 16 * CHUNK_PHOTONS
+        with CountingExecutor(max_workers=1) as executor:
+            result = lead_water_simulator(5).run(1.0, num_photons=n, executor=executor, workers=2)
+        single = lead_water_simulator(5).run(1.0, num_photons=n, processes=1)
+
+        assert executor.submitted == 2 * RANGES_PER_WORKER
+        assert result.transmitted_photons == single.transmitted_photons
+
+    def test_cache_top_up_over_processes(self, tmp_path):
+        """Test that the missing histories of a cached run can be run in parallel."""
+        from shield_lite.core import ResultCache
+
+        cache = ResultCache(tmp_path)
+        lead_water_simulator(5).run(1.0, num_photons=20000, cache=cache)
+        topped_up = lead_water_simulator(5).run(1.0, num_photons=40000, cache=cache, processes=2)
+        single = lead_water_simulator(5).run(1.0, num_photons=40000, processes=1)
+
+        assert topped_up.total_photons == 40000
+        assert topped_up.transmitted_photons == single.transmitted_photons
+
+
 @pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
 class TestHelperFunctions:
     """Test helper functions."""
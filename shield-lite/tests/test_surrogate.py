@@ -0,0 +1,121 @@
+import numpy as np
+import pytest
+
+try:
+    from shield_lite.core.surrogate import SurrogateModel
+    from shield_lite.core import MonteCarloShieldSimulator
+    MONTE_CARLO_AVAILABLE = True
+except ImportError:
+    MONTE_CARLO_AVAILABLE = False
+
+MATERIALS = {
+    'Lead': {'mu_total': 0.77, 'mu_compton': 0.58, 'mu_photoelectric': 0.19,
+             'density_g_cm3': 11.34},
+    'Water': {'mu_total': 0.07, 'mu_compton': 0.06, 'mu_photoelectric': 0.001,
+              'density_g_cm3': 1.0},
+}
+MAX_LAYERS = 3
+
+
+def beer_lambert_model(bias=(0.0, 0.0), upper_energy=2.0):
+    """Linear members predicting ln T = -sum(mu t) (+ bias), two members."""
+    n_features = 1 + MAX_LAYERS * len(MATERIALS)
+    weights = np.zeros((1, n_features))
+    for slot in range(MAX_LAYERS):
+        for channel, props in enumerate(MATERIALS.values()):
+            weights[0, 1 + slot * len(MATERIALS) + channel] = -props['mu_total']
+    members = [[(weights, np.array([b]))] for b in bias]
+    upper = np.full(n_features, 20.0)
+    upper[0] = upper_energy
+    return SurrogateModel(MATERIALS, MAX_LAYERS, np.zeros(n_features), np.ones(n_features),
+                          np.zeros(n_features), upper, members)
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_predict_skips_empty_layers():
+    model = beer_lambert_model()
+    transmission, spread, novel = model.predict(
+        [1.0, 1.0, 1.0], [0, 3, 4, 8],
+        ['Lead', 'Water', 'Lead', 'Water', 'Lead', 'Water', 'Lead', 'Water'],
+        [1.0, 0.0, 2.0, 5.0, 1.0, 1.0, 1.0, 1.0])
+
+    assert transmission[0] == pytest.approx(np.exp(-0.77 * 3.0))
+    assert transmission[1] == pytest.approx(np.exp(-0.07 * 5.0))
+    assert np.all(spread == 0.0)
+    # Four layers of positive thickness do not fit in three slots
+    assert list(novel) == [False, False, True]
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_fallback_runs_monte_carlo():
+    model = beer_lambert_model()
+    fallbacks = []
+    estimate = model.estimate([1.0, 3.0], [0, 1, 2], ['Lead', 'Lead'], [2.0, 2.0],
+                              num_photons=5000, on_fallback=fallbacks.append, seed=7)
+
+    # Energy 3 MeV is outside the training range: simulated
+    assert list(estimate['fallback']) == [False, True]
+    direct = MonteCarloShieldSimulator(seed=7).run_batch(
+        [0, 1], [0], [2.0], [3.0], 5000, materials=[dict(MATERIALS['Lead'], material_name='Lead')])
+    assert estimate['transmission'][1] == direct['transmission_factor'][0]
+    assert len(fallbacks) == 1
+    assert list(fallbacks[0]['layer_offsets']) == [0, 1]
+    assert fallbacks[0]['results']['total_photons'][0] == 5000
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_uncertainty_threshold():
+    model = beer_lambert_model(bias=(-0.1, 0.1))
+    args = ([1.0], [0, 1], ['Water'], [3.0])
+
+    _, spread, _ = model.predict(*args)
+    assert spread[0] == pytest.approx(np.sqrt(0.02))
+    assert not model.estimate(*args, max_uncertainty=1.0)['fallback'][0]
+    assert model.estimate(*args, max_uncertainty=0.1, num_photons=1000)['fallback'][0]
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_unknown_material_needs_properties():
+    model = beer_lambert_model()
+    with pytest.raises(ValueError):
+        model.estimate([1.0], [0, 1], ['Steel'], [1.0], num_photons=1000)
+
+    steel = {'mu_total': 0.47, 'mu_compton': 0.35, 'mu_photoelectric': 0.12, 'density_g_cm3': 7.85}
+    estimate = model.estimate([1.0], [0, 1], ['Steel'], [1.0], num_photons=1000,
+                              materials={'Steel': steel})
+    assert estimate['fallback'][0]
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_save_load_round_trip(tmp_path):
+    model = beer_lambert_model(bias=(-0.1, 0.1))
+    model.save(tmp_path / "surrogate.npz")
+    loaded = SurrogateModel.load(tmp_path / "surrogate.npz")
+
+    args = ([0.5, 1.5], [0, 2, 3], ['Lead', 'Water', 'Water'], [1.0, 2.0, 4.0])
+    for a, b in zip(model.predict(*args), loaded.predict(*args)):
+        np.testing.assert_array_equal(a, b)
+    assert loaded.materials == model.materials
+
+
+@pytest.mark.skipif(not MONTE_CARLO_AVAILABLE, reason="Monte Carlo module not compiled")
+def test_grid_search_with_surrogate_matches_batched():
+    from shield_lite.core.shield import Material, Source
+    from shield_lite.optimization.grid_search import grid_search
+
+    materials_db = {name: Material(name=name, mu=p['mu_total'], density=p['density_g_cm3'])
+                    for name, p in MATERIALS.items()}
+    order = ['Lead', 'Water']
+    ranges_mm = {'Lead': '0..50..5', 'Water': '0..200..20'}
+    source = Source(intensity=100.0, energy_MeV=1.0)
+
+    batched = grid_search(order, ranges_mm, materials_db, source, Dmax=1.0, topk=5,
+                          vectorized=True)
+    estimated = grid_search(order, ranges_mm, materials_db, source, Dmax=1.0, topk=5,
+                            surrogate=beer_lambert_model())
+
+    assert len(estimated) == len(batched)
+    for ref, res in zip(batched, estimated):
+        assert res['thicknesses'] == ref['thicknesses']
+        assert res['dose'] == pytest.approx(ref['dose'])
+        assert not res['fallback']